@@ -25,11 +25,15 @@
 
 #include "core/gimp.h"
 
+#include "paint/gimppaintcore-replay.h"
+
 #include "widgets/gimpactiongroup.h"
 
 #include "debug-actions.h"
 #include "debug-commands.h"
 
+#include "gimp-trace.h"
+
 
 #ifdef ENABLE_DEBUG_MENU
 
@@ -69,6 +73,23 @@ static const GimpActionEntry debug_actions[] =
     NULL }
 };
 
+static const GimpToggleActionEntry debug_toggle_actions[] =
+{
+  { "debug-trace", NULL,
+    "Record _Trace", NULL,
+    "Record a performance trace in the Chrome trace event format",
+    G_CALLBACK (debug_trace_cmd_callback),
+    FALSE,
+    NULL },
+
+  { "debug-record-strokes", NULL,
+    "Record _Strokes", NULL,
+    "Record the coordinates of paint strokes, to replay them as a benchmark",
+    G_CALLBACK (debug_record_strokes_cmd_callback),
+    FALSE,
+    NULL }
+};
+
 #endif
 
 void
@@ -78,6 +99,10 @@ debug_actions_setup (GimpActionGroup *group)
   gimp_action_group_add_actions (group, NULL,
                                  debug_actions,
                                  G_N_ELEMENTS (debug_actions));
+
+  gimp_action_group_add_toggle_actions (group, NULL,
+                                        debug_toggle_actions,
+                                        G_N_ELEMENTS (debug_toggle_actions));
 #endif
 }
 
@@ -85,4 +110,10 @@ void
 debug_actions_update (GimpActionGroup *group,
                       gpointer         data)
 {
+#ifdef ENABLE_DEBUG_MENU
+  gimp_action_group_set_action_active (group, "debug-trace",
+                                       gimp_trace_active);
+  gimp_action_group_set_action_active (group, "debug-record-strokes",
+                                       gimp_paint_core_is_recording ());
+#endif
 }
@@ -39,6 +39,8 @@
 
 #include "gegl/gimp-gegl-utils.h"
 
+#include "paint/gimppaintcore-replay.h"
+
 #include "display/gimpdisplay.h"
 #include "display/gimpdisplayshell.h"
 #include "display/gimpimagewindow.h"
@@ -52,9 +54,29 @@
 #include "actions.h"
 #include "debug-commands.h"
 
+#include "gimp-trace.h"
+
 
 #ifdef ENABLE_DEBUG_MENU
 
+typedef struct _DebugRecording DebugRecording;
+
+struct _DebugRecording
+{
+  const gchar  *name;
+  const gchar  *prefix;
+  const gchar  *extension;
+
+  gboolean   (* is_active) (void);
+  void       (* start)     (const gchar  *filename);
+  gboolean   (* stop)      (const gchar  *filename,
+                            GError      **error);
+
+  gint          n_recordings;
+  gchar        *filename;
+};
+
+
 /*  local function prototypes  */
 
 static gboolean  debug_show_image_graph        (GimpImage   *source_image);
@@ -72,6 +94,38 @@ static gboolean  debug_accel_find_func         (GtkAccelKey *key,
                                                 GClosure    *closure,
                                                 gpointer     data);
 
+static gboolean  debug_trace_is_active         (void);
+static void      debug_trace_start             (const gchar *filename);
+static gboolean  debug_trace_stop              (const gchar *filename,
+                                                GError     **error);
+static void      debug_strokes_start           (const gchar *filename);
+static gboolean  debug_strokes_stop            (const gchar *filename,
+                                                GError     **error);
+
+static void      debug_toggle_recording        (GtkAction      *action,
+                                                Gimp           *gimp,
+                                                DebugRecording *recording);
+
+
+/*  The recordings started and stopped by the debug toggle actions,
+ *  each is written to a new file in the temporary directory.
+ */
+static DebugRecording debug_trace_recording =
+{
+  "Trace", "gimp-trace", "json",
+  debug_trace_is_active,
+  debug_trace_start,
+  debug_trace_stop
+};
+
+static DebugRecording debug_strokes_recording =
+{
+  "Strokes", "gimp-strokes", "txt",
+  gimp_paint_core_is_recording,
+  debug_strokes_start,
+  debug_strokes_stop
+};
+
 
 /*  public functions  */
 
@@ -269,6 +323,26 @@ debug_dump_attached_data_cmd_callback (GtkAction *action,
   debug_print_qdata (GIMP_OBJECT (user_context));
 }
 
+void
+debug_trace_cmd_callback (GtkAction *action,
+                          gpointer   data)
+{
+  Gimp *gimp;
+  return_if_no_gimp (gimp, data);
+
+  debug_toggle_recording (action, gimp, &debug_trace_recording);
+}
+
+void
+debug_record_strokes_cmd_callback (GtkAction *action,
+                                   gpointer   data)
+{
+  Gimp *gimp;
+  return_if_no_gimp (gimp, data);
+
+  debug_toggle_recording (action, gimp, &debug_strokes_recording);
+}
+
 
 /*  private functions  */
 
@@ -403,5 +477,94 @@ debug_accel_find_func (GtkAccelKey *key,
   return (GClosure *) data == closure;
 }
 
+static gboolean
+debug_trace_is_active (void)
+{
+  return gimp_trace_active;
+}
+
+static void
+debug_trace_start (const gchar *filename)
+{
+  gimp_trace_start (filename);
+}
+
+static gboolean
+debug_trace_stop (const gchar  *filename,
+                  GError      **error)
+{
+  return gimp_trace_stop (error);
+}
+
+static void
+debug_strokes_start (const gchar *filename)
+{
+  gimp_paint_core_record_start ();
+}
+
+static gboolean
+debug_strokes_stop (const gchar  *filename,
+                    GError      **error)
+{
+  GPtrArray *strokes = gimp_paint_core_record_stop ();
+  gboolean   success;
+
+  success = gimp_paint_core_recording_save (strokes, filename, error);
+
+  g_ptr_array_unref (strokes);
+
+  return success;
+}
+
+/*  starts or stops @recording to match the state of the toggle
+ *  @action, and reports where a stopped recording was written to
+ */
+static void
+debug_toggle_recording (GtkAction      *action,
+                        Gimp           *gimp,
+                        DebugRecording *recording)
+{
+  gboolean active;
+
+  active = gtk_toggle_action_get_active (GTK_TOGGLE_ACTION (action));
+
+  if (active == recording->is_active ())
+    return;
+
+  if (active)
+    {
+      gchar *basename;
+
+      basename = g_strdup_printf ("%s-%d-%d.%s",
+                                  recording->prefix, gimp_get_pid (),
+                                  ++recording->n_recordings,
+                                  recording->extension);
+
+      g_free (recording->filename);
+      recording->filename = g_build_filename (g_get_tmp_dir (), basename,
+                                              NULL);
+      g_free (basename);
+
+      recording->start (recording->filename);
+    }
+  else
+    {
+      GError *error = NULL;
+
+      if (recording->stop (recording->filename, &error))
+        {
+          gimp_message (gimp, NULL, GIMP_MESSAGE_INFO,
+                        "%s written to '%s'", recording->name,
+                        gimp_filename_to_utf8 (recording->filename));
+        }
+      else
+        {
+          gimp_message_literal (gimp, NULL, GIMP_MESSAGE_ERROR,
+                                error->message);
+          g_clear_error (&error);
+        }
+    }
+}
+
 
 #endif /* ENABLE_DEBUG_MENU */
@@ -66,6 +66,7 @@
 #include "units.h"
 #include "language.h"
 #include "gimp-debug.h"
+#include "gimp-trace.h"
 
 #include "gimp-intl.h"
 
@@ -132,6 +133,7 @@ app_run (const gchar         *full_prog_name,
          const gchar         *session_name,
          const gchar         *batch_interpreter,
          const gchar        **batch_commands,
+         gboolean             batch_daemon,
          gboolean             as_new,
          gboolean             no_interface,
          gboolean             no_data,
@@ -246,6 +248,9 @@ app_run (const gchar         *full_prog_name,
 
   batch_run (gimp, batch_interpreter, batch_commands);
 
+  if (batch_daemon)
+    batch_daemon_run (gimp, batch_interpreter);
+
   loop = g_main_loop_new (NULL, FALSE);
 
   g_signal_connect_after (gimp, "exit",
@@ -286,6 +291,8 @@ app_exit_after_callback (Gimp      *gimp,
   if (gimp->be_verbose)
     g_print ("EXIT: %s\n", G_STRFUNC);
 
+  gimp_trace_exit ();
+
   /*
    *  In stable releases, we simply call exit() here. This speeds up
    *  the process of quitting GIMP and also works around the problem
@@ -27,6 +27,8 @@
 #include "tile-rowhints.h"
 #include "tile-private.h"
 
+#include "gimp-trace.h"
+
 
 #define IDLE_SWAPPER_START              1000
 #define IDLE_SWAPPER_INTERVAL_MS        20
@@ -43,6 +45,8 @@ typedef struct _TileList
 static guint64       cur_cache_size   = 0;
 static guint64       max_cache_size   = 0;
 static guint64       cur_cache_dirty  = 0;
+static guint64       cache_hits       = 0;
+static guint64       cache_misses     = 0;
 static TileList      tile_list        = { NULL, NULL };
 static guint         idle_swapper     = 0;
 static guint         idle_delay       = 0;
@@ -200,6 +204,8 @@ tile_cache_insert (Tile *tile)
 #endif
 
       cur_cache_size += tile->size;
+
+      GIMP_TRACE_COUNTER ("tile-cache", "cache-size", cur_cache_size);
     }
 
   /* Put the tile at the end of the proper list */
@@ -252,6 +258,29 @@ tile_cache_flush (Tile *tile)
   TILE_CACHE_UNLOCK;
 }
 
+/*  like tile_cache_flush(), for tiles which are being locked, counts
+ *  the tile as a hit if its data was in the cache, or as a miss if it
+ *  has to be swapped in
+ */
+void
+tile_cache_acquire (Tile *tile)
+{
+  TILE_CACHE_LOCK;
+
+  if (tile->cached)
+    {
+      cache_hits++;
+
+      tile_cache_flush_internal (tile);
+    }
+  else if (! tile->data && tile->swap_offset != -1)
+    {
+      cache_misses++;
+    }
+
+  TILE_CACHE_UNLOCK;
+}
+
 void
 tile_cache_set_size (guint64 cache_size)
 {
@@ -269,6 +298,24 @@ tile_cache_set_size (guint64 cache_size)
   TILE_CACHE_UNLOCK;
 }
 
+void
+tile_cache_get_stats (guint64 *cache_size,
+                      guint64 *max_size,
+                      guint64 *dirty_size,
+                      guint64 *hits,
+                      guint64 *misses)
+{
+  TILE_CACHE_LOCK;
+
+  if (cache_size) *cache_size = cur_cache_size;
+  if (max_size)   *max_size   = max_cache_size;
+  if (dirty_size) *dirty_size = cur_cache_dirty;
+  if (hits)       *hits       = cache_hits;
+  if (misses)     *misses     = cache_misses;
+
+  TILE_CACHE_UNLOCK;
+}
+
 static void
 tile_cache_flush_internal (Tile *tile)
 {
@@ -280,6 +327,8 @@ tile_cache_flush_internal (Tile *tile)
 
   cur_cache_size -= tile->size;
 
+  GIMP_TRACE_COUNTER ("tile-cache", "cache-size", cur_cache_size);
+
   if (tile->next)
     tile->next->prev = tile->prev;
   else
@@ -19,13 +19,20 @@
 #define __TILE_CACHE_H__
 
 
-void   tile_cache_init                 (guint64 cache_size);
+void   tile_cache_init                 (guint64  cache_size);
 void   tile_cache_exit                 (void);
 
-void   tile_cache_set_size             (guint64 cache_size);
+void   tile_cache_set_size             (guint64  cache_size);
 void   tile_cache_suspend_idle_swapper (void);
 
-void   tile_cache_insert               (Tile   *tile);
-void   tile_cache_flush                (Tile   *tile);
+void   tile_cache_insert               (Tile    *tile);
+void   tile_cache_flush                (Tile    *tile);
+void   tile_cache_acquire              (Tile    *tile);
+
+void   tile_cache_get_stats            (guint64 *cache_size,
+                                        guint64 *max_size,
+                                        guint64 *dirty_size,
+                                        guint64 *hits,
+                                        guint64 *misses);
 
 #endif /* __TILE_CACHE_H__ */
@@ -33,6 +33,7 @@
 
 
 static void  tile_manager_allocate_tiles (TileManager *tm);
+static Tile *tile_manager_copy_tile      (Tile        *tile);
 
 #ifdef TILE_PROFILING
 extern gint tile_exist_peak;
@@ -178,7 +179,16 @@ tile_manager_duplicate (TileManager *tm)
       Tile *tile;
 
       tile = tile_manager_get (tm, i, TRUE, FALSE);
-      tile_manager_map (copy, i, tile);
+
+      /*  a tile that is locked for writing may be modified through
+       *  its data pointer at any time (GEGL holds on to it directly),
+       *  so it can't be shared and has to be copied right away
+       */
+      if (tile->write_count > 0)
+        tile_manager_map (copy, i, tile_manager_copy_tile (tile));
+      else
+        tile_manager_map (copy, i, tile);
+
       tile_release (tile, FALSE);
     }
 
@@ -254,39 +264,7 @@ tile_manager_get (TileManager *tm,
           if (tile->share_count > 1)
             {
               /* Copy-on-write required */
-              Tile *new = tile_new (tile->bpp);
-
-              new->ewidth  = tile->ewidth;
-              new->eheight = tile->eheight;
-              new->valid   = tile->valid;
-
-              new->size    = new->ewidth * new->eheight * new->bpp;
-              new->data    = g_new (guchar, new->size);
-
-#ifdef TILE_PROFILING
-              tile_exist_count++;
-              if (tile_exist_count > tile_exist_peak)
-                tile_exist_peak = tile_exist_count;
-#endif
-
-              if (tile->rowhint)
-                {
-                  tile_allocate_rowhints (new);
-
-                  memcpy (new->rowhint, tile->rowhint,
-                          new->eheight * sizeof (TileRowHint));
-                }
-
-              if (tile->data)
-                {
-                  memcpy (new->data, tile->data, new->size);
-                }
-              else
-                {
-                  tile_lock (tile);
-                  memcpy (new->data, tile->data, new->size);
-                  tile_release (tile, FALSE);
-                }
+              Tile *new = tile_manager_copy_tile (tile);
 
               tile_detach (tile, tm, tile_num);
               tile_attach (new, tm, tile_num);
@@ -392,6 +370,49 @@ tile_manager_allocate_tiles (TileManager *tm)
   tm->tiles = tiles;
 }
 
+/*  creates an unattached copy of @tile, including its pixel data
+ *  and row hints
+ */
+static Tile *
+tile_manager_copy_tile (Tile *tile)
+{
+  Tile *new = tile_new (tile->bpp);
+
+  new->ewidth  = tile->ewidth;
+  new->eheight = tile->eheight;
+  new->valid   = tile->valid;
+
+  new->size    = new->ewidth * new->eheight * new->bpp;
+  new->data    = g_new (guchar, new->size);
+
+#ifdef TILE_PROFILING
+  tile_exist_count++;
+  if (tile_exist_count > tile_exist_peak)
+    tile_exist_peak = tile_exist_count;
+#endif
+
+  if (tile->rowhint)
+    {
+      tile_allocate_rowhints (new);
+
+      memcpy (new->rowhint, tile->rowhint,
+              new->eheight * sizeof (TileRowHint));
+    }
+
+  if (tile->data)
+    {
+      memcpy (new->data, tile->data, new->size);
+    }
+  else
+    {
+      tile_lock (tile);
+      memcpy (new->data, tile->data, new->size);
+      tile_release (tile, FALSE);
+    }
+
+  return new;
+}
+
 static void
 tile_manager_invalidate_tile (TileManager  *tm,
                               gint          tile_num)
@@ -589,24 +610,32 @@ tile_manager_get_memsize (const TileManager *tm,
   memsize += (gint64) tm->ntile_rows * tm->ntile_cols * (sizeof (Tile) +
                                                          sizeof (gpointer));
 
-  /*  the memory allocated for the tiles  */
-  if (sparse)
+  /*  the memory allocated for the tiles, tiles shared with other
+   *  tile managers are accounted for in equal parts
+   */
+  if (tm->tiles)
     {
-      if (tm->tiles)
-        {
-          Tile   **tiles = tm->tiles;
-          gint64   size  = TILE_WIDTH * TILE_HEIGHT * tm->bpp;
-          gint     i, j;
+      Tile   **tiles = tm->tiles;
+      gint64   size  = TILE_WIDTH * TILE_HEIGHT * tm->bpp;
+      gint     i, j;
+
+      for (i = 0; i < tm->ntile_rows; i++)
+        for (j = 0; j < tm->ntile_cols; j++, tiles++)
+          {
+            Tile *tile = *tiles;
 
-          for (i = 0; i < tm->ntile_rows; i++)
-            for (j = 0; j < tm->ntile_cols; j++, tiles++)
+            if (sparse)
               {
-                if (tile_is_valid (*tiles))
-                  memsize += size;
+                if (tile_is_valid (tile))
+                  memsize += size / MAX (tile->share_count, 1);
               }
-        }
+            else
+              {
+                memsize += tile->size / MAX (tile->share_count, 1);
+              }
+          }
     }
-  else
+  else if (! sparse)
     {
       memsize += (gint64) tm->width * tm->height * tm->bpp;
     }
@@ -17,7 +17,7 @@
 
 #include "config.h"
 
-#include <glib-object.h>
+#include <gegl.h>
 
 #include "base-types.h"
 
@@ -35,12 +35,18 @@ struct _TilePyramid
   guint          height;
   gint           bytes;
   TileManager   *tiles[PYRAMID_MAX_LEVELS];
+  TileManager   *display_base;
+  const Babl    *display_fish;
   gint           top_level;
+  gboolean       external_base;
 };
 
 
 static gint  tile_pyramid_alloc_levels        (TilePyramid *pyramid,
                                                gint         top_level);
+static void  tile_pyramid_validate_display_tile (TileManager *tm,
+                                                 Tile        *tile,
+                                                 TilePyramid *pyramid);
 static void  tile_pyramid_validate_tile       (TileManager *tm,
                                                Tile        *tile,
                                                TileManager *tm_below);
@@ -59,13 +65,20 @@ static void  tile_pyramid_write_upper_quarter (Tile        *dest,
 
 /**
  * tile_pyramid_new:
- * @bytes:  foo
- * @width:  bottom level width
- * @height: bottom level height
+ * @format:         format of the bottom level
+ * @display_format: 8-bit format of the levels used for display
+ * @width:          bottom level width
+ * @height:         bottom level height
  *
  * Creates a new #TilePyramid, managing a set of tile-managers where
  * each level is a sized-down version of the level below.
  *
+ * The bottom level keeps the pixels in @format, which can have a
+ * higher precision than @display_format. All other levels, and a
+ * copy of the bottom level that is only filled for the tiles that
+ * are actually displayed, are stored in @display_format, so the
+ * conversion to 8 bits happens once per tile.
+ *
  * This only works correctly if you set a validate procedure using
  * tile_pyramid_set_validate_proc() and invalidate areas. With some
  * small changes, it could be made to work for non-validating tile
@@ -77,22 +90,68 @@ static void  tile_pyramid_write_upper_quarter (Tile        *dest,
  * Return value: a newly allocate #TilePyramid
  **/
 TilePyramid *
-tile_pyramid_new (gint bytes,
-                  gint width,
-                  gint height)
+tile_pyramid_new (const Babl *format,
+                  const Babl *display_format,
+                  gint        width,
+                  gint        height)
 {
   TilePyramid *pyramid;
 
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (display_format != NULL, NULL);
   g_return_val_if_fail (width > 0, NULL);
   g_return_val_if_fail (height > 0, NULL);
 
   pyramid = g_slice_new0 (TilePyramid);
 
-  pyramid->bytes  = bytes;
+  pyramid->bytes  = babl_format_get_bytes_per_pixel (display_format);
   pyramid->width  = width;
   pyramid->height = height;
 
-  pyramid->tiles[0] = tile_manager_new (width, height, bytes);
+  pyramid->tiles[0] = tile_manager_new (width, height,
+                                        babl_format_get_bytes_per_pixel (format));
+
+  if (format != display_format)
+    {
+      pyramid->display_base = tile_manager_new (width, height,
+                                                pyramid->bytes);
+      pyramid->display_fish = babl_fish (format, display_format);
+
+      tile_manager_set_validate_proc (pyramid->display_base,
+                                      (TileValidateProc) tile_pyramid_validate_display_tile,
+                                      pyramid);
+    }
+
+  return pyramid;
+}
+
+/**
+ * tile_pyramid_new_for_tiles:
+ * @tiles: the tile-manager to use as bottom level
+ *
+ * Creates a new #TilePyramid on top of an existing tile-manager,
+ * e.g. the tiles of a drawable. The bottom level is never validated
+ * or invalidated by the pyramid, only the upper levels are computed
+ * from it. The caller has to call tile_pyramid_invalidate_area()
+ * when @tiles change.
+ *
+ * Return value: a newly allocate #TilePyramid
+ **/
+TilePyramid *
+tile_pyramid_new_for_tiles (TileManager *tiles)
+{
+  TilePyramid *pyramid;
+
+  g_return_val_if_fail (tiles != NULL, NULL);
+
+  pyramid = g_slice_new0 (TilePyramid);
+
+  pyramid->bytes         = tile_manager_bpp (tiles);
+  pyramid->width         = tile_manager_width (tiles);
+  pyramid->height        = tile_manager_height (tiles);
+  pyramid->external_base = TRUE;
+
+  pyramid->tiles[0] = tile_manager_ref (tiles);
 
   return pyramid;
 }
@@ -114,6 +173,9 @@ tile_pyramid_destroy (TilePyramid *pyramid)
   for (level = 0; level <= pyramid->top_level; level++)
     tile_manager_unref (pyramid->tiles[level]);
 
+  if (pyramid->display_base)
+    tile_manager_unref (pyramid->display_base);
+
   g_slice_free (TilePyramid, pyramid);
 }
 
@@ -165,7 +227,9 @@ tile_pyramid_get_level (gint     width,
  * @is_premult: location to store whether the pixel data has the alpha
  *              channel pre-multiplied or not
  *
- * Gives access to the #TileManager at @level of the @pyramid.
+ * Gives access to the #TileManager at @level of the @pyramid, in the
+ * display format. Use tile_pyramid_get_base_tiles() to access the
+ * bottom level in its own format.
  *
  * Return value: pointer to a #TileManager
  **/
@@ -183,9 +247,29 @@ tile_pyramid_get_tiles (TilePyramid *pyramid,
   if (is_premult)
     *is_premult = (level > 0);
 
+  if (level == 0 && pyramid->display_base)
+    return pyramid->display_base;
+
   return pyramid->tiles[level];
 }
 
+/**
+ * tile_pyramid_get_base_tiles:
+ * @pyramid: a #TilePyramid
+ *
+ * Gives access to the bottom level of the @pyramid, in the format
+ * the @pyramid was created with.
+ *
+ * Return value: pointer to a #TileManager
+ **/
+TileManager *
+tile_pyramid_get_base_tiles (TilePyramid *pyramid)
+{
+  g_return_val_if_fail (pyramid != NULL, NULL);
+
+  return pyramid->tiles[0];
+}
+
 /**
  * tile_pyramid_invalidate_area:
  * @pyramid: a #TilePyramid
@@ -217,8 +301,13 @@ tile_pyramid_invalidate_area (TilePyramid *pyramid,
       /* Tile invalidation must propagate all the way up in the pyramid,
        * so keep width and height > 0.
        */
-      tile_manager_invalidate_area (pyramid->tiles[level],
-                                    x, y, MAX (width, 1), MAX (height, 1));
+      if (level > 0 || ! pyramid->external_base)
+        tile_manager_invalidate_area (pyramid->tiles[level],
+                                      x, y, MAX (width, 1), MAX (height, 1));
+
+      if (level == 0 && pyramid->display_base)
+        tile_manager_invalidate_area (pyramid->display_base,
+                                      x, y, MAX (width, 1), MAX (height, 1));
 
       x      >>= 1;
       y      >>= 1;
@@ -241,6 +330,7 @@ tile_pyramid_set_validate_proc (TilePyramid      *pyramid,
                                 gpointer          user_data)
 {
   g_return_if_fail (pyramid != NULL);
+  g_return_if_fail (! pyramid->external_base);
 
   tile_manager_set_validate_proc (pyramid->tiles[0], proc, user_data);
 }
@@ -277,7 +367,8 @@ tile_pyramid_get_height (const TilePyramid *pyramid)
  * tile_pyramid_get_bpp:
  * @pyramid: a #TilePyramid
  *
- * Return value: the number of bytes per pixel stored in the @pyramid
+ * Return value: the number of bytes per pixel stored in the display
+ *               levels of the @pyramid
  **/
 gint
 tile_pyramid_get_bpp (const TilePyramid *pyramid)
@@ -301,9 +392,14 @@ tile_pyramid_get_memsize (const TilePyramid *pyramid)
 
   g_return_val_if_fail (pyramid != NULL, 0);
 
-  for (level = 0; level <= pyramid->top_level; level++)
+  for (level = pyramid->external_base ? 1 : 0;
+       level <= pyramid->top_level;
+       level++)
     memsize += tile_manager_get_memsize (pyramid->tiles[level], TRUE);
 
+  if (pyramid->display_base)
+    memsize += tile_manager_get_memsize (pyramid->display_base, TRUE);
+
   return memsize;
 }
 
@@ -326,6 +422,7 @@ tile_pyramid_alloc_levels (TilePyramid *pyramid,
   for (level = pyramid->top_level + 1; level <= top_level; level++)
     {
       TileValidateProc  proc;
+      TileManager      *below;
       gint              width  = pyramid->width  >> level;
       gint              height = pyramid->height >> level;
 
@@ -341,20 +438,52 @@ tile_pyramid_alloc_levels (TilePyramid *pyramid,
       pyramid->top_level    = level;
       pyramid->tiles[level] = tile_manager_new (width, height, pyramid->bytes);
 
-      /* Use the level below to validate tiles. */
+      /* Use the level below to validate tiles, in the display format. */
       if (level == 1)
-        proc = (TileValidateProc) tile_pyramid_validate_tile;
+        {
+          proc  = (TileValidateProc) tile_pyramid_validate_tile;
+          below = (pyramid->display_base ?
+                   pyramid->display_base : pyramid->tiles[0]);
+        }
       else
-        proc = (TileValidateProc) tile_pyramid_validate_upper_tile;
+        {
+          proc  = (TileValidateProc) tile_pyramid_validate_upper_tile;
+          below = pyramid->tiles[level - 1];
+        }
 
-      tile_manager_set_validate_proc (pyramid->tiles[level],
-                                      proc,
-                                      pyramid->tiles[level - 1]);
+      tile_manager_set_validate_proc (pyramid->tiles[level], proc, below);
     }
 
   return pyramid->top_level;
 }
 
+/* This method is used to validate a tile of the bottom level's display
+ * copy, by converting the same tile of the bottom level.
+ */
+static void
+tile_pyramid_validate_display_tile (TileManager *tm,
+                                    Tile        *tile,
+                                    TilePyramid *pyramid)
+{
+  Tile *source;
+  gint  tile_col;
+  gint  tile_row;
+
+  tile_manager_get_tile_col_row (tm, tile, &tile_col, &tile_row);
+
+  source = tile_manager_get_at (pyramid->tiles[0],
+                                tile_col, tile_row,
+                                TRUE, FALSE);
+  if (source)
+    {
+      babl_process (pyramid->display_fish,
+                    tile_data_pointer (source, 0, 0),
+                    tile_data_pointer (tile, 0, 0),
+                    tile_ewidth (tile) * tile_eheight (tile));
+      tile_release (source, FALSE);
+    }
+}
+
 /* This method is used to validate a pyramid tile from four tiles on
  * the base level.  It needs to pre-multiply the alpha channel because
  * upper levels are pre-multiplied.
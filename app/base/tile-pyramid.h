@@ -28,9 +28,11 @@
  *  is "nlevels - 1". That level will be smaller than TILE_WIDTH x
  *  TILE_HEIGHT
  */
-TilePyramid * tile_pyramid_new               (gint               bytes,
+TilePyramid * tile_pyramid_new               (const Babl        *format,
+                                              const Babl        *display_format,
                                               gint               width,
                                               gint               height);
+TilePyramid * tile_pyramid_new_for_tiles     (TileManager       *tiles);
 void          tile_pyramid_destroy           (TilePyramid       *pyramid);
 
 gint          tile_pyramid_get_level         (gint               width,
@@ -40,6 +42,7 @@ gint          tile_pyramid_get_level         (gint               width,
 TileManager * tile_pyramid_get_tiles         (TilePyramid       *pyramid,
                                               gint               level,
                                               gboolean          *is_premult);
+TileManager * tile_pyramid_get_base_tiles    (TilePyramid       *pyramid);
 
 void          tile_pyramid_invalidate_area   (TilePyramid       *pyramid,
                                               gint               x,
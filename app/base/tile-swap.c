@@ -53,6 +53,8 @@
 
 #include "core/gimp-utils.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 typedef enum
@@ -81,6 +83,10 @@ struct _SwapFile
   GList   *gaps;
   gint64   swap_file_end;
   gint64   cur_position;
+
+  gint64   used_size;      /*  bytes of tile data in the file  */
+  guint64  bytes_read;
+  guint64  bytes_written;
 };
 
 struct _SwapFileGap
@@ -217,6 +223,9 @@ tile_swap_init (const gchar *path)
   gimp_swap_file->swap_file_end = 0;
   gimp_swap_file->cur_position  = 0;
   gimp_swap_file->fd            = -1;
+  gimp_swap_file->used_size     = 0;
+  gimp_swap_file->bytes_read    = 0;
+  gimp_swap_file->bytes_written = 0;
 
   g_free (basename);
   g_free (dirname);
@@ -285,6 +294,20 @@ tile_swap_exit (void)
   gimp_swap_file = NULL;
 }
 
+void
+tile_swap_get_stats (gint64  *file_size,
+                     gint64  *used_size,
+                     guint64 *bytes_read,
+                     guint64 *bytes_written)
+{
+  SwapFile *swap_file = gimp_swap_file;
+
+  if (file_size)     *file_size     = swap_file ? swap_file->swap_file_end : 0;
+  if (used_size)     *used_size     = swap_file ? swap_file->used_size     : 0;
+  if (bytes_read)    *bytes_read    = swap_file ? swap_file->bytes_read    : 0;
+  if (bytes_written) *bytes_written = swap_file ? swap_file->bytes_written : 0;
+}
+
 /* check if we can open a swap file */
 gboolean
 tile_swap_test (void)
@@ -347,10 +370,14 @@ tile_swap_command (Tile *tile,
   switch (command)
     {
     case SWAP_IN:
+      GIMP_TRACE_BEGIN ("tile-swap", "swap-in");
       tile_swap_default_in (gimp_swap_file, tile);
+      GIMP_TRACE_END ("tile-swap", "swap-in");
       break;
     case SWAP_OUT:
+      GIMP_TRACE_BEGIN ("tile-swap", "swap-out");
       tile_swap_default_out (gimp_swap_file, tile);
+      GIMP_TRACE_END ("tile-swap", "swap-out");
       break;
     case SWAP_DELETE:
       tile_swap_default_delete (gimp_swap_file, tile);
@@ -478,6 +505,7 @@ tile_swap_default_in (SwapFile *swap_file,
 #endif
 
   swap_file->cur_position += tile->size;
+  swap_file->bytes_read   += tile->size;
 
   /*  Do not delete the swap from the file  */
   /*  tile_swap_default_delete (swap_file, fd, tile);  */
@@ -571,7 +599,11 @@ tile_swap_default_out (SwapFile *swap_file,
 
 #endif
 
-  swap_file->cur_position += tile->size;
+  swap_file->cur_position  += tile->size;
+  swap_file->bytes_written += tile->size;
+
+  if (tile->swap_offset == -1)
+    swap_file->used_size += bytes;
 
   /* Do NOT free tile->data because we may be pre-swapping.
    * tile->data is freed in tile_cache_zorch_next
@@ -608,6 +640,8 @@ tile_swap_default_delete (SwapFile *swap_file,
   end = start + TILE_WIDTH * TILE_HEIGHT * tile->bpp;
   tile->swap_offset = -1;
 
+  swap_file->used_size -= end - start;
+
   tmp = swap_file->gaps;
   while (tmp)
     {
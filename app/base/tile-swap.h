@@ -19,14 +19,18 @@
 #define __TILE_SWAP_H__
 
 
-void     tile_swap_init     (const gchar *path);
-void     tile_swap_exit     (void);
+void     tile_swap_init      (const gchar *path);
+void     tile_swap_exit      (void);
 
-gboolean tile_swap_test     (void);
+gboolean tile_swap_test      (void);
 
-void     tile_swap_in       (Tile        *tile);
-void     tile_swap_out      (Tile        *tile);
-void     tile_swap_delete   (Tile        *tile);
+void     tile_swap_in        (Tile        *tile);
+void     tile_swap_out       (Tile        *tile);
+void     tile_swap_delete    (Tile        *tile);
 
+void     tile_swap_get_stats (gint64      *file_size,
+                              gint64      *used_size,
+                              guint64     *bytes_read,
+                              guint64     *bytes_written);
 
 #endif /* __TILE_SWAP_H__ */
@@ -82,7 +82,7 @@ tile_lock (Tile *tile)
   if (tile->ref_count == 1)
     {
       /* remove from cache, move to main store */
-      tile_cache_flush (tile);
+      tile_cache_acquire (tile);
 
 #ifdef TILE_PROFILING
       tile_active_count++;
@@ -29,6 +29,7 @@
 #include "base/tile-swap.h"
 
 #include "core/gimp.h"
+#include "core/gimpimage.h"
 #include "core/gimpparamspecs.h"
 
 #include "batch.h"
@@ -42,13 +43,36 @@
 #define BATCH_DEFAULT_EVAL_PROC   "plug-in-script-fu-eval"
 
 
-static void  batch_exit_after_callback (Gimp          *gimp) G_GNUC_NORETURN;
+typedef struct _BatchDaemon BatchDaemon;
 
-static void  batch_run_cmd             (Gimp          *gimp,
-                                        const gchar   *proc_name,
-                                        GimpProcedure *procedure,
-                                        GimpRunMode    run_mode,
-                                        const gchar   *cmd);
+struct _BatchDaemon
+{
+  Gimp          *gimp;
+  gchar         *proc_name;
+  GimpProcedure *procedure;
+  GString       *line;
+  gint           n_jobs;
+};
+
+
+static void          batch_exit_after_callback (Gimp          *gimp) G_GNUC_NORETURN;
+
+static const gchar * batch_get_interpreter     (Gimp          *gimp,
+                                                const gchar   *batch_interpreter);
+
+static GimpPDBStatusType
+                     batch_run_cmd             (Gimp          *gimp,
+                                                const gchar   *proc_name,
+                                                GimpProcedure *procedure,
+                                                GimpRunMode    run_mode,
+                                                const gchar   *cmd);
+
+static gboolean      batch_daemon_read         (GIOChannel    *channel,
+                                                GIOCondition   condition,
+                                                BatchDaemon   *daemon);
+static void          batch_daemon_run_job      (BatchDaemon   *daemon,
+                                                const gchar   *cmd);
+static void          batch_daemon_free         (BatchDaemon   *daemon);
 
 
 void
@@ -65,19 +89,7 @@ batch_run (Gimp         *gimp,
                                     G_CALLBACK (batch_exit_after_callback),
                                     NULL);
 
-  if (! batch_interpreter)
-    {
-      batch_interpreter = g_getenv ("GIMP_BATCH_INTERPRETER");
-
-      if (! batch_interpreter)
-        {
-          batch_interpreter = BATCH_DEFAULT_EVAL_PROC;
-
-          if (gimp->be_verbose)
-            g_printerr (_("No batch interpreter specified, using the default "
-                          "'%s'.\n"), batch_interpreter);
-        }
-    }
+  batch_interpreter = batch_get_interpreter (gimp, batch_interpreter);
 
   /*  script-fu text console, hardcoded for backward compatibility  */
 
@@ -118,6 +130,61 @@ batch_run (Gimp         *gimp,
   g_signal_handler_disconnect (gimp, exit_id);
 }
 
+/*
+ * Keeps the already initialized Gimp instance around and reads batch
+ * commands from stdin, one per line, running each of them as a
+ * separate job. Images created by a job are deleted when it finishes,
+ * so every job starts from the same state without paying the startup
+ * cost again. GIMP quits when stdin is closed.
+ */
+void
+batch_daemon_run (Gimp        *gimp,
+                  const gchar *batch_interpreter)
+{
+  BatchDaemon   *daemon;
+  GimpProcedure *eval_proc;
+  GIOChannel    *channel;
+
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  batch_interpreter = batch_get_interpreter (gimp, batch_interpreter);
+
+  eval_proc = gimp_pdb_lookup_procedure (gimp->pdb, batch_interpreter);
+
+  if (! eval_proc)
+    {
+      g_message (_("The batch interpreter '%s' is not available. "
+                   "Batch daemon disabled."), batch_interpreter);
+      return;
+    }
+
+  daemon = g_slice_new0 (BatchDaemon);
+
+  daemon->gimp      = gimp;
+  daemon->proc_name = g_strdup (batch_interpreter);
+  daemon->procedure = eval_proc;
+  daemon->line      = g_string_new (NULL);
+
+#ifdef G_OS_WIN32
+  channel = g_io_channel_win32_new_fd (0);
+#else
+  channel = g_io_channel_unix_new (0);
+#endif
+
+  g_io_channel_set_encoding (channel, NULL, NULL);
+
+  g_io_add_watch_full (channel, G_PRIORITY_DEFAULT,
+                       G_IO_IN | G_IO_HUP | G_IO_ERR,
+                       (GIOFunc) batch_daemon_read,
+                       daemon,
+                       (GDestroyNotify) batch_daemon_free);
+
+  g_io_channel_unref (channel);
+
+  if (gimp->be_verbose)
+    g_printerr ("batch daemon ready, reading commands from stdin\n");
+}
+
 
 /*
  * The purpose of this handler is to exit GIMP cleanly when the batch
@@ -139,17 +206,39 @@ batch_exit_after_callback (Gimp *gimp)
   exit (EXIT_SUCCESS);
 }
 
-static void
+static const gchar *
+batch_get_interpreter (Gimp        *gimp,
+                       const gchar *batch_interpreter)
+{
+  if (! batch_interpreter)
+    {
+      batch_interpreter = g_getenv ("GIMP_BATCH_INTERPRETER");
+
+      if (! batch_interpreter)
+        {
+          batch_interpreter = BATCH_DEFAULT_EVAL_PROC;
+
+          if (gimp->be_verbose)
+            g_printerr (_("No batch interpreter specified, using the default "
+                          "'%s'.\n"), batch_interpreter);
+        }
+    }
+
+  return batch_interpreter;
+}
+
+static GimpPDBStatusType
 batch_run_cmd (Gimp          *gimp,
                const gchar   *proc_name,
                GimpProcedure *procedure,
                GimpRunMode    run_mode,
                const gchar   *cmd)
 {
-  GimpValueArray *args;
-  GimpValueArray *return_vals;
-  GError         *error = NULL;
-  gint            i     = 0;
+  GimpValueArray    *args;
+  GimpValueArray    *return_vals;
+  GError            *error = NULL;
+  gint               i     = 0;
+  GimpPDBStatusType  status;
 
   args = gimp_procedure_get_arguments (procedure);
 
@@ -167,7 +256,9 @@ batch_run_cmd (Gimp          *gimp,
                                              NULL, &error,
                                              proc_name, args);
 
-  switch (g_value_get_enum (gimp_value_array_index (return_vals, 0)))
+  status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
+
+  switch (status)
     {
     case GIMP_PDB_EXECUTION_ERROR:
       if (error)
@@ -196,6 +287,9 @@ batch_run_cmd (Gimp          *gimp,
     case GIMP_PDB_SUCCESS:
       g_printerr ("batch command executed successfully\n");
       break;
+
+    default:
+      break;
     }
 
   gimp_value_array_unref (return_vals);
@@ -204,5 +298,112 @@ batch_run_cmd (Gimp          *gimp,
   if (error)
     g_error_free (error);
 
-  return;
+  return status;
+}
+
+static gboolean
+batch_daemon_read (GIOChannel   *channel,
+                   GIOCondition  condition,
+                   BatchDaemon  *daemon)
+{
+  if (condition & G_IO_IN)
+    {
+      GIOStatus  status;
+      gsize      terminator;
+      GError    *error = NULL;
+
+      status = g_io_channel_read_line_string (channel, daemon->line,
+                                              &terminator, &error);
+
+      switch (status)
+        {
+        case G_IO_STATUS_NORMAL:
+          g_string_truncate (daemon->line, terminator);
+
+          if (daemon->line->len > 0)
+            batch_daemon_run_job (daemon, daemon->line->str);
+          return TRUE;
+
+        case G_IO_STATUS_AGAIN:
+          return TRUE;
+
+        case G_IO_STATUS_ERROR:
+          g_printerr ("batch daemon: error reading stdin: %s\n",
+                      error->message);
+          g_clear_error (&error);
+          break;
+
+        case G_IO_STATUS_EOF:
+          /*  run a last command that was not terminated by a newline  */
+          if (daemon->line->len > 0)
+            batch_daemon_run_job (daemon, daemon->line->str);
+          break;
+        }
+    }
+
+  if (daemon->gimp->be_verbose)
+    g_printerr ("batch daemon: %d jobs processed, exiting\n",
+                daemon->n_jobs);
+
+  gimp_exit (daemon->gimp, TRUE);
+
+  return FALSE;
+}
+
+static void
+batch_daemon_run_job (BatchDaemon *daemon,
+                      const gchar *cmd)
+{
+  Gimp              *gimp   = daemon->gimp;
+  GList             *images = g_list_copy (gimp_get_image_iter (gimp));
+  GList             *list;
+  GTimer            *timer;
+  GimpPDBStatusType  status;
+  gint               n_deleted = 0;
+
+  daemon->n_jobs++;
+
+  timer = g_timer_new ();
+
+  status = batch_run_cmd (gimp, daemon->proc_name, daemon->procedure,
+                          GIMP_RUN_NONINTERACTIVE, cmd);
+
+  g_timer_stop (timer);
+
+  /*  delete all images the job created and left behind, the same way
+   *  gimp-image-delete would
+   */
+  for (list = g_list_copy (gimp_get_image_iter (gimp));
+       list;
+       list = g_list_delete_link (list, list))
+    {
+      GimpImage *image = list->data;
+
+      if (! g_list_find (images, image) &&
+          gimp_image_get_display_count (image) == 0)
+        {
+          g_object_unref (image);
+          n_deleted++;
+        }
+    }
+
+  g_list_free (images);
+
+  /*  one machine-readable line per job on stdout  */
+  g_print ("batch-job %d %s %.6f %d\n",
+           daemon->n_jobs,
+           status == GIMP_PDB_SUCCESS ? "success" : "error",
+           g_timer_elapsed (timer, NULL),
+           n_deleted);
+
+  g_timer_destroy (timer);
+}
+
+static void
+batch_daemon_free (BatchDaemon *daemon)
+{
+  g_free (daemon->proc_name);
+  g_string_free (daemon->line, TRUE);
+
+  g_slice_free (BatchDaemon, daemon);
 }
@@ -23,9 +23,11 @@
 #endif
 
 
-void   batch_run (Gimp         *gimp,
-                  const gchar  *batch_interpreter,
-                  const gchar **batch_commands);
+void   batch_run        (Gimp         *gimp,
+                         const gchar  *batch_interpreter,
+                         const gchar **batch_commands);
+void   batch_daemon_run (Gimp         *gimp,
+                         const gchar  *batch_interpreter);
 
 
 #endif /* __BATCH_H__ */
@@ -41,8 +41,6 @@
 #include "gimp-intl.h"
 
 
-#define GIMP_MAX_NUM_THREADS 16
-
 enum
 {
   PROP_0,
@@ -30,6 +30,8 @@
 #include "gimp-apply-operation.h"
 #include "gimpprogress.h"
 
+#include "gimp-trace.h"
+
 
 void
 gimp_apply_operation (GeglBuffer          *src_buffer,
@@ -91,9 +93,19 @@ gimp_apply_operation (GeglBuffer          *src_buffer,
         }
     }
 
+  GIMP_TRACE_BEGIN ("gegl", "apply-operation-chunk");
+
   while (gegl_processor_work (processor, &value))
-    if (progress)
-      gimp_progress_set_value (progress, value);
+    {
+      GIMP_TRACE_END ("gegl", "apply-operation-chunk");
+
+      if (progress)
+        gimp_progress_set_value (progress, value);
+
+      GIMP_TRACE_BEGIN ("gegl", "apply-operation-chunk");
+    }
+
+  GIMP_TRACE_END ("gegl", "apply-operation-chunk");
 
   g_object_unref (processor);
 
@@ -462,9 +462,10 @@ gimp_edit_fill_full (GimpImage            *image,
                      GimpLayerModeEffects  paint_mode,
                      const gchar          *undo_desc)
 {
-  GeglBuffer *dest_buffer;
-  const Babl *format;
-  gint        x, y, width, height;
+  GeglBuffer  *dest_buffer;
+  GimpTempBuf *mask = NULL;
+  const Babl  *format;
+  gint         x, y, width, height;
 
   g_return_val_if_fail (GIMP_IS_IMAGE (image), FALSE);
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
@@ -474,8 +475,16 @@ gimp_edit_fill_full (GimpImage            *image,
   if (! gimp_item_mask_intersect (GIMP_ITEM (drawable), &x, &y, &width, &height))
     return TRUE;  /*  nothing to do, but the fill succeded  */
 
-  if (pattern &&
-      babl_format_has_alpha (gimp_temp_buf_get_format (pattern->mask)) &&
+  if (pattern)
+    {
+      mask = gimp_pattern_get_mask (pattern);
+
+      if (! mask)
+        return FALSE;
+    }
+
+  if (mask &&
+      babl_format_has_alpha (gimp_temp_buf_get_format (mask)) &&
       ! gimp_drawable_has_alpha (drawable))
     {
       format = gimp_drawable_get_format_with_alpha (drawable);
@@ -488,9 +497,9 @@ gimp_edit_fill_full (GimpImage            *image,
   dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
                                  format);
 
-  if (pattern)
+  if (mask)
     {
-      GeglBuffer *src_buffer = gimp_pattern_create_buffer (pattern);
+      GeglBuffer *src_buffer = gimp_temp_buf_create_buffer (mask);
 
       gegl_buffer_set_pattern (dest_buffer, NULL, src_buffer, 0, 0);
       g_object_unref (src_buffer);
@@ -57,6 +57,10 @@
 
 #include "core-types.h"
 
+#include "base/tile-manager.h"
+
+#include "gegl/gimp-gegl-utils.h"
+
 #include "gimp.h"
 #include "gimp-utils.h"
 #include "gimpcontainer.h"
@@ -291,7 +295,13 @@ gimp_gegl_buffer_get_memsize (GeglBuffer *buffer)
 {
   if (buffer)
     {
-      const Babl *format = gegl_buffer_get_format (buffer);
+      const Babl  *format = gegl_buffer_get_format (buffer);
+      TileManager *tiles  = gimp_gegl_buffer_peek_tiles (buffer);
+
+      /*  the tile manager knows which tiles are shared with duplicates  */
+      if (tiles)
+        return (tile_manager_get_memsize (tiles, FALSE) +
+                gimp_g_object_get_memsize (G_OBJECT (buffer)));
 
       return (babl_format_get_bytes_per_pixel (format) *
               gegl_buffer_get_width (buffer) *
@@ -449,6 +449,60 @@ gimp_brush_generated_calc_lut (gdouble radius,
   return lookup;
 }
 
+/* the lookup table of the last radius and hardness, since the same
+ * brush is usually rendered many times at the same size
+ */
+static const guchar *
+gimp_brush_generated_get_lut (gfloat radius,
+                              gfloat hardness)
+{
+  static guchar *lookup          = NULL;
+  static gfloat  lookup_radius   = 0.0;
+  static gfloat  lookup_hardness = 0.0;
+
+  if (! lookup || radius != lookup_radius || hardness != lookup_hardness)
+    {
+      g_free (lookup);
+
+      lookup          = gimp_brush_generated_calc_lut (radius, hardness);
+      lookup_radius   = radius;
+      lookup_hardness = hardness;
+    }
+
+  return lookup;
+}
+
+static inline guchar
+gimp_brush_generated_calc_pixel (GimpBrushGeneratedShape  shape,
+                                 const guchar            *lookup,
+                                 gfloat                   radius,
+                                 gfloat                   aspect_ratio,
+                                 gdouble                  tx,
+                                 gdouble                  ty)
+{
+  gdouble d = 0;
+
+  ty *= aspect_ratio;
+
+  switch (shape)
+    {
+    case GIMP_BRUSH_GENERATED_CIRCLE:
+      d = sqrt (SQR (tx) + SQR (ty));
+      break;
+    case GIMP_BRUSH_GENERATED_SQUARE:
+      d = MAX (fabs (tx), fabs (ty));
+      break;
+    case GIMP_BRUSH_GENERATED_DIAMOND:
+      d = fabs (tx) + fabs (ty);
+      break;
+    }
+
+  if (d < radius + 1)
+    return lookup[(gint) RINT (d * OVERSAMPLING)];
+
+  return 0;
+}
+
 static GimpTempBuf *
 gimp_brush_generated_calc (GimpBrushGenerated      *brush,
                            GimpBrushGeneratedShape  shape,
@@ -460,17 +514,17 @@ gimp_brush_generated_calc (GimpBrushGenerated      *brush,
                            GimpVector2             *xaxis,
                            GimpVector2             *yaxis)
 {
-  guchar      *centerp;
-  guchar      *lookup;
-  guchar       a;
-  gint         half_width  = 0;
-  gint         half_height = 0;
-  gint         x, y;
-  gdouble      c, s, cs, ss;
-  GimpVector2  x_axis;
-  GimpVector2  y_axis;
-  GimpTempBuf *mask;
-  gint         mask_width;
+  guchar       *centerp;
+  const guchar *lookup;
+  guchar        a;
+  gint          half_width  = 0;
+  gint          half_height = 0;
+  gint          x, y;
+  gdouble       c, s, cs, ss;
+  GimpVector2   x_axis;
+  GimpVector2   y_axis;
+  GimpTempBuf  *mask;
+  gint          mask_width;
 
   gimp_brush_generated_get_half_size (brush,
                                       shape,
@@ -491,65 +545,81 @@ gimp_brush_generated_calc (GimpBrushGenerated      *brush,
   centerp = gimp_temp_buf_get_data (mask) +
             half_height * mask_width + half_width;
 
-  lookup = gimp_brush_generated_calc_lut (radius, hardness);
+  lookup = gimp_brush_generated_get_lut (radius, hardness);
 
-  cs = cos (- 2 * G_PI / spikes);
-  ss = sin (- 2 * G_PI / spikes);
-
-  /* for an even number of spikes compute one half and mirror it */
-  for (y = (spikes % 2 ? -half_height : 0); y <= half_height; y++)
+  if (spikes == 2 && s == 0.0)
     {
-      for (x = -half_width; x <= half_width; x++)
-        {
-          gdouble d  = 0;
-          gdouble tx = c * x - s * y;
-          gdouble ty = fabs (s * x + c * y);
+      /*  an unrotated mask is symmetric to both axes, so compute one
+       *  quadrant and mirror it; with an aspect ratio of 1.0 the mask
+       *  is also symmetric to the diagonal
+       */
+      gboolean diagonal = (aspect_ratio == 1.0 && half_width == half_height);
 
-          if (spikes > 2)
+      for (y = 0; y <= half_height; y++)
+        {
+          for (x = (diagonal ? y : 0); x <= half_width; x++)
             {
-              gdouble angle = atan2 (ty, tx);
+              a = gimp_brush_generated_calc_pixel (shape, lookup,
+                                                   radius, aspect_ratio,
+                                                   c * x - s * y,
+                                                   fabs (s * x + c * y));
 
-              while (angle > G_PI / spikes)
-                {
-                  gdouble sx = tx;
-                  gdouble sy = ty;
-
-                  tx = cs * sx - ss * sy;
-                  ty = ss * sx + cs * sy;
+              centerp[ y * mask_width + x] = a;
+              centerp[ y * mask_width - x] = a;
+              centerp[-y * mask_width + x] = a;
+              centerp[-y * mask_width - x] = a;
 
-                  angle -= 2 * G_PI / spikes;
+              if (diagonal)
+                {
+                  centerp[ x * mask_width + y] = a;
+                  centerp[ x * mask_width - y] = a;
+                  centerp[-x * mask_width + y] = a;
+                  centerp[-x * mask_width - y] = a;
                 }
             }
+        }
+    }
+  else
+    {
+      cs = cos (- 2 * G_PI / spikes);
+      ss = sin (- 2 * G_PI / spikes);
 
-          ty *= aspect_ratio;
-
-          switch (shape)
+      /* for an even number of spikes compute one half and mirror it */
+      for (y = (spikes % 2 ? -half_height : 0); y <= half_height; y++)
+        {
+          for (x = -half_width; x <= half_width; x++)
             {
-            case GIMP_BRUSH_GENERATED_CIRCLE:
-              d = sqrt (SQR (tx) + SQR (ty));
-              break;
-            case GIMP_BRUSH_GENERATED_SQUARE:
-              d = MAX (fabs (tx), fabs (ty));
-              break;
-            case GIMP_BRUSH_GENERATED_DIAMOND:
-              d = fabs (tx) + fabs (ty);
-              break;
-            }
+              gdouble tx = c * x - s * y;
+              gdouble ty = fabs (s * x + c * y);
+
+              if (spikes > 2)
+                {
+                  gdouble angle = atan2 (ty, tx);
 
-          if (d < radius + 1)
-            a = lookup[(gint) RINT (d * OVERSAMPLING)];
-          else
-            a = 0;
+                  while (angle > G_PI / spikes)
+                    {
+                      gdouble sx = tx;
+                      gdouble sy = ty;
 
-          centerp[y * mask_width + x] = a;
+                      tx = cs * sx - ss * sy;
+                      ty = ss * sx + cs * sy;
 
-          if (spikes % 2 == 0)
-            centerp[-1 * y * mask_width - x] = a;
+                      angle -= 2 * G_PI / spikes;
+                    }
+                }
+
+              a = gimp_brush_generated_calc_pixel (shape, lookup,
+                                                   radius, aspect_ratio,
+                                                   tx, ty);
+
+              centerp[y * mask_width + x] = a;
+
+              if (spikes % 2 == 0)
+                centerp[-1 * y * mask_width - x] = a;
+            }
         }
     }
 
-  g_free (lookup);
-
   if (xaxis)
     *xaxis = x_axis;
 
@@ -240,8 +240,11 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
       {
         GeglBuffer *pattern_buffer = gimp_pattern_create_buffer (pattern);
 
-        gegl_buffer_set_pattern (buffer, NULL, pattern_buffer, -x1, -y1);
-        g_object_unref (pattern_buffer);
+        if (pattern_buffer)
+          {
+            gegl_buffer_set_pattern (buffer, NULL, pattern_buffer, -x1, -y1);
+            g_object_unref (pattern_buffer);
+          }
       }
       break;
     }
@@ -21,6 +21,7 @@
 
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
@@ -43,12 +44,15 @@
 #include "gimppreviewcache.h"
 #include "gimptempbuf.h"
 
+#include "gimp-log.h"
+
 
 /*  local function prototypes  */
 
 static GimpTempBuf * gimp_drawable_preview_private (GimpDrawable *drawable,
                                                     gint          width,
                                                     gint          height);
+static void          gimp_drawable_preview_update  (GimpDrawable *drawable);
 static GimpTempBuf * gimp_drawable_indexed_preview (GimpDrawable *drawable,
                                                     const guchar *cmap,
                                                     gint          src_x,
@@ -69,12 +73,17 @@ gimp_drawable_get_preview (GimpViewable *viewable,
 {
   GimpDrawable *drawable = GIMP_DRAWABLE (viewable);
   GimpImage    *image    = gimp_item_get_image (GIMP_ITEM (drawable));
+  GimpTempBuf  *preview;
+  GTimer       *timer    = NULL;
 
   if (! image->gimp->config->layer_previews ||
       /* XXX fixme enable drawable previews for > u8 */
       gimp_drawable_get_precision (drawable) != GIMP_PRECISION_U8)
     return NULL;
 
+  if (gimp_log_flags & GIMP_LOG_PREVIEWS)
+    timer = g_timer_new ();
+
   /* Ok prime the cache with a large preview if the cache is invalid */
   if (! drawable->private->preview_valid                        &&
       width  <= PREVIEW_CACHE_PRIME_WIDTH                       &&
@@ -90,11 +99,32 @@ gimp_drawable_get_preview (GimpViewable *viewable,
       /* Save the 2nd call */
       if (width  == PREVIEW_CACHE_PRIME_WIDTH &&
           height == PREVIEW_CACHE_PRIME_HEIGHT)
-        return tb;
+        {
+          preview = tb;
+          goto done;
+        }
     }
 
   /* Second call - should NOT visit the tile cache...*/
-  return gimp_drawable_preview_private (drawable, width, height);
+  preview = gimp_drawable_preview_private (drawable, width, height);
+
+ done:
+  if (timer)
+    {
+      static gdouble total = 0.0;
+      gdouble        elapsed;
+
+      elapsed = g_timer_elapsed (timer, NULL);
+      total  += elapsed;
+
+      GIMP_LOG (PREVIEWS, "%s %d x %d: %.3f ms (%.3f ms total)",
+                gimp_object_get_name (drawable), width, height,
+                elapsed * 1000.0, total * 1000.0);
+
+      g_timer_destroy (timer);
+    }
+
+  return preview;
 }
 
 const Babl *
@@ -176,14 +206,35 @@ gimp_drawable_preview_private (GimpDrawable *drawable,
                                gint          width,
                                gint          height)
 {
-  GimpTempBuf *ret_buf = NULL;
+  GimpDrawablePrivate *private = drawable->private;
+  GimpItem            *item    = GIMP_ITEM (drawable);
+  GimpTempBuf         *ret_buf = NULL;
 
-  if (! drawable->private->preview_valid ||
-      ! (ret_buf = gimp_preview_cache_get (&drawable->private->preview_cache,
-                                           width, height)))
+  if (! private->preview_valid)
     {
-      GimpItem *item = GIMP_ITEM (drawable);
+      if (private->preview_width  != gimp_item_get_width  (item) ||
+          private->preview_height != gimp_item_get_height (item))
+        {
+          gimp_preview_cache_invalidate (&private->preview_cache);
+        }
+      else if (private->preview_cache          &&
+               private->preview_dirty.width  > 0 &&
+               private->preview_dirty.height > 0)
+        {
+          gimp_drawable_preview_update (drawable);
+        }
+
+      private->preview_dirty.width  = 0;
+      private->preview_dirty.height = 0;
+      private->preview_width        = gimp_item_get_width  (item);
+      private->preview_height       = gimp_item_get_height (item);
+      private->preview_valid        = TRUE;
+    }
+
+  ret_buf = gimp_preview_cache_get (&private->preview_cache, width, height);
 
+  if (! ret_buf)
+    {
       ret_buf = gimp_drawable_get_sub_preview (drawable,
                                                0, 0,
                                                gimp_item_get_width (item),
@@ -191,15 +242,98 @@ gimp_drawable_preview_private (GimpDrawable *drawable,
                                                width,
                                                height);
 
-      if (! drawable->private->preview_valid)
-        gimp_preview_cache_invalidate (&drawable->private->preview_cache);
+      gimp_preview_cache_add (&private->preview_cache, ret_buf);
+    }
 
-      drawable->private->preview_valid = TRUE;
+  return ret_buf;
+}
 
-      gimp_preview_cache_add (&drawable->private->preview_cache, ret_buf);
+/*  re-renders only the changed area of all cached previews, instead
+ *  of downsampling the whole drawable again for each of them
+ */
+static void
+gimp_drawable_preview_update (GimpDrawable *drawable)
+{
+  GimpDrawablePrivate *private = drawable->private;
+  GimpItem            *item    = GIMP_ITEM (drawable);
+  GeglRectangle        dirty;
+  gint                 width   = gimp_item_get_width  (item);
+  gint                 height  = gimp_item_get_height (item);
+  GSList              *list;
+
+  if (! gimp_rectangle_intersect (private->preview_dirty.x,
+                                  private->preview_dirty.y,
+                                  private->preview_dirty.width,
+                                  private->preview_dirty.height,
+                                  0, 0, width, height,
+                                  &dirty.x, &dirty.y,
+                                  &dirty.width, &dirty.height))
+    return;
+
+  /*  when most of the drawable changed, rendering from scratch is
+   *  cheaper than patching each cached preview
+   */
+  if ((gint64) dirty.width * dirty.height > (gint64) width * height / 2)
+    {
+      gimp_preview_cache_invalidate (&private->preview_cache);
+      return;
     }
 
-  return ret_buf;
+  for (list = private->preview_cache; list; list = g_slist_next (list))
+    {
+      GimpTempBuf *buf         = list->data;
+      gint         dest_width  = gimp_temp_buf_get_width  (buf);
+      gint         dest_height = gimp_temp_buf_get_height (buf);
+      gdouble      scale_x     = (gdouble) dest_width  / (gdouble) width;
+      gdouble      scale_y     = (gdouble) dest_height / (gdouble) height;
+      gint         x1, y1, x2, y2;
+      gint         src_x1, src_y1, src_x2, src_y2;
+      GimpTempBuf *sub;
+
+      /*  the preview pixels touched by the dirty area...  */
+      x1 = CLAMP (floor (dirty.x * scale_x), 0, dest_width);
+      y1 = CLAMP (floor (dirty.y * scale_y), 0, dest_height);
+      x2 = CLAMP (ceil ((dirty.x + dirty.width)  * scale_x), 0, dest_width);
+      y2 = CLAMP (ceil ((dirty.y + dirty.height) * scale_y), 0, dest_height);
+
+      if (x2 <= x1 || y2 <= y1)
+        continue;
+
+      /*  ...and the drawable area they are rendered from  */
+      src_x1 = CLAMP (floor (x1 / scale_x), 0, width);
+      src_y1 = CLAMP (floor (y1 / scale_y), 0, height);
+      src_x2 = CLAMP (ceil  (x2 / scale_x), 0, width);
+      src_y2 = CLAMP (ceil  (y2 / scale_y), 0, height);
+
+      if (src_x2 <= src_x1 || src_y2 <= src_y1)
+        continue;
+
+      sub = gimp_drawable_get_sub_preview (drawable,
+                                           src_x1, src_y1,
+                                           src_x2 - src_x1, src_y2 - src_y1,
+                                           x2 - x1, y2 - y1);
+
+      if (sub)
+        {
+          const Babl *format    = gimp_temp_buf_get_format (buf);
+          gint        bpp       = babl_format_get_bytes_per_pixel (format);
+          gint        rowstride = dest_width * bpp;
+          guchar     *src       = gimp_temp_buf_get_data (sub);
+          guchar     *dest      = (gimp_temp_buf_get_data (buf) +
+                                   y1 * rowstride + x1 * bpp);
+          gint        y;
+
+          for (y = y1; y < y2; y++)
+            {
+              memcpy (dest, src, (x2 - x1) * bpp);
+
+              src  += (x2 - x1) * bpp;
+              dest += rowstride;
+            }
+
+          gimp_temp_buf_unref (sub);
+        }
+    }
 }
 
 static GimpTempBuf *
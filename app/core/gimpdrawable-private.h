@@ -35,6 +35,14 @@ struct _GimpDrawablePrivate
 
   GSList        *preview_cache; /* preview caches of the channel */
   gboolean       preview_valid; /* is the preview valid?         */
+
+  /*  area changed since the preview caches were last brought up to
+   *  date, and the drawable size they were rendered at
+   */
+  GeglRectangle  preview_dirty;
+  gint           preview_width;
+  gint           preview_height;
+  gboolean       preview_partial_update;
 };
 
 #endif /* __GIMP_DRAWABLE_PRIVATE_H__ */
@@ -373,8 +373,12 @@ gimp_drawable_stroke_scan_convert (GimpDrawable    *drawable,
         GeglBuffer  *pattern_buffer;
 
         pattern_buffer = gimp_pattern_create_buffer (pattern);
-        gegl_buffer_set_pattern (base_buffer, NULL, pattern_buffer, 0, 0);
-        g_object_unref (pattern_buffer);
+
+        if (pattern_buffer)
+          {
+            gegl_buffer_set_pattern (base_buffer, NULL, pattern_buffer, 0, 0);
+            g_object_unref (pattern_buffer);
+          }
       }
       break;
     }
@@ -339,8 +339,17 @@ gimp_drawable_invalidate_preview (GimpViewable *viewable)
 
   drawable->private->preview_valid = FALSE;
 
+  /*  keep the preview caches around when only a part of the drawable
+   *  changed, gimp_drawable_get_preview() will update them incrementally
+   */
+  if (drawable->private->preview_partial_update)
+    return;
+
   if (drawable->private->preview_cache)
     gimp_preview_cache_invalidate (&drawable->private->preview_cache);
+
+  drawable->private->preview_dirty.width  = 0;
+  drawable->private->preview_dirty.height = 0;
 }
 
 static void
@@ -678,7 +687,25 @@ gimp_drawable_real_update (GimpDrawable *drawable,
         }
     }
 
+  if (drawable->private->preview_cache)
+    {
+      GeglRectangle *dirty = &drawable->private->preview_dirty;
+
+      if (dirty->width > 0 && dirty->height > 0)
+        gimp_rectangle_union (dirty->x, dirty->y,
+                              dirty->width, dirty->height,
+                              x, y, width, height,
+                              &dirty->x, &dirty->y,
+                              &dirty->width, &dirty->height);
+      else
+        gegl_rectangle_set (dirty, x, y, width, height);
+
+      drawable->private->preview_partial_update = TRUE;
+    }
+
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
+
+  drawable->private->preview_partial_update = FALSE;
 }
 
 static gint64
@@ -1406,6 +1433,9 @@ gimp_drawable_fill (GimpDrawable      *drawable,
     {
       GeglBuffer *src_buffer = gimp_pattern_create_buffer (pattern);
 
+      if (! src_buffer)
+        return;
+
       gegl_buffer_set_pattern (gimp_drawable_get_buffer (drawable),
                                NULL, src_buffer, 0, 0);
       g_object_unref (src_buffer);
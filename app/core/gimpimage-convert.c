@@ -187,15 +187,21 @@
 
 
 typedef struct _Color Color;
+typedef struct _KDNode KDNode;
 typedef struct _QuantizeObj QuantizeObj;
+typedef unsigned long ColorFreq;
+typedef ColorFreq *CFHistogram;
 typedef void (* Pass1_Func)   (QuantizeObj *quantize_obj);
 typedef void (* Pass2i_Func)  (QuantizeObj *quantize_obj);
 typedef void (* Pass2_Func)   (QuantizeObj *quantize_obj,
                                GimpLayer   *layer,
                                GeglBuffer  *new_buffer);
+typedef void (* Fill_Func)    (QuantizeObj *quantize_obj,
+                               CFHistogram  histogram,
+                               int          R,
+                               int          G,
+                               int          B);
 typedef void (* Cleanup_Func) (QuantizeObj *quantize_obj);
-typedef unsigned long ColorFreq;
-typedef ColorFreq *CFHistogram;
 
 typedef enum {AXIS_UNDEF, AXIS_RED, AXIS_BLUE, AXIS_GREEN} axisType;
 
@@ -305,8 +311,19 @@ ColorFreq* HIST_LIN(ColorFreq *hist_ptr,
 #define BRAT (1.0F)
 #endif
 
+/*  Converting a single pixel with babl is expensive compared to
+ *  everything else we do per pixel, so the results of
+ *  rgb_to_unshifted_lin() are kept in a direct-mapped cache, indexed
+ *  by a hash of the RGB triple.  Each entry holds a valid bit, the
+ *  RGB triple and the resulting L*a*b* triple.
+ */
+#define LIN_CACHE_BITS  16
+#define LIN_CACHE_SIZE  (1 << LIN_CACHE_BITS)
+#define LIN_CACHE_VALID (1 << 24)
+
 static const Babl *rgb_to_lab_fish = NULL;
 static const Babl *lab_to_rgb_fish = NULL;
+static guint64    *lin_cache       = NULL;
 
 static inline
 void rgb_to_unshifted_lin(const unsigned char r,
@@ -314,10 +331,26 @@ void rgb_to_unshifted_lin(const unsigned char r,
                           const unsigned char b,
                           int *hr, int *hg, int *hb)
 {
+  const guint32  key   = LIN_CACHE_VALID | (r << 16) | (g << 8) | b;
+  guint64       *entry = &lin_cache[(key * 2654435761u) >>
+                                    (32 - LIN_CACHE_BITS)];
   int or, og, ob;
-  float rgb[3] = {r/255.0, g/255.0, b/255.0};
+  float rgb[3];
   float lab[3];
 
+  if ((*entry >> 24) == key)
+    {
+      *hr = (*entry >> 16) & 0xff;
+      *hg = (*entry >>  8) & 0xff;
+      *hb = (*entry      ) & 0xff;
+
+      return;
+    }
+
+  rgb[0] = r / 255.0;
+  rgb[1] = g / 255.0;
+  rgb[2] = b / 255.0;
+
   babl_process (rgb_to_lab_fish, rgb, lab, 1);
 
   /* fprintf(stderr, " %d-%d-%d -> %0.3f,%0.3f,%0.3f ", r, g, b, sL, sa, sb);*/
@@ -330,6 +363,8 @@ void rgb_to_unshifted_lin(const unsigned char r,
   *hg = CLAMP(og, 0, 255);
   *hb = CLAMP(ob, 0, 255);
 
+  *entry = ((guint64) key << 24) | (*hr << 16) | (*hg << 8) | *hb;
+
   /*  fprintf(stderr, " %d:%d:%d ", *hr, *hg, *hb); */
 }
 
@@ -453,11 +488,18 @@ struct _Color
   int blue;
 };
 
+struct _KDNode
+{
+  int coord[3];                     /* colormap entry in scaled linear space */
+  int index;                        /* its index in the colormap */
+};
+
 struct _QuantizeObj
 {
   Pass1_Func   first_pass;          /* first pass over image data creates colormap  */
   Pass2i_Func  second_pass_init;    /* Initialize data which persists over invocations */
   Pass2_Func   second_pass;         /* second pass maps from image data to colormap */
+  Fill_Func    fill_inverse_cmap;   /* finds the colormap entry for a histogram cell */
   Cleanup_Func delete_func;         /* function to clean up data associated with private */
 
   int desired_number_of_colors;     /* Number of colors we will allow    */
@@ -466,6 +508,7 @@ struct _QuantizeObj
   Color clin[256];                  /* .. converted back to linear space */
   gulong index_used_count[256];     /* how many times an index was used */
   CFHistogram histogram;            /* holds the histogram               */
+  KDNode *kdtree;                   /* k-d tree of clin, if used         */
 
   gboolean want_alpha_dither;
   int      error_freedom;           /* 0=much bleed, 1=controlled bleed */
@@ -821,6 +864,8 @@ gimp_image_convert (GimpImage               *image,
       lab_to_rgb_fish = babl_fish (babl_format ("CIE Lab float"),
                                    babl_format ("R'G'B' float"));
 
+      lin_cache = g_new0 (guint64, LIN_CACHE_SIZE);
+
       /* fprintf(stderr, " TO INDEXED(%d) ", num_cols); */
 
       /* don't dither if the input is grayscale and we are simply
@@ -1078,6 +1123,12 @@ gimp_image_convert (GimpImage               *image,
   if (quantobj)
     quantobj->delete_func (quantobj);
 
+  if (lin_cache)
+    {
+      g_free (lin_cache);
+      lin_cache = NULL;
+    }
+
   gimp_image_undo_group_end (image);
 
   gimp_image_mode_changed (image);
@@ -1175,6 +1226,7 @@ generate_histogram_rgb (CFHistogram   histogram,
   GeglRectangle      *roi;
   ColorFreq          *colfreq;
   gint                nfc_iter;
+  gint                last_found = 0;
   gint                row, col, coledge;
   gint                offsetx, offsety;
   glong               layer_size;
@@ -1307,14 +1359,30 @@ generate_histogram_rgb (CFHistogram   histogram,
 
                   if (!needs_quantize)
                     {
-                      for (nfc_iter = 0;
-                           nfc_iter < num_found_cols;
-                           nfc_iter++)
+                      /* A colour whose histogram cell was empty can't
+                       * be in the table yet.  Otherwise, neighbouring
+                       * pixels usually share their colour, so try the
+                       * one found last before searching the table.
+                       */
+                      if (*colfreq > 1)
                         {
-                          if ((data[RED]   == found_cols[nfc_iter][0]) &&
-                              (data[GREEN] == found_cols[nfc_iter][1]) &&
-                              (data[BLUE]  == found_cols[nfc_iter][2]))
+                          if ((data[RED]   == found_cols[last_found][0]) &&
+                              (data[GREEN] == found_cols[last_found][1]) &&
+                              (data[BLUE]  == found_cols[last_found][2]))
                             goto already_found;
+
+                          for (nfc_iter = 0;
+                               nfc_iter < num_found_cols;
+                               nfc_iter++)
+                            {
+                              if ((data[RED]   == found_cols[nfc_iter][0]) &&
+                                  (data[GREEN] == found_cols[nfc_iter][1]) &&
+                                  (data[BLUE]  == found_cols[nfc_iter][2]))
+                                {
+                                  last_found = nfc_iter;
+                                  goto already_found;
+                                }
+                            }
                         }
 
                       /* Colour was not in the table of
@@ -1341,6 +1409,8 @@ generate_histogram_rgb (CFHistogram   histogram,
                           found_cols[num_found_cols-1][0] = data[RED];
                           found_cols[num_found_cols-1][1] = data[GREEN];
                           found_cols[num_found_cols-1][2] = data[BLUE];
+
+                          last_found = num_found_cols - 1;
                         }
                     }
                 }
@@ -2733,6 +2803,130 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
 }
 
 
+/*
+ * Fixed palettes (web and custom) have many entries and are not adapted
+ * to the image, so instead of measuring the distance to every colormap
+ * entry for each histogram cell, the nearest entry is looked up in a
+ * k-d tree of the linear colormap.  The distances and the tie-breaking
+ * (lowest colormap index wins) are the same as in find_best_colors(),
+ * so both methods fill in the same inverse colormap.
+ */
+
+static gint
+kdtree_compare (gconstpointer a,
+                gconstpointer b,
+                gpointer      data)
+{
+  const KDNode *node_a = a;
+  const KDNode *node_b = b;
+  gint          axis   = GPOINTER_TO_INT (data);
+
+  if (node_a->coord[axis] != node_b->coord[axis])
+    return node_a->coord[axis] - node_b->coord[axis];
+
+  return node_a->index - node_b->index;
+}
+
+static void
+kdtree_build (KDNode *nodes,
+              gint    n_nodes,
+              gint    axis)
+/* Sort the nodes such that the median along axis is in the middle,
+ * with the nodes before and after it forming the subtrees, which are
+ * split along the next axis.
+ */
+{
+  gint mid = n_nodes / 2;
+
+  if (n_nodes < 2)
+    return;
+
+  g_qsort_with_data (nodes, n_nodes, sizeof (KDNode),
+                     kdtree_compare, GINT_TO_POINTER (axis));
+
+  axis = (axis + 1) % 3;
+
+  kdtree_build (nodes,           mid,               axis);
+  kdtree_build (nodes + mid + 1, n_nodes - mid - 1, axis);
+}
+
+static void
+kdtree_search (const KDNode *nodes,
+               gint          n_nodes,
+               gint          axis,
+               const gint    query[3],
+               gint         *best_dist,
+               gint         *best_index)
+{
+  const KDNode *node;
+  gint          mid = n_nodes / 2;
+  gint          dist;
+  gint          delta;
+  gint          i;
+
+  if (n_nodes < 1)
+    return;
+
+  node = &nodes[mid];
+
+  for (i = 0, dist = 0; i < 3; i++)
+    dist += SQR (query[i] - node->coord[i]);
+
+  if (dist < *best_dist ||
+      (dist == *best_dist && node->index < *best_index))
+    {
+      *best_dist  = dist;
+      *best_index = node->index;
+    }
+
+  delta = query[axis] - node->coord[axis];
+  axis  = (axis + 1) % 3;
+
+  /* Search the side of the splitting plane the query is on first,
+   * then the other side if it may hold an entry at least as close.
+   */
+  if (delta < 0)
+    {
+      kdtree_search (nodes, mid, axis, query, best_dist, best_index);
+
+      if (SQR (delta) <= *best_dist)
+        kdtree_search (nodes + mid + 1, n_nodes - mid - 1, axis,
+                       query, best_dist, best_index);
+    }
+  else
+    {
+      kdtree_search (nodes + mid + 1, n_nodes - mid - 1, axis,
+                     query, best_dist, best_index);
+
+      if (SQR (delta) <= *best_dist)
+        kdtree_search (nodes, mid, axis, query, best_dist, best_index);
+    }
+}
+
+static void
+kdtree_fill_inverse_cmap_rgb (QuantizeObj *quantobj,
+                              CFHistogram  histogram,
+                              int          R,
+                              int          G,
+                              int          B)
+/* Fill the inverse-colormap entry of histogram cell R/G/B only. */
+{
+  gint query[3];
+  gint best_dist  = G_MAXINT;
+  gint best_index = 0;
+
+  /* Use the center of the cell, as fill_inverse_cmap_rgb() does */
+  query[0] = ((R << R_SHIFT) + ((1 << R_SHIFT) >> 1)) * R_SCALE;
+  query[1] = ((G << G_SHIFT) + ((1 << G_SHIFT) >> 1)) * G_SCALE;
+  query[2] = ((B << B_SHIFT) + ((1 << B_SHIFT) >> 1)) * B_SCALE;
+
+  kdtree_search (quantobj->kdtree, quantobj->actual_number_of_colors, 0,
+                 query, &best_dist, &best_index);
+
+  *HIST_LIN (histogram, R, G, B) = best_index + 1;
+}
+
+
 /*  This is pass 1  */
 
 static void
@@ -3180,7 +3374,7 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
               /* If we have not seen this color before, find nearest
                  colormap entry and update the cache */
               if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
+                quantobj->fill_inverse_cmap (quantobj, histogram, R, G, B);
 
               /* Now emit the colormap index for this cell, barfbarf */
               index_used_count[dest[INDEXED] = *cachep - 1]++;
@@ -3213,8 +3407,11 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   gint                src_bpp;
   gint                dest_bpp;
   gint                has_alpha;
-  gint                pixval1 = 0;
-  gint                pixval2 = 0;
+  gint                pixval1     = 0;
+  gint                pixval2     = 0;
+  gint                proportion2 = 255;
+  gint                rgb;
+  gint                last_rgb    = -1;
   Color              *color1;
   Color              *color2;
   gint                R, G, B;
@@ -3308,6 +3505,16 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
+              /* The candidates and their relative probabilities only
+                 depend on the colour, so reuse them while the source
+                 colour doesn't change. */
+              rgb = (src[red_pix] << 16) | (src[green_pix] << 8) | src[blue_pix];
+
+              if (rgb == last_rgb)
+                goto emit_pixel;
+
+              last_rgb = rgb;
+
               /* get pixel value and index into the cache */
               rgb_to_lin(src[red_pix], src[green_pix], src[blue_pix],
                          &R, &G, &B);
@@ -3315,7 +3522,7 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
               /* If we have not seen this color before, find nearest
                  colormap entry and update the cache */
               if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
+                quantobj->fill_inverse_cmap (quantobj, histogram, R, G, B);
 
               /* We now try to find a colour which, when mixed in some fashion
                  with the closest match, yields something closer to the
@@ -3348,7 +3555,8 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                          colormap entry and update the cache */
                       if (*cachep == 0)
                         {
-                          fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
+                          quantobj->fill_inverse_cmap (quantobj, histogram,
+                                                       R, G, B);
                         }
                       pixval2 = *cachep - 1;
                       RV += re;  GV += ge;  BV += be;
@@ -3405,16 +3613,22 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                      err2);
 
               if (err1 || err2)
-                {
-                  const int proportion2 = (255 * err2) / (err1 + err2);
-                  if (dmval > proportion2)
-                    {
-                      pixval1 = pixval2; /* use color2 instead of color1*/
-                    }
-                }
+                proportion2 = (255 * err2) / (err1 + err2);
+              else
+                proportion2 = 255; /* never use color2 */
+
+            emit_pixel:
 
               /* Now emit the colormap index for this cell, barfbarf */
-              index_used_count[dest[INDEXED] = pixval1]++;
+              if (dmval > proportion2)
+                {
+                  /* use color2 instead of color1*/
+                  index_used_count[dest[INDEXED] = pixval2]++;
+                }
+              else
+                {
+                  index_used_count[dest[INDEXED] = pixval1]++;
+                }
 
             next_pixel:
 
@@ -3886,6 +4100,27 @@ median_cut_pass2_rgb_init (QuantizeObj *quantobj)
     }
 }
 
+static void
+kdtree_pass2_rgb_init (QuantizeObj *quantobj)
+{
+  int i;
+
+  median_cut_pass2_rgb_init (quantobj);
+
+  g_free (quantobj->kdtree);
+  quantobj->kdtree = g_new (KDNode, quantobj->actual_number_of_colors);
+
+  for (i = 0; i < quantobj->actual_number_of_colors; i++)
+    {
+      quantobj->kdtree[i].coord[0] = quantobj->clin[i].red   * R_SCALE;
+      quantobj->kdtree[i].coord[1] = quantobj->clin[i].green * G_SCALE;
+      quantobj->kdtree[i].coord[2] = quantobj->clin[i].blue  * B_SCALE;
+      quantobj->kdtree[i].index    = i;
+    }
+
+  kdtree_build (quantobj->kdtree, quantobj->actual_number_of_colors, 0);
+}
+
 static void
 median_cut_pass2_gray_init (QuantizeObj *quantobj)
 {
@@ -4139,10 +4374,10 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
           /* If we have not seen this color before, find nearest
              colormap entry and update the cache */
           if (*cachep == 0)
-            fill_inverse_cmap_rgb (quantobj, histogram,
-                                   RSDF(re),
-                                   GSDF(ge),
-                                   BSDF(be));
+            quantobj->fill_inverse_cmap (quantobj, histogram,
+                                         RSDF(re),
+                                         GSDF(ge),
+                                         BSDF(be));
 
           index = *cachep - 1;
           index_used_count[index]++;
@@ -4274,6 +4509,7 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
 static void
 delete_median_cut (QuantizeObj *quantobj)
 {
+  g_free (quantobj->kdtree);
   g_free (quantobj->histogram);
   g_free (quantobj);
 }
@@ -4320,7 +4556,7 @@ initialize_median_cut (GimpImageBaseType       type,
   QuantizeObj *quantobj;
 
   /* Initialize the data structures */
-  quantobj = g_new (QuantizeObj, 1);
+  quantobj = g_new0 (QuantizeObj, 1);
 
   if (type == GIMP_GRAY && palette_type == GIMP_MAKE_PALETTE)
     quantobj->histogram = g_new (ColorFreq, 256);
@@ -4331,6 +4567,7 @@ initialize_median_cut (GimpImageBaseType       type,
   quantobj->desired_number_of_colors = num_colors;
   quantobj->want_alpha_dither        = want_alpha_dither;
   quantobj->progress                 = progress;
+  quantobj->fill_inverse_cmap        = fill_inverse_cmap_rgb;
 
   switch (type)
     {
@@ -4458,6 +4695,15 @@ initialize_median_cut (GimpImageBaseType       type,
       break;
     }
 
+  /*  Look up the nearest colors of fixed palettes in a k-d tree  */
+  if (quantobj->second_pass_init == median_cut_pass2_rgb_init &&
+      (palette_type == GIMP_WEB_PALETTE ||
+       palette_type == GIMP_CUSTOM_PALETTE))
+    {
+      quantobj->second_pass_init  = kdtree_pass2_rgb_init;
+      quantobj->fill_inverse_cmap = kdtree_fill_inverse_cmap_rgb;
+    }
+
   quantobj->delete_func = delete_median_cut;
 
   return quantobj;
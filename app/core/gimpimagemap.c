@@ -33,6 +33,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 #include <gegl.h>
 
@@ -49,6 +51,8 @@
 #include "gimpviewable.h"
 #include "gimpchannel.h"
 
+#include "gimp-trace.h"
+
 
 enum
 {
@@ -75,6 +79,9 @@ struct _GimpImageMap
   GeglNode      *output;
   GeglProcessor *processor;
 
+  GeglRectangle  pending[5];    /* the visible part first, then the rest */
+  gint           n_pending;
+
   guint          idle_id;
 
   GTimer        *timer;
@@ -101,6 +108,9 @@ static gboolean        gimp_image_map_get_pixel_at    (GimpPickable        *pick
 static void            gimp_image_map_update_undo_buffer
                                                       (GimpImageMap        *image_map,
                                                        const GeglRectangle *rect);
+static void            gimp_image_map_split_rect      (GimpImageMap        *image_map,
+                                                       const GeglRectangle *rect,
+                                                       const GeglRectangle *visible);
 static gboolean        gimp_image_map_do              (GimpImageMap        *image_map);
 static void            gimp_image_map_data_written    (GObject             *operation,
                                                        const GeglRectangle *extent,
@@ -442,7 +452,13 @@ gimp_image_map_apply (GimpImageMap        *image_map,
                  "buffer", output_buffer,
                  NULL);
 
-  image_map->processor = gegl_node_new_processor (image_map->output, &rect);
+  /*  Process the visible part first, so it is updated quickly even
+   *  on large drawables
+   */
+  gimp_image_map_split_rect (image_map, &rect, visible);
+
+  image_map->processor = gegl_node_new_processor (image_map->output,
+                                                  &image_map->pending[0]);
 
   if (image_map->timer)
     {
@@ -604,6 +620,55 @@ gimp_image_map_update_undo_buffer (GimpImageMap        *image_map,
     }
 }
 
+/*  queues @rect as up to five rectangles that cover it exactly once:
+ *  the part of it that is @visible, then the bands above, below, left
+ *  and right of that part
+ */
+static void
+gimp_image_map_split_rect (GimpImageMap        *image_map,
+                           const GeglRectangle *rect,
+                           const GeglRectangle *visible)
+{
+  GeglRectangle  inner;
+  GeglRectangle *pending = image_map->pending;
+  gint           n       = 0;
+
+  if (! visible ||
+      ! gegl_rectangle_intersect (&inner, rect, visible) ||
+      gegl_rectangle_equal (&inner, rect))
+    {
+      pending[0] = *rect;
+      image_map->n_pending = 1;
+      return;
+    }
+
+  pending[n++] = inner;
+
+  if (inner.y > rect->y)
+    gegl_rectangle_set (&pending[n++],
+                        rect->x, rect->y,
+                        rect->width, inner.y - rect->y);
+
+  if (inner.y + inner.height < rect->y + rect->height)
+    gegl_rectangle_set (&pending[n++],
+                        rect->x, inner.y + inner.height,
+                        rect->width,
+                        rect->y + rect->height - (inner.y + inner.height));
+
+  if (inner.x > rect->x)
+    gegl_rectangle_set (&pending[n++],
+                        rect->x, inner.y,
+                        inner.x - rect->x, inner.height);
+
+  if (inner.x + inner.width < rect->x + rect->width)
+    gegl_rectangle_set (&pending[n++],
+                        inner.x + inner.width, inner.y,
+                        rect->x + rect->width - (inner.x + inner.width),
+                        inner.height);
+
+  image_map->n_pending = n;
+}
+
 static gboolean
 gimp_image_map_do (GimpImageMap *image_map)
 {
@@ -625,8 +690,25 @@ gimp_image_map_do (GimpImageMap *image_map)
   if (image_map->timer)
     g_timer_continue (image_map->timer);
 
+  GIMP_TRACE_BEGIN ("gegl", "image-map-chunk");
+
   pending = gegl_processor_work (image_map->processor, NULL);
 
+  GIMP_TRACE_END ("gegl", "image-map-chunk");
+
+  if (! pending && image_map->n_pending > 1)
+    {
+      /*  continue with the next part of the drawable  */
+      image_map->n_pending--;
+      memmove (image_map->pending, image_map->pending + 1,
+               image_map->n_pending * sizeof (GeglRectangle));
+
+      gegl_processor_set_rectangle (image_map->processor,
+                                    &image_map->pending[0]);
+
+      pending = TRUE;
+    }
+
   if (image_map->timer)
     g_timer_stop (image_map->timer);
 
@@ -23,6 +23,7 @@
 #include <stdio.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -69,6 +70,7 @@ gimp_pattern_load (GimpContext  *context,
   PatternHeader  header;
   gint           bn_size;
   gchar         *name    = NULL;
+  struct stat    filestat;
 
   g_return_val_if_fail (filename != NULL, NULL);
   g_return_val_if_fail (g_path_is_absolute (filename), NULL);
@@ -165,11 +167,12 @@ gimp_pattern_load (GimpContext  *context,
     case 4: format = babl_format ("R'G'B'A u8"); break;
     }
 
-  pattern->mask = gimp_temp_buf_new (header.width, header.height, format);
-
-  if (read (fd, gimp_temp_buf_get_data (pattern->mask),
-            header.width * header.height * header.bytes) <
-      header.width * header.height * header.bytes)
+  /*  don't read the pixels now, only make sure they are there; they
+   *  are read by gimp_pattern_load_mask() when the pattern is used
+   */
+  if (fstat (fd, &filestat) != 0 ||
+      filestat.st_size < ((goffset) header.header_size +
+                          (goffset) header.width * header.height * header.bytes))
     {
       g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
                    _("Fatal parse error in pattern file '%s': "
@@ -178,6 +181,11 @@ gimp_pattern_load (GimpContext  *context,
       goto error;
     }
 
+  pattern->mask_width  = header.width;
+  pattern->mask_height = header.height;
+  pattern->mask_format = format;
+  pattern->mask_offset = header.header_size;
+
   close (fd);
 
   return g_list_prepend (NULL, pattern);
@@ -191,6 +199,63 @@ gimp_pattern_load (GimpContext  *context,
   return NULL;
 }
 
+/**
+ * gimp_pattern_load_mask:
+ * @pattern:  a #GimpPattern loaded by gimp_pattern_load()
+ * @filename: the file @pattern was loaded from
+ * @error:    return location for errors or %NULL
+ *
+ * Reads the pixels of a pattern whose file has only been scanned so
+ * far and sets them as the pattern's mask.
+ *
+ * Returns: %TRUE on success.
+ **/
+gboolean
+gimp_pattern_load_mask (GimpPattern  *pattern,
+                        const gchar  *filename,
+                        GError      **error)
+{
+  GimpTempBuf *mask;
+  gint         fd;
+  gsize        size;
+
+  g_return_val_if_fail (GIMP_IS_PATTERN (pattern), FALSE);
+  g_return_val_if_fail (pattern->mask_offset > 0, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fd = g_open (filename, O_RDONLY | _O_BINARY, 0);
+  if (fd == -1)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_OPEN,
+                   _("Could not open '%s' for reading: %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      return FALSE;
+    }
+
+  mask = gimp_temp_buf_new (pattern->mask_width, pattern->mask_height,
+                            pattern->mask_format);
+  size = gimp_temp_buf_get_data_size (mask);
+
+  if (lseek (fd, pattern->mask_offset, SEEK_SET) != pattern->mask_offset ||
+      read (fd, gimp_temp_buf_get_data (mask), size) != (gssize) size)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in pattern file '%s': "
+                     "File appears truncated."),
+                   gimp_filename_to_utf8 (filename));
+      gimp_temp_buf_unref (mask);
+      close (fd);
+      return FALSE;
+    }
+
+  close (fd);
+
+  pattern->mask = mask;
+
+  return TRUE;
+}
+
 GList *
 gimp_pattern_load_pixbuf (GimpContext  *context,
                           const gchar  *filename,
@@ -22,12 +22,15 @@
 #define GIMP_PATTERN_FILE_EXTENSION ".pat"
 
 
-GList * gimp_pattern_load        (GimpContext  *context,
-                                  const gchar  *filename,
-                                  GError      **error);
-GList * gimp_pattern_load_pixbuf (GimpContext  *context,
-                                  const gchar  *filename,
-                                  GError      **error);
+GList    * gimp_pattern_load        (GimpContext  *context,
+                                     const gchar  *filename,
+                                     GError      **error);
+gboolean   gimp_pattern_load_mask   (GimpPattern  *pattern,
+                                     const gchar  *filename,
+                                     GError      **error);
+GList    * gimp_pattern_load_pixbuf (GimpContext  *context,
+                                     const gchar  *filename,
+                                     GError      **error);
 
 
 #endif /* __GIMP_PATTERN_LOAD_H__ */
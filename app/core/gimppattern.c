@@ -33,6 +33,10 @@
 #include "gimp-intl.h"
 
 
+/*  the amount of pixel data loaded on demand that is kept around  */
+#define GIMP_PATTERN_MASK_CACHE_SIZE (32 * 1024 * 1024)
+
+
 static void          gimp_pattern_tagged_iface_init (GimpTaggedInterface  *iface);
 static void          gimp_pattern_finalize          (GObject              *object);
 
@@ -54,6 +58,9 @@ static GimpData    * gimp_pattern_duplicate         (GimpData             *data)
 
 static gchar       * gimp_pattern_get_checksum      (GimpTagged           *tagged);
 
+static GimpTempBuf * gimp_pattern_ensure_mask       (GimpPattern          *pattern);
+static gboolean      gimp_pattern_mask_cache_trim   (gpointer              data);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -62,6 +69,12 @@ G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
 #define parent_class gimp_pattern_parent_class
 
 
+/*  patterns with pixels loaded on demand, most recently used first  */
+static GQueue  mask_cache      = G_QUEUE_INIT;
+static gint64  mask_cache_size = 0;
+static guint   mask_cache_idle = 0;
+
+
 static void
 gimp_pattern_class_init (GimpPatternClass *klass)
 {
@@ -102,6 +115,9 @@ gimp_pattern_finalize (GObject *object)
 
   if (pattern->mask)
     {
+      if (pattern->mask_offset && g_queue_remove (&mask_cache, pattern))
+        mask_cache_size -= gimp_temp_buf_get_data_size (pattern->mask);
+
       gimp_temp_buf_unref (pattern->mask);
       pattern->mask = NULL;
     }
@@ -129,8 +145,16 @@ gimp_pattern_get_size (GimpViewable *viewable,
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
 
-  *width  = gimp_temp_buf_get_width  (pattern->mask);
-  *height = gimp_temp_buf_get_height (pattern->mask);
+  if (pattern->mask)
+    {
+      *width  = gimp_temp_buf_get_width  (pattern->mask);
+      *height = gimp_temp_buf_get_height (pattern->mask);
+    }
+  else
+    {
+      *width  = pattern->mask_width;
+      *height = pattern->mask_height;
+    }
 
   return TRUE;
 }
@@ -142,19 +166,23 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
                               gint          height)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  GimpTempBuf *mask    = gimp_pattern_ensure_mask (pattern);
   GimpTempBuf *temp_buf;
   GeglBuffer  *src_buffer;
   GeglBuffer  *dest_buffer;
   gint         copy_width;
   gint         copy_height;
 
-  copy_width  = MIN (width,  gimp_temp_buf_get_width  (pattern->mask));
-  copy_height = MIN (height, gimp_temp_buf_get_height (pattern->mask));
+  if (! mask)
+    return NULL;
+
+  copy_width  = MIN (width,  gimp_temp_buf_get_width  (mask));
+  copy_height = MIN (height, gimp_temp_buf_get_height (mask));
 
   temp_buf = gimp_temp_buf_new (copy_width, copy_height,
-                                gimp_temp_buf_get_format (pattern->mask));
+                                gimp_temp_buf_get_format (mask));
 
-  src_buffer  = gimp_temp_buf_create_buffer (pattern->mask);
+  src_buffer  = gimp_temp_buf_create_buffer (mask);
   dest_buffer = gimp_temp_buf_create_buffer (temp_buf);
 
   gegl_buffer_copy (src_buffer,  GEGL_RECTANGLE (0, 0, copy_width, copy_height),
@@ -171,11 +199,14 @@ gimp_pattern_get_description (GimpViewable  *viewable,
                               gchar        **tooltip)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  gint         width;
+  gint         height;
+
+  gimp_pattern_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (pattern),
-                          gimp_temp_buf_get_width  (pattern->mask),
-                          gimp_temp_buf_get_height (pattern->mask));
+                          width, height);
 }
 
 static const gchar *
@@ -188,8 +219,18 @@ static GimpData *
 gimp_pattern_duplicate (GimpData *data)
 {
   GimpPattern *pattern = g_object_new (GIMP_TYPE_PATTERN, NULL);
+  GimpTempBuf *mask    = gimp_pattern_ensure_mask (GIMP_PATTERN (data));
 
-  pattern->mask = gimp_temp_buf_copy (GIMP_PATTERN (data)->mask);
+  if (mask)
+    {
+      pattern->mask = gimp_temp_buf_copy (mask);
+    }
+  else
+    {
+      pattern->mask_width  = GIMP_PATTERN (data)->mask_width;
+      pattern->mask_height = GIMP_PATTERN (data)->mask_height;
+      pattern->mask_format = GIMP_PATTERN (data)->mask_format;
+    }
 
   return GIMP_DATA (pattern);
 }
@@ -197,15 +238,15 @@ gimp_pattern_duplicate (GimpData *data)
 static gchar *
 gimp_pattern_get_checksum (GimpTagged *tagged)
 {
-  GimpPattern *pattern         = GIMP_PATTERN (tagged);
+  GimpTempBuf *mask            = gimp_pattern_ensure_mask (GIMP_PATTERN (tagged));
   gchar       *checksum_string = NULL;
 
-  if (pattern->mask)
+  if (mask)
     {
       GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
 
-      g_checksum_update (checksum, gimp_temp_buf_get_data (pattern->mask),
-                         gimp_temp_buf_get_data_size (pattern->mask));
+      g_checksum_update (checksum, gimp_temp_buf_get_data (mask),
+                         gimp_temp_buf_get_data_size (mask));
 
       checksum_string = g_strdup (g_checksum_get_string (checksum));
 
@@ -263,18 +304,98 @@ gimp_pattern_get_standard (GimpContext *context)
   return standard_pattern;
 }
 
+/*  returns NULL if the pixels could not be loaded; masks loaded on
+ *  demand may be dropped again later, so don't keep them around
+ *  without a reference
+ */
 GimpTempBuf *
 gimp_pattern_get_mask (const GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return pattern->mask;
+  /*  loading the pixels on demand doesn't change the pattern  */
+  return gimp_pattern_ensure_mask ((GimpPattern *) pattern);
 }
 
 GeglBuffer *
 gimp_pattern_create_buffer (const GimpPattern *pattern)
 {
+  GimpTempBuf *mask;
+
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return gimp_temp_buf_create_buffer (pattern->mask);
+  mask = gimp_pattern_get_mask (pattern);
+
+  if (! mask)
+    return NULL;
+
+  return gimp_temp_buf_create_buffer (mask);
+}
+
+
+/*  private functions  */
+
+static GimpTempBuf *
+gimp_pattern_ensure_mask (GimpPattern *pattern)
+{
+  GError *error = NULL;
+
+  if (! pattern->mask_offset)
+    return pattern->mask;
+
+  if (pattern->mask)
+    {
+      /*  move the pattern to the front of the cache  */
+      if (mask_cache.head->data != pattern)
+        {
+          g_queue_remove (&mask_cache, pattern);
+          g_queue_push_head (&mask_cache, pattern);
+        }
+
+      return pattern->mask;
+    }
+
+  if (! gimp_pattern_load_mask (pattern,
+                                gimp_data_get_filename (GIMP_DATA (pattern)),
+                                &error))
+    {
+      g_message (_("Failed to load the pixels of pattern '%s': %s"),
+                 gimp_object_get_name (pattern), error->message);
+      g_clear_error (&error);
+
+      /*  don't try again, the pattern stays without pixels  */
+      pattern->mask_offset = 0;
+
+      return NULL;
+    }
+
+  g_queue_push_head (&mask_cache, pattern);
+  mask_cache_size += gimp_temp_buf_get_data_size (pattern->mask);
+
+  /*  drop unused pixels later, callers may still be using masks
+   *  they got from gimp_pattern_get_mask() without a reference
+   */
+  if (mask_cache_size > GIMP_PATTERN_MASK_CACHE_SIZE && ! mask_cache_idle)
+    mask_cache_idle = g_idle_add (gimp_pattern_mask_cache_trim, NULL);
+
+  return pattern->mask;
+}
+
+static gboolean
+gimp_pattern_mask_cache_trim (gpointer data)
+{
+  while (mask_cache_size > GIMP_PATTERN_MASK_CACHE_SIZE &&
+         mask_cache.length > 1)
+    {
+      GimpPattern *pattern = g_queue_pop_tail (&mask_cache);
+
+      mask_cache_size -= gimp_temp_buf_get_data_size (pattern->mask);
+
+      gimp_temp_buf_unref (pattern->mask);
+      pattern->mask = NULL;
+    }
+
+  mask_cache_idle = 0;
+
+  return FALSE;
 }
@@ -37,6 +37,14 @@ struct _GimpPattern
   GimpData     parent_instance;
 
   GimpTempBuf *mask;
+
+  /*  patterns loaded from .pat files read their pixels on first use
+   *  and drop them again when they haven't been used for a while
+   */
+  gint         mask_width;
+  gint         mask_height;
+  const Babl  *mask_format;
+  goffset      mask_offset;
 };
 
 struct _GimpPatternClass
@@ -27,6 +27,7 @@
 #include "base/tile-manager.h"
 #include "base/tile-pyramid.h"
 
+#include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
@@ -38,6 +39,8 @@
 #include "gimpprojection.h"
 #include "gimpprojection-construct.h"
 
+#include "gimp-trace.h"
+
 
 /*  halfway between G_PRIORITY_HIGH_IDLE and G_PRIORITY_DEFAULT_IDLE  */
 #define  GIMP_PROJECTION_IDLE_PRIORITY  150
@@ -82,6 +85,7 @@ static void        gimp_projection_flush_whenever        (GimpProjection  *proj,
 static void        gimp_projection_idle_render_init      (GimpProjection  *proj);
 static gboolean    gimp_projection_idle_render_callback  (gpointer         data);
 static gboolean    gimp_projection_idle_render_next_area (GimpProjection  *proj);
+static TilePyramid * gimp_projection_get_pyramid         (GimpProjection  *proj);
 static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gboolean         now,
                                                           gint             x,
@@ -153,6 +157,7 @@ gimp_projection_init (GimpProjection *proj)
   proj->update_areas             = NULL;
   proj->idle_render.idle_id      = 0;
   proj->idle_render.update_areas = NULL;
+  proj->constructed_pixels       = 0;
 }
 
 static void
@@ -228,9 +233,10 @@ gimp_projection_get_memsize (GimpObject *object,
 
 /**
  * gimp_projection_estimate_memsize:
- * @type:   the image base type
- * @width:  projection width
- * @height: projection height
+ * @type:      the image base type
+ * @precision: the image precision
+ * @width:     projection width
+ * @height:    projection height
  *
  * Calculates a rough estimate of the memory that is required for the
  * projection of an image with the given @width and @height.
@@ -239,24 +245,36 @@ gimp_projection_get_memsize (GimpObject *object,
  **/
 gint64
 gimp_projection_estimate_memsize (GimpImageBaseType type,
+                                  GimpPrecision     precision,
                                   gint              width,
                                   gint              height)
 {
-  gint64 bytes = 0;
+  const Babl *format = NULL;
+  gint64      bytes;
+  gint64      display_bytes;
 
   switch (type)
     {
     case GIMP_RGB:
     case GIMP_INDEXED:
-      bytes = 4;
+      format = gimp_babl_format (GIMP_RGB, precision, TRUE);
       break;
 
     case GIMP_GRAY:
-      bytes = 2;
+      format = gimp_babl_format (GIMP_GRAY, precision, TRUE);
       break;
     }
 
-  /* The pyramid levels constitute a geometric sum with a ratio of 1/4. */
+  bytes         = babl_format_get_bytes_per_pixel (format);
+  display_bytes = babl_format_get_n_components (format);
+
+  /* The pyramid levels constitute a geometric sum with a ratio of 1/4.
+   * Above 8 bits, they are all in addition to the bottom level, which
+   * gets an 8-bit copy for display.
+   */
+  if (precision != GIMP_PRECISION_U8)
+    return (bytes + display_bytes * 1.33) * (gint64) width * (gint64) height;
+
   return bytes * (gint64) width * (gint64) height * 1.33;
 }
 
@@ -303,9 +321,11 @@ gimp_projection_get_buffer (GimpPickable *pickable)
 
   if (! proj->buffer)
     {
-      TileManager *tiles  = gimp_projection_get_tiles_at_level (proj, 0, NULL);
+      TileManager *tiles;
       const Babl  *format = gimp_projection_get_format (pickable);
 
+      tiles = tile_pyramid_get_base_tiles (gimp_projection_get_pyramid (proj));
+
       proj->buffer = gimp_tile_manager_create_buffer (tiles, format);
 
       if (proj->sink_node)
@@ -406,6 +426,19 @@ gimp_projection_get_sink_node (GimpProjection *proj)
   return proj->sink_node;
 }
 
+/**
+ * gimp_projection_get_tiles_at_level:
+ * @proj:       pointer to a GimpProjection
+ * @level:      the pyramid level
+ * @is_premult: location to store whether the pixel data has the alpha
+ *              channel pre-multiplied or not
+ *
+ * Returns the projection's tiles at @level for display, with 8 bits
+ * per channel regardless of the image precision. Use the projection's
+ * #GeglBuffer to access the pixels at full precision.
+ *
+ * Return value: the tiles of the given level.
+ **/
 TileManager *
 gimp_projection_get_tiles_at_level (GimpProjection *proj,
                                     gint            level,
@@ -413,26 +446,8 @@ gimp_projection_get_tiles_at_level (GimpProjection *proj,
 {
   g_return_val_if_fail (GIMP_IS_PROJECTION (proj), NULL);
 
-  if (! proj->pyramid)
-    {
-      const Babl *format;
-      gint        bytes;
-      gint        width;
-      gint        height;
-
-      format = gimp_projection_get_format (GIMP_PICKABLE (proj));
-
-      bytes = babl_format_get_bytes_per_pixel (format);
-      gimp_projectable_get_size (proj->projectable, &width, &height);
-
-      proj->pyramid = tile_pyramid_new (bytes, width, height);
-
-      tile_pyramid_set_validate_proc (proj->pyramid,
-                                      (TileValidateProc) gimp_projection_validate_tile,
-                                      proj);
-    }
-
-  return tile_pyramid_get_tiles (proj->pyramid, level, is_premult);
+  return tile_pyramid_get_tiles (gimp_projection_get_pyramid (proj),
+                                 level, is_premult);
 }
 
 /**
@@ -493,6 +508,42 @@ gimp_projection_finish_draw (GimpProjection *proj)
     }
 }
 
+/*  returns the number of pixels which are waiting to be rendered  */
+gint64
+gimp_projection_get_pending_area (GimpProjection *proj)
+{
+  GSList *list;
+  gint64  area = 0;
+
+  g_return_val_if_fail (GIMP_IS_PROJECTION (proj), 0);
+
+  for (list = proj->update_areas; list; list = g_slist_next (list))
+    {
+      GimpArea *a = list->data;
+
+      area += (gint64) (a->x2 - a->x1) * (a->y2 - a->y1);
+    }
+
+  if (proj->idle_render.idle_id)
+    {
+      for (list = proj->idle_render.update_areas;
+           list;
+           list = g_slist_next (list))
+        {
+          GimpArea *a = list->data;
+
+          area += (gint64) (a->x2 - a->x1) * (a->y2 - a->y1);
+        }
+
+      /*  the rows of the current area which aren't rendered yet  */
+      area += (gint64) proj->idle_render.width *
+              (proj->idle_render.base_y + proj->idle_render.height -
+               proj->idle_render.y);
+    }
+
+  return area;
+}
+
 
 /*  private functions  */
 
@@ -658,9 +709,13 @@ gimp_projection_idle_render_callback (gpointer data)
       workh = proj->idle_render.base_y + proj->idle_render.height - worky;
     }
 
+  GIMP_TRACE_BEGIN ("projection", "idle-render");
+
   gimp_projection_paint_area (proj, TRUE /* sic! */,
                               workx, worky, workw, workh);
 
+  GIMP_TRACE_END ("projection", "idle-render");
+
   proj->idle_render.x += CHUNK_WIDTH;
 
   if (proj->idle_render.x >=
@@ -719,6 +774,37 @@ gimp_projection_idle_render_next_area (GimpProjection *proj)
   return TRUE;
 }
 
+static TilePyramid *
+gimp_projection_get_pyramid (GimpProjection *proj)
+{
+  if (! proj->pyramid)
+    {
+      const Babl *format;
+      const Babl *display_format;
+      gint        width;
+      gint        height;
+
+      format = gimp_projection_get_format (GIMP_PICKABLE (proj));
+
+      /*  the projection is composited at the image's precision, only
+       *  the tiles used for display are converted to 8 bits
+       */
+      display_format = gimp_babl_format (gimp_babl_format_get_base_type (format),
+                                         GIMP_PRECISION_U8,
+                                         babl_format_has_alpha (format));
+
+      gimp_projectable_get_size (proj->projectable, &width, &height);
+
+      proj->pyramid = tile_pyramid_new (format, display_format, width, height);
+
+      tile_pyramid_set_validate_proc (proj->pyramid,
+                                      (TileValidateProc) gimp_projection_validate_tile,
+                                      proj);
+    }
+
+  return proj->pyramid;
+}
+
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
@@ -828,8 +914,14 @@ gimp_projection_validate_tile (TileManager    *tm,
       additional[n_additional++] = t;
     }
 
+  GIMP_TRACE_BEGIN ("projection", "construct");
+
   gimp_projection_construct (proj, x, y, width, height);
 
+  GIMP_TRACE_END ("projection", "construct");
+
+  proj->constructed_pixels += (guint64) width * height;
+
   for (i = 0; i < n_additional; i++)
     {
       /*  HACK: mark the tile as valid, because we know it is  */
@@ -65,6 +65,8 @@ struct _GimpProjection
   GimpProjectionIdleRender  idle_render;
 
   gboolean                  invalidate_preview;
+
+  guint64                   constructed_pixels;
 };
 
 struct _GimpProjectionClass
@@ -98,7 +100,10 @@ void             gimp_projection_flush            (GimpProjection       *proj);
 void             gimp_projection_flush_now        (GimpProjection       *proj);
 void             gimp_projection_finish_draw      (GimpProjection       *proj);
 
+gint64           gimp_projection_get_pending_area (GimpProjection       *proj);
+
 gint64           gimp_projection_estimate_memsize (GimpImageBaseType     type,
+                                                   GimpPrecision         precision,
                                                    gint                  width,
                                                    gint                  height);
 
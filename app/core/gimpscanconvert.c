@@ -55,6 +55,59 @@ struct _GimpScanConvert
 };
 
 
+/*  the path's extents are divided into cells of this size, to find
+ *  the parts of a fill that don't need to be rasterized
+ */
+#define SCAN_CONVERT_CELL_SIZE 64
+
+typedef enum
+{
+  SCAN_CONVERT_CELL_UNKNOWN,
+  SCAN_CONVERT_CELL_EDGE,
+  SCAN_CONVERT_CELL_EMPTY,
+  SCAN_CONVERT_CELL_FULL
+} ScanConvertCell;
+
+typedef struct
+{
+  gint    x;
+  gint    y;
+  gint    n_cols;
+  gint    n_rows;
+  guchar *cells;
+} ScanConvertCells;
+
+
+static void  gimp_scan_convert_setup        (GimpScanConvert     *sc,
+                                             cairo_t             *cr,
+                                             cairo_path_t        *path,
+                                             gboolean             antialias,
+                                             gdouble              value);
+static void  gimp_scan_convert_get_extents  (GimpScanConvert     *sc,
+                                             cairo_path_t        *path,
+                                             gint                 off_x,
+                                             gint                 off_y,
+                                             GeglRectangle       *extents);
+static void  gimp_scan_convert_render_area  (GimpScanConvert     *sc,
+                                             cairo_path_t        *path,
+                                             guchar              *data,
+                                             const GeglRectangle *roi,
+                                             gint                 bpp,
+                                             gint                 off_x,
+                                             gint                 off_y,
+                                             gboolean             antialias,
+                                             gdouble              value);
+
+static ScanConvertCells * gimp_scan_convert_cells_new  (GimpScanConvert     *sc,
+                                                        cairo_path_t        *path,
+                                                        gint                 off_x,
+                                                        gint                 off_y,
+                                                        const GeglRectangle *extents);
+static void               gimp_scan_convert_cells_free (ScanConvertCells    *cells);
+static ScanConvertCell    gimp_scan_convert_cells_get  (ScanConvertCells    *cells,
+                                                        const GeglRectangle *roi);
+
+
 /*  public functions  */
 
 /**
@@ -451,9 +504,10 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
   const Babl         *format;
   GeglBufferIterator *iter;
   GeglRectangle      *roi;
-  cairo_t            *cr;
-  cairo_surface_t    *surface;
+  GeglRectangle       extents;
+  ScanConvertCells   *cells = NULL;
   cairo_path_t        path;
+  guchar              full_value;
   gint                bpp;
   gint                x, y;
   gint                width, height;
@@ -476,115 +530,476 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
   path.data     = (cairo_path_data_t *) sc->path_data->data;
   path.num_data = sc->path_data->len;
 
+  /*  everything outside the path's extents is left alone, or cleared
+   *  in one go when replacing the buffer's content
+   */
+  if (replace)
+    gegl_buffer_clear (buffer, NULL);
+
+  gimp_scan_convert_get_extents (sc, &path, off_x, off_y, &extents);
+
+  if (! gimp_rectangle_intersect (extents.x, extents.y,
+                                  extents.width, extents.height,
+                                  0, 0,
+                                  gegl_buffer_get_width  (buffer),
+                                  gegl_buffer_get_height (buffer),
+                                  &extents.x, &extents.y,
+                                  &extents.width, &extents.height))
+    return;
+
+  /*  for fills, find the areas that no edge of the path passes
+   *  through, they are either empty or completely covered
+   */
+  if (! sc->do_stroke)
+    cells = gimp_scan_convert_cells_new (sc, &path, off_x, off_y, &extents);
+
+  /*  the value cairo ends up storing in A8 for a fully covered pixel  */
+  full_value = ((guint) (CLAMP (value, 0.0, 1.0) * 65535.0 + 0.5)) >> 8;
+
   format = babl_format ("Y u8");
   bpp    = babl_format_get_bytes_per_pixel (format);
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, format,
-                                   GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
+  iter = gegl_buffer_iterator_new (buffer, &extents, 0, format,
+                                   GEGL_BUFFER_READWRITE, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
   while (gegl_buffer_iterator_next (iter))
     {
-      guchar     *data    = iter->data[0];
-      guchar     *tmp_buf = NULL;
-      const gint  stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
-                                                           roi->width);
-
-      /*  cairo rowstrides are always multiples of 4, whereas
-       *  maskPR.rowstride can be anything, so to be able to create an
-       *  image surface, we maybe have to create our own temporary
-       *  buffer
-       */
-      if (roi->width * bpp != stride)
+      guchar *data = iter->data[0];
+
+      switch (gimp_scan_convert_cells_get (cells, roi))
         {
-          const guchar *src = data;
-          guchar       *dest;
+        case SCAN_CONVERT_CELL_EMPTY:
+          break;
 
-          dest = tmp_buf = g_alloca (stride * roi->height);
+        case SCAN_CONVERT_CELL_FULL:
+          memset (data, full_value, roi->width * roi->height * bpp);
+          break;
 
-          if (! replace)
-            {
-              gint i;
+        default:
+          gimp_scan_convert_render_area (sc, &path, data, roi, bpp,
+                                         off_x, off_y, antialias, value);
+          break;
+        }
+    }
 
-              for (i = 0; i < roi->height; i++)
-                {
-                  memcpy (dest, src, roi->width * bpp);
+  gimp_scan_convert_cells_free (cells);
+}
 
-                  src  += roi->width * bpp;
-                  dest += stride;
-                }
-            }
-        }
 
-      surface = cairo_image_surface_create_for_data (tmp_buf ?
-                                                     tmp_buf : data,
-                                                     CAIRO_FORMAT_A8,
-                                                     roi->width, roi->height,
-                                                     stride);
+/*  private functions  */
+
+static void
+gimp_scan_convert_setup (GimpScanConvert *sc,
+                         cairo_t         *cr,
+                         cairo_path_t    *path,
+                         gboolean         antialias,
+                         gdouble          value)
+{
+  cairo_set_source_rgba (cr, 0, 0, 0, value);
+  cairo_append_path (cr, path);
+
+  cairo_set_antialias (cr, antialias ?
+                       CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
+  cairo_set_miter_limit (cr, sc->miter);
+
+  if (sc->do_stroke)
+    {
+      cairo_set_line_cap (cr,
+                          sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
+                          sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
+                          CAIRO_LINE_CAP_SQUARE);
+      cairo_set_line_join (cr,
+                           sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
+                           sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
+                           CAIRO_LINE_JOIN_BEVEL);
+
+      cairo_set_line_width (cr, sc->width);
+
+      if (sc->dash_info)
+        cairo_set_dash (cr,
+                        (double *) sc->dash_info->data,
+                        sc->dash_info->len,
+                        sc->dash_offset);
+
+      cairo_scale (cr, 1.0, sc->ratio_xy);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    }
+}
+
+/*  computes the area of the buffer that rendering the path may touch  */
+static void
+gimp_scan_convert_get_extents (GimpScanConvert *sc,
+                               cairo_path_t    *path,
+                               gint             off_x,
+                               gint             off_y,
+                               GeglRectangle   *extents)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  gdouble          x1, y1, x2, y2;
+
+  if (path->num_data == 0)
+    {
+      gegl_rectangle_set (extents, 0, 0, 0, 0);
+      return;
+    }
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+  cr = cairo_create (surface);
+
+  gimp_scan_convert_setup (sc, cr, path, TRUE, 1.0);
+
+  if (sc->do_stroke)
+    {
+      gdouble ux1, uy1, ux2, uy2;
+
+      cairo_stroke_extents (cr, &ux1, &uy1, &ux2, &uy2);
+
+      /*  the extents are in user space, which is scaled for strokes  */
+      x1 = ux1; y1 = uy1;
+      x2 = ux2; y2 = uy2;
+      cairo_user_to_device (cr, &x1, &y1);
+      cairo_user_to_device (cr, &x2, &y2);
+    }
+  else
+    {
+      cairo_fill_extents (cr, &x1, &y1, &x2, &y2);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  /*  add a pixel on each side for antialiasing and rounding  */
+  gegl_rectangle_set (extents,
+                      floor (MIN (x1, x2)) - 1 + off_x,
+                      floor (MIN (y1, y2)) - 1 + off_y,
+                      ceil (fabs (x2 - x1)) + 3,
+                      ceil (fabs (y2 - y1)) + 3);
+}
+
+/*  renders the path into one area of the buffer, composing it on top
+ *  of the area's content
+ */
+static void
+gimp_scan_convert_render_area (GimpScanConvert     *sc,
+                               cairo_path_t        *path,
+                               guchar              *data,
+                               const GeglRectangle *roi,
+                               gint                 bpp,
+                               gint                 off_x,
+                               gint                 off_y,
+                               gboolean             antialias,
+                               gdouble              value)
+{
+  cairo_t         *cr;
+  cairo_surface_t *surface;
+  guchar          *tmp_buf = NULL;
+  const gint       stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
+                                                            roi->width);
+
+  /*  cairo rowstrides are always multiples of 4, whereas
+   *  maskPR.rowstride can be anything, so to be able to create an
+   *  image surface, we maybe have to create our own temporary
+   *  buffer
+   */
+  if (roi->width * bpp != stride)
+    {
+      const guchar *src = data;
+      guchar       *dest;
+      gint          i;
 
-      cairo_surface_set_device_offset (surface,
-                                       -off_x - roi->x,
-                                       -off_y - roi->y);
-      cr = cairo_create (surface);
-      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      dest = tmp_buf = g_alloca (stride * roi->height);
 
-      if (replace)
+      for (i = 0; i < roi->height; i++)
         {
-          cairo_set_source_rgba (cr, 0, 0, 0, 0);
-          cairo_paint (cr);
+          memcpy (dest, src, roi->width * bpp);
+
+          src  += roi->width * bpp;
+          dest += stride;
         }
+    }
 
-      cairo_set_source_rgba (cr, 0, 0, 0, value);
-      cairo_append_path (cr, &path);
+  surface = cairo_image_surface_create_for_data (tmp_buf ?
+                                                 tmp_buf : data,
+                                                 CAIRO_FORMAT_A8,
+                                                 roi->width, roi->height,
+                                                 stride);
 
-      cairo_set_antialias (cr, antialias ?
-                           CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
-      cairo_set_miter_limit (cr, sc->miter);
+  cairo_surface_set_device_offset (surface,
+                                   -off_x - roi->x,
+                                   -off_y - roi->y);
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
-      if (sc->do_stroke)
+  gimp_scan_convert_setup (sc, cr, path, antialias, value);
+
+  if (sc->do_stroke)
+    cairo_stroke (cr);
+  else
+    cairo_fill (cr);
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  if (tmp_buf)
+    {
+      guchar       *dest = data;
+      const guchar *src  = tmp_buf;
+      gint          i;
+
+      for (i = 0; i < roi->height; i++)
         {
-          cairo_set_line_cap (cr,
-                              sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
-                              sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
-                              CAIRO_LINE_CAP_SQUARE);
-          cairo_set_line_join (cr,
-                               sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
-                               sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
-                               CAIRO_LINE_JOIN_BEVEL);
-
-          cairo_set_line_width (cr, sc->width);
-
-          if (sc->dash_info)
-            cairo_set_dash (cr,
-                            (double *) sc->dash_info->data,
-                            sc->dash_info->len,
-                            sc->dash_offset);
-
-          cairo_scale (cr, 1.0, sc->ratio_xy);
-          cairo_stroke (cr);
+          memcpy (dest, src, roi->width * bpp);
+
+          src  += stride;
+          dest += roi->width * bpp;
         }
-      else
+    }
+}
+
+/*  marks the cells touched by the bounding box of the line or curve
+ *  with the given control points as edge cells
+ */
+static void
+gimp_scan_convert_cells_mark_edge (ScanConvertCells *cells,
+                                   const gdouble    *xs,
+                                   const gdouble    *ys,
+                                   gint              n_points)
+{
+  gdouble x1 = xs[0], y1 = ys[0];
+  gdouble x2 = xs[0], y2 = ys[0];
+  gint    col1, row1, col2, row2;
+  gint    col, row;
+  gint    i;
+
+  for (i = 1; i < n_points; i++)
+    {
+      x1 = MIN (x1, xs[i]); x2 = MAX (x2, xs[i]);
+      y1 = MIN (y1, ys[i]); y2 = MAX (y2, ys[i]);
+    }
+
+  /*  antialiasing reaches up to a pixel beyond the edge  */
+  x1 = (x1 - 1 - cells->x) / SCAN_CONVERT_CELL_SIZE;
+  y1 = (y1 - 1 - cells->y) / SCAN_CONVERT_CELL_SIZE;
+  x2 = (x2 + 1 - cells->x) / SCAN_CONVERT_CELL_SIZE;
+  y2 = (y2 + 1 - cells->y) / SCAN_CONVERT_CELL_SIZE;
+
+  col1 = CLAMP (floor (x1), 0, cells->n_cols - 1);
+  row1 = CLAMP (floor (y1), 0, cells->n_rows - 1);
+  col2 = CLAMP (floor (x2), 0, cells->n_cols - 1);
+  row2 = CLAMP (floor (y2), 0, cells->n_rows - 1);
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      cells->cells[row * cells->n_cols + col] = SCAN_CONVERT_CELL_EDGE;
+}
+
+/*  sets the state of all unknown cells connected to (col, row)  */
+static void
+gimp_scan_convert_cells_flood (ScanConvertCells *cells,
+                               gint              col,
+                               gint              row,
+                               ScanConvertCell   state)
+{
+  GArray *stack = g_array_new (FALSE, FALSE, sizeof (gint));
+  gint    cell  = row * cells->n_cols + col;
+
+  cells->cells[cell] = state;
+  g_array_append_val (stack, cell);
+
+  while (stack->len > 0)
+    {
+      gint neighbors[4];
+      gint n_neighbors = 0;
+      gint i;
+
+      cell = g_array_index (stack, gint, stack->len - 1);
+      g_array_set_size (stack, stack->len - 1);
+
+      col = cell % cells->n_cols;
+      row = cell / cells->n_cols;
+
+      if (col > 0)                 neighbors[n_neighbors++] = cell - 1;
+      if (col < cells->n_cols - 1) neighbors[n_neighbors++] = cell + 1;
+      if (row > 0)                 neighbors[n_neighbors++] = cell - cells->n_cols;
+      if (row < cells->n_rows - 1) neighbors[n_neighbors++] = cell + cells->n_cols;
+
+      for (i = 0; i < n_neighbors; i++)
         {
-          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-          cairo_fill (cr);
+          if (cells->cells[neighbors[i]] == SCAN_CONVERT_CELL_UNKNOWN)
+            {
+              cells->cells[neighbors[i]] = state;
+              g_array_append_val (stack, neighbors[i]);
+            }
         }
+    }
 
-      cairo_destroy (cr);
-      cairo_surface_destroy (surface);
+  g_array_free (stack, TRUE);
+}
 
-      if (tmp_buf)
+/*  classifies the cells covering @extents (in buffer coordinates)
+ *  into edge cells, which need to be rasterized, and cells that are
+ *  either entirely outside or entirely inside the filled path.  No
+ *  edge passes between two adjacent non-edge cells, so only one
+ *  point of every connected group of them needs to be tested.
+ */
+static ScanConvertCells *
+gimp_scan_convert_cells_new (GimpScanConvert     *sc,
+                             cairo_path_t        *path,
+                             gint                 off_x,
+                             gint                 off_y,
+                             const GeglRectangle *extents)
+{
+  ScanConvertCells *cells;
+  cairo_surface_t  *surface;
+  cairo_t          *cr;
+  gdouble           start_x = 0.0, start_y = 0.0;
+  gdouble           cur_x   = 0.0, cur_y   = 0.0;
+  gint              n_cells;
+  gint              i;
+
+  cells = g_slice_new (ScanConvertCells);
+
+  cells->x      = extents->x;
+  cells->y      = extents->y;
+  cells->n_cols = (extents->width  + SCAN_CONVERT_CELL_SIZE - 1) /
+                  SCAN_CONVERT_CELL_SIZE;
+  cells->n_rows = (extents->height + SCAN_CONVERT_CELL_SIZE - 1) /
+                  SCAN_CONVERT_CELL_SIZE;
+
+  n_cells = cells->n_cols * cells->n_rows;
+
+  cells->cells = g_new0 (guchar, n_cells);
+
+  /*  mark the cells touched by any segment, including the implicit
+   *  closing segment of every subpath
+   */
+  for (i = 0; i < path->num_data; i += path->data[i].header.length)
+    {
+      const cairo_path_data_t *data = &path->data[i];
+      gdouble                  xs[4], ys[4];
+
+      switch (data->header.type)
         {
-          guchar       *dest = data;
-          const guchar *src  = tmp_buf;
-          gint          i;
+        case CAIRO_PATH_MOVE_TO:
+        case CAIRO_PATH_CLOSE_PATH:
+          xs[0] = cur_x;   ys[0] = cur_y;
+          xs[1] = start_x; ys[1] = start_y;
 
-          for (i = 0; i < roi->height; i++)
-            {
-              memcpy (dest, src, roi->width * bpp);
+          if (i > 0)
+            gimp_scan_convert_cells_mark_edge (cells, xs, ys, 2);
 
-              src  += stride;
-              dest += roi->width * bpp;
+          if (data->header.type == CAIRO_PATH_MOVE_TO)
+            {
+              start_x = data[1].point.x + off_x;
+              start_y = data[1].point.y + off_y;
             }
+
+          cur_x = start_x;
+          cur_y = start_y;
+          break;
+
+        case CAIRO_PATH_LINE_TO:
+          xs[0] = cur_x;
+          ys[0] = cur_y;
+          xs[1] = cur_x = data[1].point.x + off_x;
+          ys[1] = cur_y = data[1].point.y + off_y;
+
+          gimp_scan_convert_cells_mark_edge (cells, xs, ys, 2);
+          break;
+
+        case CAIRO_PATH_CURVE_TO:
+          xs[0] = cur_x;
+          ys[0] = cur_y;
+          xs[1] = data[1].point.x + off_x;
+          ys[1] = data[1].point.y + off_y;
+          xs[2] = data[2].point.x + off_x;
+          ys[2] = data[2].point.y + off_y;
+          xs[3] = cur_x = data[3].point.x + off_x;
+          ys[3] = cur_y = data[3].point.y + off_y;
+
+          /*  a bezier segment lies within its control polygon's hull  */
+          gimp_scan_convert_cells_mark_edge (cells, xs, ys, 4);
+          break;
         }
     }
+
+  if (path->num_data > 0)
+    {
+      gdouble xs[2] = { cur_x, start_x };
+      gdouble ys[2] = { cur_y, start_y };
+
+      gimp_scan_convert_cells_mark_edge (cells, xs, ys, 2);
+    }
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+  cr = cairo_create (surface);
+
+  gimp_scan_convert_setup (sc, cr, path, FALSE, 1.0);
+
+  for (i = 0; i < n_cells; i++)
+    {
+      if (cells->cells[i] == SCAN_CONVERT_CELL_UNKNOWN)
+        {
+          gint    col = i % cells->n_cols;
+          gint    row = i / cells->n_cols;
+          gdouble x   = (cells->x + col * SCAN_CONVERT_CELL_SIZE +
+                         SCAN_CONVERT_CELL_SIZE / 2 - off_x);
+          gdouble y   = (cells->y + row * SCAN_CONVERT_CELL_SIZE +
+                         SCAN_CONVERT_CELL_SIZE / 2 - off_y);
+
+          gimp_scan_convert_cells_flood (cells, col, row,
+                                         cairo_in_fill (cr, x, y) ?
+                                         SCAN_CONVERT_CELL_FULL :
+                                         SCAN_CONVERT_CELL_EMPTY);
+        }
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  return cells;
+}
+
+static void
+gimp_scan_convert_cells_free (ScanConvertCells *cells)
+{
+  if (cells)
+    {
+      g_free (cells->cells);
+      g_slice_free (ScanConvertCells, cells);
+    }
+}
+
+/*  returns the common state of the cells @roi overlaps, or
+ *  SCAN_CONVERT_CELL_EDGE if they differ
+ */
+static ScanConvertCell
+gimp_scan_convert_cells_get (ScanConvertCells    *cells,
+                             const GeglRectangle *roi)
+{
+  ScanConvertCell state;
+  gint            col1, row1, col2, row2;
+  gint            col, row;
+
+  if (! cells)
+    return SCAN_CONVERT_CELL_EDGE;
+
+  col1 = (roi->x - cells->x) / SCAN_CONVERT_CELL_SIZE;
+  row1 = (roi->y - cells->y) / SCAN_CONVERT_CELL_SIZE;
+  col2 = (roi->x + roi->width  - 1 - cells->x) / SCAN_CONVERT_CELL_SIZE;
+  row2 = (roi->y + roi->height - 1 - cells->y) / SCAN_CONVERT_CELL_SIZE;
+
+  state = cells->cells[row1 * cells->n_cols + col1];
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      if (cells->cells[row * cells->n_cols + col] != state)
+        return SCAN_CONVERT_CELL_EDGE;
+
+  return state;
 }
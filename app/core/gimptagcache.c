@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include <gegl.h>
+#include <glib/gstdio.h>
 
 #include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
@@ -61,6 +62,8 @@ typedef struct
   GQuark  identifier;
   GQuark  checksum;
   GList  *tags;
+  gint64  mtime;      /* modification time and size of the file the  */
+  gint64  size;       /* checksum was computed from, 0 if unknown    */
   guint   referenced : 1;
 } GimpTagCacheRecord;
 
@@ -70,10 +73,18 @@ typedef struct
   GimpTagCacheRecord  current_record;
 } GimpTagCacheParseData;
 
+typedef struct
+{
+  GimpTagCache       *cache;
+  GList              *records;
+} GimpTagCacheSaveData;
+
 struct _GimpTagCachePriv
 {
-  GArray *records;
-  GList  *containers;
+  GArray     *records;
+  GHashTable *identifier_index; /* identifier quark -> record index + 1 */
+  GHashTable *checksum_index;   /* checksum quark   -> record index + 1 */
+  GList      *containers;
 };
 
 
@@ -85,6 +96,13 @@ static void          gimp_tag_cache_object_initialize  (GimpTagged             *
                                                         GimpTagCache           *cache);
 static void          gimp_tag_cache_add_object         (GimpTagCache           *cache,
                                                         GimpTagged             *tagged);
+static void          gimp_tag_cache_index_record       (GimpTagCache           *cache,
+                                                        gint                    i);
+static gint          gimp_tag_cache_lookup             (GHashTable             *table,
+                                                        GQuark                  quark);
+static gboolean      gimp_tag_cache_get_file_info      (GimpTagged             *tagged,
+                                                        gint64                 *mtime,
+                                                        gint64                 *size);
 
 static void          gimp_tag_cache_load_start_element (GMarkupParseContext    *context,
                                                         const gchar            *element_name,
@@ -139,9 +157,13 @@ gimp_tag_cache_init (GimpTagCache *cache)
                                              GIMP_TYPE_TAG_CACHE,
                                              GimpTagCachePriv);
 
-  cache->priv->records    = g_array_new (FALSE, FALSE,
-                                         sizeof (GimpTagCacheRecord));
-  cache->priv->containers = NULL;
+  cache->priv->records          = g_array_new (FALSE, FALSE,
+                                               sizeof (GimpTagCacheRecord));
+  cache->priv->identifier_index = g_hash_table_new (g_direct_hash,
+                                                    g_direct_equal);
+  cache->priv->checksum_index   = g_hash_table_new (g_direct_hash,
+                                                    g_direct_equal);
+  cache->priv->containers       = NULL;
 }
 
 static void
@@ -165,6 +187,18 @@ gimp_tag_cache_finalize (GObject *object)
       cache->priv->records = NULL;
     }
 
+  if (cache->priv->identifier_index)
+    {
+      g_hash_table_unref (cache->priv->identifier_index);
+      cache->priv->identifier_index = NULL;
+    }
+
+  if (cache->priv->checksum_index)
+    {
+      g_hash_table_unref (cache->priv->checksum_index);
+      cache->priv->checksum_index = NULL;
+    }
+
   if (cache->priv->containers)
     {
       g_list_free (cache->priv->containers);
@@ -183,6 +217,8 @@ gimp_tag_cache_get_memsize (GimpObject *object,
 
   memsize += gimp_g_list_get_memsize (cache->priv->containers, 0);
   memsize += cache->priv->records->len * sizeof (GimpTagCacheRecord);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->identifier_index, 0);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->checksum_index, 0);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -236,77 +272,161 @@ static void
 gimp_tag_cache_add_object (GimpTagCache *cache,
                            GimpTagged   *tagged)
 {
-  gchar  *identifier;
-  GQuark  identifier_quark = 0;
-  gchar  *checksum;
-  GQuark  checksum_quark = 0;
-  GList  *list;
-  gint    i;
+  GimpTagCacheRecord *rec;
+  gchar              *identifier;
+  GQuark              identifier_quark = 0;
+  gchar              *checksum;
+  GQuark              checksum_quark = 0;
+  GList              *list;
+  gint                i;
 
   identifier = gimp_tagged_get_identifier (tagged);
 
   if (identifier)
     {
-      identifier_quark = g_quark_try_string (identifier);
+      identifier_quark = g_quark_from_string (identifier);
       g_free (identifier);
     }
 
-  if (identifier_quark)
+  i = gimp_tag_cache_lookup (cache->priv->identifier_index, identifier_quark);
+
+  if (i < 0)
     {
-      for (i = 0; i < cache->priv->records->len; i++)
+      /*  only compute the (possibly expensive) checksum when the
+       *  identifier isn't known
+       */
+      checksum = gimp_tagged_get_checksum (tagged);
+
+      if (checksum)
         {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
+          checksum_quark = g_quark_from_string (checksum);
+          g_free (checksum);
+        }
 
-          if (rec->identifier == identifier_quark)
-            {
-              for (list = rec->tags; list; list = g_list_next (list))
-                {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
-                }
+      i = gimp_tag_cache_lookup (cache->priv->checksum_index, checksum_quark);
 
-              rec->referenced = TRUE;
-              return;
-            }
+      if (i < 0 && ! identifier_quark)
+        return;
+
+      if (i < 0)
+        {
+          GimpTagCacheRecord new_rec = { 0, };
+
+          /*  remember the checksum, so it doesn't need to be
+           *  computed again when saving the cache.  The record has
+           *  no tags to hand out, so it isn't indexed by checksum.
+           */
+          new_rec.identifier = identifier_quark;
+          new_rec.checksum   = checksum_quark;
+          new_rec.referenced = TRUE;
+
+          gimp_tag_cache_get_file_info (tagged, &new_rec.mtime, &new_rec.size);
+
+          g_array_append_val (cache->priv->records, new_rec);
+
+          g_hash_table_insert (cache->priv->identifier_index,
+                               GUINT_TO_POINTER (identifier_quark),
+                               GINT_TO_POINTER (cache->priv->records->len));
+
+          return;
+        }
+
+      rec = &g_array_index (cache->priv->records, GimpTagCacheRecord, i);
+
+#if DEBUG_GIMP_TAG_CACHE
+      g_printerr ("remapping identifier: %s ==> %s\n",
+                  rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
+                  g_quark_to_string (identifier_quark));
+#endif
+
+      if (gimp_tag_cache_lookup (cache->priv->identifier_index,
+                                 rec->identifier) == i)
+        {
+          g_hash_table_remove (cache->priv->identifier_index,
+                               GUINT_TO_POINTER (rec->identifier));
         }
+
+      rec->identifier = identifier_quark;
+
+      gimp_tag_cache_get_file_info (tagged, &rec->mtime, &rec->size);
+      gimp_tag_cache_index_record (cache, i);
     }
 
-  checksum = gimp_tagged_get_checksum (tagged);
+  rec = &g_array_index (cache->priv->records, GimpTagCacheRecord, i);
 
-  if (checksum)
+  for (list = rec->tags; list; list = g_list_next (list))
     {
-      checksum_quark = g_quark_try_string (checksum);
-      g_free (checksum);
+      gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
     }
 
-  if (checksum_quark)
+  rec->referenced = TRUE;
+}
+
+/*  adds the record at @i to the identifier and checksum indices,
+ *  unless an earlier record with the same identifier or checksum exists
+ */
+static void
+gimp_tag_cache_index_record (GimpTagCache *cache,
+                             gint          i)
+{
+  GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                            GimpTagCacheRecord, i);
+
+  if (rec->identifier &&
+      gimp_tag_cache_lookup (cache->priv->identifier_index,
+                             rec->identifier) < 0)
     {
-      for (i = 0; i < cache->priv->records->len; i++)
-        {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
+      g_hash_table_insert (cache->priv->identifier_index,
+                           GUINT_TO_POINTER (rec->identifier),
+                           GINT_TO_POINTER (i + 1));
+    }
 
-          if (rec->checksum == checksum_quark)
-            {
-#if DEBUG_GIMP_TAG_CACHE
-              g_printerr ("remapping identifier: %s ==> %s\n",
-                          rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
-                          identifier_quark ? g_quark_to_string (identifier_quark) : "(NULL)");
-#endif
+  if (rec->checksum &&
+      gimp_tag_cache_lookup (cache->priv->checksum_index,
+                             rec->checksum) < 0)
+    {
+      g_hash_table_insert (cache->priv->checksum_index,
+                           GUINT_TO_POINTER (rec->checksum),
+                           GINT_TO_POINTER (i + 1));
+    }
+}
 
-              rec->identifier = identifier_quark;
+/*  returns the index of the record @quark maps to in @table, or -1  */
+static gint
+gimp_tag_cache_lookup (GHashTable *table,
+                       GQuark      quark)
+{
+  if (! quark)
+    return -1;
 
-              for (list = rec->tags; list; list = g_list_next (list))
-                {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
-                }
+  return GPOINTER_TO_INT (g_hash_table_lookup (table,
+                                               GUINT_TO_POINTER (quark))) - 1;
+}
 
-              rec->referenced = TRUE;
-              return;
-            }
-        }
-    }
+/*  gets the modification time and size of the file @tagged was
+ *  loaded from, these tell whether a cached checksum is still valid
+ */
+static gboolean
+gimp_tag_cache_get_file_info (GimpTagged *tagged,
+                              gint64     *mtime,
+                              gint64     *size)
+{
+  struct stat  filestat;
+  const gchar *filename = NULL;
+
+  *mtime = 0;
+  *size  = 0;
+
+  if (GIMP_IS_DATA (tagged))
+    filename = gimp_data_get_filename (GIMP_DATA (tagged));
+
+  if (! filename || g_stat (filename, &filestat) != 0)
+    return FALSE;
+
+  *mtime = filestat.st_mtime;
+  *size  = filestat.st_size;
 
+  return TRUE;
 }
 
 static void
@@ -317,25 +437,52 @@ gimp_tag_cache_object_initialize (GimpTagged   *tagged,
 }
 
 static void
-gimp_tag_cache_tagged_to_cache_record_foreach (GimpTagged  *tagged,
-                                               GList      **cache_records)
+gimp_tag_cache_tagged_to_cache_record_foreach (GimpTagged             *tagged,
+                                               GimpTagCacheSaveData   *save_data)
 {
   gchar *identifier = gimp_tagged_get_identifier (tagged);
 
   if (identifier)
     {
-      GimpTagCacheRecord *cache_rec = g_new (GimpTagCacheRecord, 1);
-      gchar              *checksum;
-
-      checksum = gimp_tagged_get_checksum (tagged);
+      GimpTagCache       *cache     = save_data->cache;
+      GimpTagCacheRecord *cache_rec = g_new0 (GimpTagCacheRecord, 1);
+      gboolean            have_info;
+      gint                i;
 
       cache_rec->identifier = g_quark_from_string (identifier);
-      cache_rec->checksum   = g_quark_from_string (checksum);
       cache_rec->tags       = g_list_copy (gimp_tagged_get_tags (tagged));
 
-      g_free (checksum);
+      have_info = gimp_tag_cache_get_file_info (tagged,
+                                                &cache_rec->mtime,
+                                                &cache_rec->size);
+
+      i = gimp_tag_cache_lookup (cache->priv->identifier_index,
+                                 cache_rec->identifier);
 
-      *cache_records = g_list_prepend (*cache_records, cache_rec);
+      /*  reuse the known checksum if the file didn't change since  */
+      if (i >= 0 && have_info &&
+          ! (GIMP_IS_DATA (tagged) && gimp_data_is_dirty (GIMP_DATA (tagged))))
+        {
+          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                                    GimpTagCacheRecord, i);
+
+          if (rec->checksum                &&
+              rec->mtime == cache_rec->mtime &&
+              rec->size  == cache_rec->size)
+            {
+              cache_rec->checksum = rec->checksum;
+            }
+        }
+
+      if (! cache_rec->checksum)
+        {
+          gchar *checksum = gimp_tagged_get_checksum (tagged);
+
+          cache_rec->checksum = g_quark_from_string (checksum);
+          g_free (checksum);
+        }
+
+      save_data->records = g_list_prepend (save_data->records, cache_rec);
     }
 
   g_free (identifier);
@@ -350,12 +497,13 @@ gimp_tag_cache_tagged_to_cache_record_foreach (GimpTagged  *tagged,
 void
 gimp_tag_cache_save (GimpTagCache *cache)
 {
-  GString *buf;
-  GList   *saved_records;
-  GList   *iterator;
-  gchar   *filename;
-  GError  *error = NULL;
-  gint     i;
+  GimpTagCacheSaveData  save_data;
+  GString              *buf;
+  GList                *saved_records;
+  GList                *iterator;
+  gchar                *filename;
+  GError               *error = NULL;
+  gint                  i;
 
   g_return_if_fail (GIMP_IS_TAG_CACHE (cache));
 
@@ -375,21 +523,26 @@ gimp_tag_cache_save (GimpTagCache *cache)
           record_copy->identifier = current_record->identifier;
           record_copy->checksum   = current_record->checksum;
           record_copy->tags       = g_list_copy (current_record->tags);
+          record_copy->mtime      = current_record->mtime;
+          record_copy->size       = current_record->size;
 
           saved_records = g_list_prepend (saved_records, record_copy);
         }
     }
 
+  save_data.cache   = cache;
+  save_data.records = saved_records;
+
   for (iterator = cache->priv->containers;
        iterator;
        iterator = g_list_next (iterator))
     {
       gimp_container_foreach (GIMP_CONTAINER (iterator->data),
                               (GFunc) gimp_tag_cache_tagged_to_cache_record_foreach,
-                              &saved_records);
+                              &save_data);
     }
 
-  saved_records = g_list_reverse (saved_records);
+  saved_records = g_list_reverse (save_data.records);
 
   buf = g_string_new ("");
   g_string_append (buf, "<?xml version='1.0' encoding='UTF-8'?>\n");
@@ -403,11 +556,18 @@ gimp_tag_cache_save (GimpTagCache *cache)
       gchar              *tag_string;
 
       identifier_string = g_markup_escape_text (g_quark_to_string (cache_rec->identifier), -1);
-      g_string_append_printf (buf, "\n  <resource identifier=\"%s\" checksum=\"%s\">\n",
+      g_string_append_printf (buf, "\n  <resource identifier=\"%s\" checksum=\"%s\"",
                               identifier_string,
                               g_quark_to_string (cache_rec->checksum));
       g_free (identifier_string);
 
+      if (cache_rec->mtime || cache_rec->size)
+        g_string_append_printf (buf, " mtime=\"%" G_GINT64_FORMAT "\""
+                                " size=\"%" G_GINT64_FORMAT "\"",
+                                cache_rec->mtime, cache_rec->size);
+
+      g_string_append (buf, ">\n");
+
       for (tag_iterator = cache_rec->tags;
            tag_iterator;
            tag_iterator = g_list_next (tag_iterator))
@@ -471,6 +631,8 @@ gimp_tag_cache_load (GimpTagCache *cache)
 
   /* clear any previous priv->records */
   cache->priv->records = g_array_set_size (cache->priv->records, 0);
+  g_hash_table_remove_all (cache->priv->identifier_index);
+  g_hash_table_remove_all (cache->priv->checksum_index);
 
   filename = g_build_filename (gimp_directory (), GIMP_TAG_CACHE_FILE, NULL);
 
@@ -487,9 +649,14 @@ gimp_tag_cache_load (GimpTagCache *cache)
 
   if (gimp_xml_parser_parse_file (xml_parser, filename, &error))
     {
+      gint i;
+
       cache->priv->records = g_array_append_vals (cache->priv->records,
                                                   parse_data.records->data,
                                                   parse_data.records->len);
+
+      for (i = 0; i < cache->priv->records->len; i++)
+        gimp_tag_cache_index_record (cache, i);
     }
   else
     {
@@ -516,6 +683,8 @@ gimp_tag_cache_load_start_element (GMarkupParseContext *context,
     {
       const gchar *identifier;
       const gchar *checksum;
+      const gchar *mtime;
+      const gchar *size;
 
       identifier = gimp_tag_cache_attribute_name_to_value (attribute_names,
                                                            attribute_values,
@@ -523,6 +692,12 @@ gimp_tag_cache_load_start_element (GMarkupParseContext *context,
       checksum   = gimp_tag_cache_attribute_name_to_value (attribute_names,
                                                            attribute_values,
                                                            "checksum");
+      mtime      = gimp_tag_cache_attribute_name_to_value (attribute_names,
+                                                           attribute_values,
+                                                           "mtime");
+      size       = gimp_tag_cache_attribute_name_to_value (attribute_names,
+                                                           attribute_values,
+                                                           "size");
 
       if (! identifier)
         {
@@ -537,6 +712,12 @@ gimp_tag_cache_load_start_element (GMarkupParseContext *context,
 
       parse_data->current_record.identifier = g_quark_from_string (identifier);
       parse_data->current_record.checksum   = g_quark_from_string (checksum);
+
+      if (mtime && size)
+        {
+          parse_data->current_record.mtime = g_ascii_strtoll (mtime, NULL, 10);
+          parse_data->current_record.size  = g_ascii_strtoll (size, NULL, 10);
+        }
     }
 }
 
@@ -43,6 +43,7 @@
 #include "gimpdisplayshell-expose.h"
 #include "gimpdisplayshell-handlers.h"
 #include "gimpdisplayshell-icon.h"
+#include "gimpdisplayshell-render.h"
 #include "gimpdisplayshell-transform.h"
 #include "gimpimagewindow.h"
 
@@ -901,5 +902,8 @@ gimp_display_paint_area (GimpDisplay *display,
   x2 = ceil (x2_f + 0.5);
   y2 = ceil (y2_f + 0.5);
 
+  gimp_display_shell_render_invalidate_area (shell,
+                                             x1, y1, x2 - x1, y2 - y1);
+
   gimp_display_shell_expose_area (shell, x1, y1, x2 - x1, y2 - y1);
 }
@@ -17,8 +17,11 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gtk/gtk.h>
 
+#include "libgimpcolor/gimpcolor.h"
 #include "libgimpconfig/gimpconfig.h"
 #include "libgimpwidgets/gimpwidgets.h"
 
@@ -31,10 +34,41 @@
 #include "gimpdisplayshell-filter.h"
 
 
+/*  number of grid points per channel of the filter LUT, 33 is what
+ *  lcms uses for its own precalculated 8 bit transforms
+ */
+#define LUT_SIZE 33
+
+
 /*  local function prototypes  */
 
-static void   gimp_display_shell_filter_changed (GimpColorDisplayStack *stack,
-                                                 GimpDisplayShell      *shell);
+static void     gimp_display_shell_filter_changed   (GimpColorDisplayStack *stack,
+                                                     GimpDisplayShell      *shell);
+
+static gboolean gimp_display_shell_filter_use_lut   (GimpDisplayShell      *shell);
+static void     gimp_display_shell_filter_build_lut (GimpDisplayShell      *shell);
+static void     gimp_display_shell_filter_apply_lut (const guchar          *lut,
+                                                     cairo_surface_t       *surface);
+
+
+/*  display filters that map each pixel's color independently of all
+ *  other pixels, and can therefore be folded into a single 3D LUT.
+ *  Filters doing only a cheap per-channel lookup are not worth a LUT
+ *  on their own.
+ */
+static const struct
+{
+  const gchar *type_name;
+  gboolean     per_channel;
+}
+lut_filters[] =
+{
+  { "CdisplayGamma",      TRUE  },
+  { "CdisplayContrast",   TRUE  },
+  { "CdisplayColorblind", FALSE },
+  { "CdisplayLcms",       FALSE },
+  { "CdisplayProof",      FALSE }
+};
 
 
 /*  public functions  */
@@ -105,6 +139,40 @@ gimp_display_shell_filter_new (GimpDisplayShell *shell,
   return NULL;
 }
 
+/**
+ * gimp_display_shell_filter_convert_surface:
+ * @shell:   a #GimpDisplayShell
+ * @surface: a #cairo_image_surface_t of type ARGB32
+ *
+ * Runs the shell's filter stack on @surface. If all enabled filters
+ * are pure color mappings, they are applied in one pass through a 3D
+ * LUT that is only rebuilt when the stack changes, otherwise each
+ * filter converts the surface on its own.
+ **/
+void
+gimp_display_shell_filter_convert_surface (GimpDisplayShell *shell,
+                                           cairo_surface_t  *surface)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (surface != NULL);
+
+  if (! shell->filter_stack)
+    return;
+
+  if (cairo_image_surface_get_format (surface) == CAIRO_FORMAT_ARGB32 &&
+      gimp_display_shell_filter_use_lut (shell))
+    {
+      if (! shell->filter_lut_valid)
+        gimp_display_shell_filter_build_lut (shell);
+
+      gimp_display_shell_filter_apply_lut (shell->filter_lut, surface);
+    }
+  else
+    {
+      gimp_color_display_stack_convert_surface (shell->filter_stack, surface);
+    }
+}
+
 
 /*  private functions  */
 
@@ -123,6 +191,8 @@ static void
 gimp_display_shell_filter_changed (GimpColorDisplayStack *stack,
                                    GimpDisplayShell      *shell)
 {
+  shell->filter_lut_valid = FALSE;
+
   if (shell->filter_idle_id)
     g_source_remove (shell->filter_idle_id);
 
@@ -131,3 +201,201 @@ gimp_display_shell_filter_changed (GimpColorDisplayStack *stack,
                      gimp_display_shell_filter_changed_idle,
                      shell, NULL);
 }
+
+static gboolean
+gimp_display_shell_filter_use_lut (GimpDisplayShell *shell)
+{
+  GList    *list;
+  gint      n_enabled   = 0;
+  gboolean  per_channel = TRUE;
+
+  for (list = shell->filter_stack->filters; list; list = g_list_next (list))
+    {
+      GimpColorDisplay *display = list->data;
+      const gchar      *name;
+      gint              i;
+
+      if (! gimp_color_display_get_enabled (display))
+        continue;
+
+      name = G_OBJECT_TYPE_NAME (display);
+
+      for (i = 0; i < G_N_ELEMENTS (lut_filters); i++)
+        if (! strcmp (name, lut_filters[i].type_name))
+          break;
+
+      /*  unknown filters might not be expressible as a LUT  */
+      if (i == G_N_ELEMENTS (lut_filters))
+        return FALSE;
+
+      if (! lut_filters[i].per_channel)
+        per_channel = FALSE;
+
+      n_enabled++;
+    }
+
+  return n_enabled > 1 || (n_enabled == 1 && ! per_channel);
+}
+
+static inline gint
+lut_grid_value (gint i)
+{
+  return (i * 255 + (LUT_SIZE - 1) / 2) / (LUT_SIZE - 1);
+}
+
+/*  runs the grid colors through the filter stack  */
+static void
+gimp_display_shell_filter_build_lut (GimpDisplayShell *shell)
+{
+  cairo_surface_t *surface;
+  guchar          *data;
+  gint             stride;
+  guchar          *lut;
+  gint             r, g, b;
+
+  if (! shell->filter_lut)
+    shell->filter_lut = g_new (guchar, LUT_SIZE * LUT_SIZE * LUT_SIZE * 3);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        LUT_SIZE * LUT_SIZE, LUT_SIZE);
+
+  data   = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (r = 0; r < LUT_SIZE; r++)
+    for (g = 0; g < LUT_SIZE; g++)
+      for (b = 0; b < LUT_SIZE; b++)
+        {
+          guchar *d = data + r * stride + (g * LUT_SIZE + b) * 4;
+
+          GIMP_CAIRO_ARGB32_SET_PIXEL (d,
+                                       lut_grid_value (r),
+                                       lut_grid_value (g),
+                                       lut_grid_value (b),
+                                       255);
+        }
+
+  cairo_surface_mark_dirty (surface);
+
+  gimp_color_display_stack_convert_surface (shell->filter_stack, surface);
+
+  cairo_surface_flush (surface);
+
+  lut = shell->filter_lut;
+
+  for (r = 0; r < LUT_SIZE; r++)
+    for (g = 0; g < LUT_SIZE; g++)
+      for (b = 0; b < LUT_SIZE; b++)
+        {
+          const guchar *s = data + r * stride + (g * LUT_SIZE + b) * 4;
+          guint         lr, lg, lb, la;
+
+          GIMP_CAIRO_ARGB32_GET_PIXEL (s, lr, lg, lb, la);
+
+          lut[0] = lr;
+          lut[1] = lg;
+          lut[2] = lb;
+
+          lut += 3;
+        }
+
+  cairo_surface_destroy (surface);
+
+  shell->filter_lut_valid = TRUE;
+}
+
+/*  trilinear interpolation in the 3D LUT, in 8 bit fixed point  */
+static void
+gimp_display_shell_filter_apply_lut (const guchar    *lut,
+                                     cairo_surface_t *surface)
+{
+  static gint     lut_index[256];
+  static guint    lut_frac[256];
+  static gboolean initialized = FALSE;
+
+  const gint   stride_r = LUT_SIZE * LUT_SIZE * 3;
+  const gint   stride_g = LUT_SIZE * 3;
+  const gint   stride_b = 3;
+  gint         width    = cairo_image_surface_get_width  (surface);
+  gint         height   = cairo_image_surface_get_height (surface);
+  gint         stride   = cairo_image_surface_get_stride (surface);
+  guchar      *data     = cairo_image_surface_get_data   (surface);
+  gint         x, y;
+
+  if (! initialized)
+    {
+      gint i = 0;
+      gint v;
+
+      for (v = 0; v < 256; v++)
+        {
+          gint lo, hi;
+
+          while (i < LUT_SIZE - 2 && lut_grid_value (i + 1) <= v)
+            i++;
+
+          lo = lut_grid_value (i);
+          hi = lut_grid_value (i + 1);
+
+          lut_index[v] = i;
+          lut_frac[v]  = ((v - lo) * 256 + (hi - lo) / 2) / (hi - lo);
+        }
+
+      initialized = TRUE;
+    }
+
+  cairo_surface_flush (surface);
+
+  for (y = 0; y < height; y++)
+    {
+      guchar *d = data + y * stride;
+
+      for (x = 0; x < width; x++, d += 4)
+        {
+          guint         r, g, b, a;
+          guint         fr, fg, fb;
+          const guchar *c;
+          guint         out[3];
+          gint          i;
+
+          GIMP_CAIRO_ARGB32_GET_PIXEL (d, r, g, b, a);
+
+          if (a == 0)
+            continue;
+
+          fr = lut_frac[r];
+          fg = lut_frac[g];
+          fb = lut_frac[b];
+
+          c = (lut +
+               lut_index[r] * stride_r +
+               lut_index[g] * stride_g +
+               lut_index[b] * stride_b);
+
+          for (i = 0; i < 3; i++)
+            {
+              const guchar *p = c + i;
+              guint         c00, c01, c10, c11;
+              guint         c0, c1;
+
+              c00 = (p[0]                   * (256 - fb) +
+                     p[stride_b]            * fb);
+              c01 = (p[stride_g]            * (256 - fb) +
+                     p[stride_g + stride_b] * fb);
+              c10 = (p[stride_r]            * (256 - fb) +
+                     p[stride_r + stride_b] * fb);
+              c11 = (p[stride_r + stride_g] * (256 - fb) +
+                     p[stride_r + stride_g + stride_b] * fb);
+
+              c0 = (c00 * (256 - fg) + c01 * fg) >> 8;
+              c1 = (c10 * (256 - fg) + c11 * fg) >> 8;
+
+              out[i] = (c0 * (256 - fr) + c1 * fr + (1 << 15)) >> 16;
+            }
+
+          GIMP_CAIRO_ARGB32_SET_PIXEL (d, out[0], out[1], out[2], a);
+        }
+    }
+
+  cairo_surface_mark_dirty (surface);
+}
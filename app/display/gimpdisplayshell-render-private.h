@@ -0,0 +1,41 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DISPLAY_SHELL_RENDER_PRIVATE_H__
+#define __GIMP_DISPLAY_SHELL_RENDER_PRIVATE_H__
+
+
+/*  The footprints of the box filters are scaled into this range  */
+#define GIMP_DISPLAY_RENDER_MIN_FOOTPRINT  256
+#define GIMP_DISPLAY_RENDER_MAX_FOOTPRINT  512
+
+
+/*  The weights of the box filters always add up to the footprint, so
+ *  the filters divide by the same sum for every pixel.  These
+ *  divisions are done as a multiplication with the sum's reciprocal,
+ *  rounded up to RECIPROCAL_SHIFT bits, which gives exactly the same
+ *  quotients for all numerators the filters can produce (less than
+ *  2^44 / sum).
+ */
+#define RECIPROCAL_SHIFT            44
+#define RECIPROCAL(d)               (((G_GUINT64_CONSTANT (1) << RECIPROCAL_SHIFT) + \
+                                      (d) - 1) / (d))
+#define RECIPROCAL_DIVIDE(n, recip) ((guint) (((guint64) (n) * (recip)) >> \
+                                              RECIPROCAL_SHIFT))
+
+
+#endif /* __GIMP_DISPLAY_SHELL_RENDER_PRIVATE_H__ */
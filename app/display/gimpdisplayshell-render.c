@@ -26,10 +26,12 @@
 #include "display-types.h"
 
 #include "base/tile-manager.h"
+#include "base/tile-pyramid.h"
 #include "base/tile.h"
 
 #include "config/gimpdisplayconfig.h"
 
+#include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "core/gimpdrawable.h"
@@ -39,8 +41,10 @@
 
 #include "gimpdisplay.h"
 #include "gimpdisplayshell.h"
+#include "gimpdisplayshell-draw.h"
 #include "gimpdisplayshell-filter.h"
 #include "gimpdisplayshell-render.h"
+#include "gimpdisplayshell-render-private.h"
 #include "gimpdisplayshell-scroll.h"
 
 
@@ -89,6 +93,7 @@ struct _RenderInfo
   gint          footprint_y;
   gint          footshift_x;
   gint          footshift_y;
+  guint64       footprint_recip; /* reciprocal of the box filter's sum */
 
   gint64        dy;
 };
@@ -97,6 +102,25 @@ struct _RenderInfo
 static guchar tile_buf[GIMP_DISPLAY_RENDER_BUF_WIDTH * MAX_CHANNELS];
 
 
+#define RENDER_CACHE_KEY(col, row)  (((gint64) (col) << 32) | (guint32) (row))
+#define RENDER_CACHE_KEY_COL(key)   ((gint) ((key) >> 32))
+#define RENDER_CACHE_KEY_ROW(key)   ((gint) ((key) & 0xffffffff))
+
+
+static void  gimp_display_shell_render_image     (GimpDisplayShell *shell,
+                                                  cairo_surface_t  *surface,
+                                                  gint              x,
+                                                  gint              y,
+                                                  gint              w,
+                                                  gint              h);
+static void  gimp_display_shell_render_cached    (GimpDisplayShell *shell,
+                                                  cairo_t          *cr,
+                                                  gint              x,
+                                                  gint              y,
+                                                  gint              w,
+                                                  gint              h);
+static void  gimp_display_shell_render_cache_trim (GimpDisplayShell *shell);
+
 static void  gimp_display_shell_render_info_init (RenderInfo       *info,
                                                   GimpDisplayShell *shell,
                                                   gint              x,
@@ -131,6 +155,166 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                            gint              y,
                            gint              w,
                            gint              h)
+{
+  TileManager *tiles;
+  RenderInfo   info;
+  gint         level;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (cr != NULL);
+  g_return_if_fail (w > 0 && h > 0);
+
+  /*  the mask is composited on top of each rendered chunk, only the
+   *  plain image goes through the render cache
+   */
+  if (! shell->mask)
+    {
+      gimp_display_shell_render_cached (shell, cr, x, y, w, h);
+      return;
+    }
+
+  gimp_display_shell_render_image (shell, shell->render_surface, x, y, w, h);
+
+  /*  render the mask  */
+  {
+    GeglBuffer *buffer;
+
+    if (! shell->mask_surface)
+      {
+        shell->mask_surface =
+          cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                      GIMP_DISPLAY_RENDER_BUF_WIDTH,
+                                      GIMP_DISPLAY_RENDER_BUF_HEIGHT);
+      }
+
+    buffer = gimp_drawable_get_buffer (shell->mask);
+    tiles = gimp_gegl_buffer_get_tiles (buffer);
+
+    /*  the mask pyramid is built on top of the mask's own tiles,
+     *  recreate it if the mask got a new buffer
+     */
+    if (shell->mask_pyramid &&
+        tile_pyramid_get_tiles (shell->mask_pyramid, 0, NULL) != tiles)
+      {
+        tile_pyramid_destroy (shell->mask_pyramid);
+        shell->mask_pyramid = NULL;
+      }
+
+    if (! shell->mask_pyramid)
+      shell->mask_pyramid = tile_pyramid_new_for_tiles (tiles);
+
+    level = tile_pyramid_get_level (tile_manager_width  (tiles),
+                                    tile_manager_height (tiles),
+                                    MAX (shell->scale_x, shell->scale_y));
+
+    tiles = tile_pyramid_get_tiles (shell->mask_pyramid, level, NULL);
+
+    gimp_display_shell_render_info_init (&info,
+                                         shell, x, y, w, h,
+                                         shell->mask_surface,
+                                         tiles, level, FALSE);
+
+    render_image_alpha (&info);
+
+    cairo_surface_mark_dirty (shell->mask_surface);
+  }
+
+  /*  put it to the screen  */
+  {
+    gint disp_xoffset, disp_yoffset;
+
+    cairo_save (cr);
+
+    gimp_display_shell_scroll_get_disp_offset (shell,
+                                               &disp_xoffset, &disp_yoffset);
+
+    cairo_rectangle (cr, x + disp_xoffset, y + disp_yoffset, w, h);
+    cairo_clip (cr);
+
+    cairo_set_source_surface (cr, shell->render_surface,
+                              x + disp_xoffset, y + disp_yoffset);
+    cairo_paint (cr);
+
+    gimp_cairo_set_source_rgba (cr, &shell->mask_color);
+    cairo_mask_surface (cr, shell->mask_surface,
+                        x + disp_xoffset, y + disp_yoffset);
+
+    cairo_restore (cr);
+  }
+}
+
+/**
+ * gimp_display_shell_render_invalidate_full:
+ * @shell: a #GimpDisplayShell
+ *
+ * Drops all rendered image tiles cached by @shell.
+ **/
+void
+gimp_display_shell_render_invalidate_full (GimpDisplayShell *shell)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  if (shell->render_cache)
+    g_hash_table_remove_all (shell->render_cache);
+}
+
+/**
+ * gimp_display_shell_render_invalidate_area:
+ * @shell: a #GimpDisplayShell
+ * @x:     x coordinate of the area in display coordinates
+ * @y:     y coordinate of the area in display coordinates
+ * @w:     width of the area
+ * @h:     height of the area
+ *
+ * Drops the cached image tiles that intersect the given area, e.g.
+ * because the projection changed there.
+ **/
+void
+gimp_display_shell_render_invalidate_area (GimpDisplayShell *shell,
+                                           gint              x,
+                                           gint              y,
+                                           gint              w,
+                                           gint              h)
+{
+  gint col, row;
+  gint col1, row1, col2, row2;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  if (! shell->render_cache || w <= 0 || h <= 0)
+    return;
+
+  /*  to scaled image coordinates  */
+  x += shell->offset_x;
+  y += shell->offset_y;
+
+  col1 = MAX (x, 0)         / GIMP_DISPLAY_RENDER_BUF_WIDTH;
+  row1 = MAX (y, 0)         / GIMP_DISPLAY_RENDER_BUF_HEIGHT;
+  col2 = MAX (x + w - 1, 0) / GIMP_DISPLAY_RENDER_BUF_WIDTH;
+  row2 = MAX (y + h - 1, 0) / GIMP_DISPLAY_RENDER_BUF_HEIGHT;
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        gint64 key = RENDER_CACHE_KEY (col, row);
+
+        g_hash_table_remove (shell->render_cache, &key);
+      }
+}
+
+
+/*  private functions  */
+
+/*  renders the projection, and the display filters on top, to the
+ *  top left corner of @surface
+ */
+static void
+gimp_display_shell_render_image (GimpDisplayShell *shell,
+                                 cairo_surface_t  *surface,
+                                 gint              x,
+                                 gint              y,
+                                 gint              w,
+                                 gint              h)
 {
   GimpProjection *projection;
   GimpImage      *image;
@@ -140,10 +324,6 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   gint            level;
   gboolean        premult;
 
-  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
-  g_return_if_fail (cr != NULL);
-  g_return_if_fail (w > 0 && h > 0);
-
   image = gimp_display_get_image (shell->display);
   projection = gimp_image_get_projection (image);
 
@@ -155,11 +335,16 @@ gimp_display_shell_render (GimpDisplayShell *shell,
 
   gimp_display_shell_render_info_init (&info,
                                        shell, x, y, w, h,
-                                       shell->render_surface,
+                                       surface,
                                        tiles, level, premult);
 
-  /* Currently, only RGBA and GRAYA projection types are used. */
+  /* Currently, only RGBA and GRAYA projection types are used, the
+   * tiles for display are always 8-bit, whatever the image precision.
+   */
   format = gimp_pickable_get_format (GIMP_PICKABLE (projection));
+  format = gimp_babl_format (gimp_babl_format_get_base_type (format),
+                             GIMP_PRECISION_U8,
+                             babl_format_has_alpha (format));
 
   if (format == babl_format ("R'G'B'A u8"))
     {
@@ -179,73 +364,177 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   /*  apply filters to the rendered projection  */
   if (shell->filter_stack)
     {
-      cairo_surface_t *sub = shell->render_surface;
+      cairo_surface_t *sub = surface;
 
-      if (w != GIMP_DISPLAY_RENDER_BUF_WIDTH ||
-          h != GIMP_DISPLAY_RENDER_BUF_HEIGHT)
-        sub = cairo_image_surface_create_for_data (cairo_image_surface_get_data (sub),
+      if (w != cairo_image_surface_get_width  (surface) ||
+          h != cairo_image_surface_get_height (surface))
+        sub = cairo_image_surface_create_for_data (cairo_image_surface_get_data (surface),
                                                    CAIRO_FORMAT_ARGB32, w, h,
-                                                   GIMP_DISPLAY_RENDER_BUF_WIDTH * 4);
+                                                   cairo_image_surface_get_stride (surface));
 
-      gimp_color_display_stack_convert_surface (shell->filter_stack, sub);
+      gimp_display_shell_filter_convert_surface (shell, sub);
 
-      if (sub != shell->render_surface)
+      if (sub != surface)
         cairo_surface_destroy (sub);
     }
 
-  cairo_surface_mark_dirty_rectangle (shell->render_surface, 0, 0, w, h);
+  cairo_surface_mark_dirty_rectangle (surface, 0, 0, w, h);
+}
+
+/*  paints the area from cached image tiles, rendering the missing
+ *  tiles first. The tiles are aligned to the scaled image, so they
+ *  stay valid when the view is scrolled, and only newly exposed
+ *  parts need to be rendered.
+ */
+static void
+gimp_display_shell_render_cached (GimpDisplayShell *shell,
+                                  cairo_t          *cr,
+                                  gint              x,
+                                  gint              y,
+                                  gint              w,
+                                  gint              h)
+{
+  gint offset_x, offset_y;
+  gint disp_xoffset, disp_yoffset;
+  gint image_width, image_height;
+  gint col, row;
+  gint col1, row1, col2, row2;
+
+  if (! shell->render_cache)
+    shell->render_cache =
+      g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                             (GDestroyNotify) g_free,
+                             (GDestroyNotify) cairo_surface_destroy);
 
-  if (shell->mask)
+  gimp_display_shell_scroll_get_render_start_offset (shell,
+                                                     &offset_x, &offset_y);
+  gimp_display_shell_scroll_get_disp_offset (shell,
+                                             &disp_xoffset, &disp_yoffset);
+  gimp_display_shell_draw_get_scaled_image_size (shell,
+                                                 &image_width, &image_height);
+
+  /*  the cached tiles are only valid for one scale and image size  */
+  if (shell->render_cache_scale_x != shell->scale_x ||
+      shell->render_cache_scale_y != shell->scale_y ||
+      shell->render_cache_width   != image_width    ||
+      shell->render_cache_height  != image_height)
     {
-      GeglBuffer *buffer;
+      g_hash_table_remove_all (shell->render_cache);
 
-      if (! shell->mask_surface)
-        {
-          shell->mask_surface =
-            cairo_image_surface_create (CAIRO_FORMAT_A8,
-                                        GIMP_DISPLAY_RENDER_BUF_WIDTH,
-                                        GIMP_DISPLAY_RENDER_BUF_HEIGHT);
-        }
+      shell->render_cache_scale_x = shell->scale_x;
+      shell->render_cache_scale_y = shell->scale_y;
+      shell->render_cache_width   = image_width;
+      shell->render_cache_height  = image_height;
+    }
 
-      buffer = gimp_drawable_get_buffer (shell->mask);
-      tiles = gimp_gegl_buffer_get_tiles (buffer);
+  /*  the requested area in scaled image coordinates  */
+  x += offset_x;
+  y += offset_y;
 
-      /* The mask does not (yet) have an image pyramid, use 0 as level, */
-      gimp_display_shell_render_info_init (&info,
-                                           shell, x, y, w, h,
-                                           shell->mask_surface,
-                                           tiles, 0, FALSE);
+  col1 = x           / GIMP_DISPLAY_RENDER_BUF_WIDTH;
+  row1 = y           / GIMP_DISPLAY_RENDER_BUF_HEIGHT;
+  col2 = (x + w - 1) / GIMP_DISPLAY_RENDER_BUF_WIDTH;
+  row2 = (y + h - 1) / GIMP_DISPLAY_RENDER_BUF_HEIGHT;
 
-      render_image_alpha (&info);
+  cairo_save (cr);
 
-      cairo_surface_mark_dirty (shell->mask_surface);
-    }
+  cairo_rectangle (cr,
+                   x - offset_x + disp_xoffset,
+                   y - offset_y + disp_yoffset,
+                   w, h);
+  cairo_clip (cr);
 
-  /*  put it to the screen  */
-  {
-    gint disp_xoffset, disp_yoffset;
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        gint64           key     = RENDER_CACHE_KEY (col, row);
+        cairo_surface_t *surface = g_hash_table_lookup (shell->render_cache,
+                                                        &key);
+        gint             tile_x  = col * GIMP_DISPLAY_RENDER_BUF_WIDTH;
+        gint             tile_y  = row * GIMP_DISPLAY_RENDER_BUF_HEIGHT;
+
+        if (! surface)
+          {
+            gint tile_w = MIN (GIMP_DISPLAY_RENDER_BUF_WIDTH,
+                               image_width  - tile_x);
+            gint tile_h = MIN (GIMP_DISPLAY_RENDER_BUF_HEIGHT,
+                               image_height - tile_y);
+
+            if (tile_w <= 0 || tile_h <= 0)
+              continue;
+
+            surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                  tile_w, tile_h);
+
+            gimp_display_shell_render_image (shell, surface,
+                                             tile_x - offset_x,
+                                             tile_y - offset_y,
+                                             tile_w, tile_h);
+
+            gimp_display_shell_render_cache_trim (shell);
+
+            g_hash_table_insert (shell->render_cache,
+                                 g_memdup (&key, sizeof (key)),
+                                 surface);
+          }
+
+        cairo_set_source_surface (cr, surface,
+                                  tile_x - offset_x + disp_xoffset,
+                                  tile_y - offset_y + disp_yoffset);
+        cairo_paint (cr);
+      }
 
-    cairo_save (cr);
+  cairo_restore (cr);
+}
 
-    gimp_display_shell_scroll_get_disp_offset (shell,
-                                               &disp_xoffset, &disp_yoffset);
+/*  keeps the cache at about twice the number of tiles that fit into
+ *  the view, by dropping the tiles that are farthest away from it
+ */
+static void
+gimp_display_shell_render_cache_trim (GimpDisplayShell *shell)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+  guint           max_tiles;
+  gint            col1, row1, col2, row2;
+  gint            margin = 1;
 
-    cairo_rectangle (cr, x + disp_xoffset, y + disp_yoffset, w, h);
-    cairo_clip (cr);
+  max_tiles = 2 * ((shell->disp_width  / GIMP_DISPLAY_RENDER_BUF_WIDTH  + 2) *
+                   (shell->disp_height / GIMP_DISPLAY_RENDER_BUF_HEIGHT + 2));
 
-    cairo_set_source_surface (cr, shell->render_surface,
-                              x + disp_xoffset, y + disp_yoffset);
-    cairo_paint (cr);
+  while (g_hash_table_size (shell->render_cache) >= max_tiles)
+    {
+      col1 = shell->offset_x / GIMP_DISPLAY_RENDER_BUF_WIDTH  - margin;
+      row1 = shell->offset_y / GIMP_DISPLAY_RENDER_BUF_HEIGHT - margin;
+      col2 = ((shell->offset_x + shell->disp_width) /
+              GIMP_DISPLAY_RENDER_BUF_WIDTH  + margin);
+      row2 = ((shell->offset_y + shell->disp_height) /
+              GIMP_DISPLAY_RENDER_BUF_HEIGHT + margin);
 
-    if (shell->mask)
-      {
-        gimp_cairo_set_source_rgba (cr, &shell->mask_color);
-        cairo_mask_surface (cr, shell->mask_surface,
-                            x + disp_xoffset, y + disp_yoffset);
-      }
+      g_hash_table_iter_init (&iter, shell->render_cache);
 
-    cairo_restore (cr);
-  }
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          gint col = RENDER_CACHE_KEY_COL (*(gint64 *) key);
+          gint row = RENDER_CACHE_KEY_ROW (*(gint64 *) key);
+
+          if (col < col1 || col > col2 ||
+              row < row1 || row > row2)
+            g_hash_table_iter_remove (&iter);
+        }
+
+      /*  everything left is close to the view, but there are still
+       *  too many tiles, e.g. after the view got smaller
+       */
+      if (margin == 0)
+        {
+          if (g_hash_table_size (shell->render_cache) >= max_tiles)
+            g_hash_table_remove_all (shell->render_cache);
+          break;
+        }
+
+      margin--;
+    }
 }
 
 /*  render a GRAY tile to an A8 cairo surface  */
@@ -425,12 +714,12 @@ gimp_display_shell_render_info_init (RenderInfo       *info,
   /* make sure that the footprint is in the range 256..512 */
   info->footprint_x = info->x_src_dec;
   info->footshift_x = 0;
-  while (info->footprint_x > 512)
+  while (info->footprint_x > GIMP_DISPLAY_RENDER_MAX_FOOTPRINT)
     {
       info->footprint_x >>= 1;
       info->footshift_x --;
     }
-  while (info->footprint_x < 256)
+  while (info->footprint_x < GIMP_DISPLAY_RENDER_MIN_FOOTPRINT)
     {
       info->footprint_x <<= 1;
       info->footshift_x ++;
@@ -438,17 +727,23 @@ gimp_display_shell_render_info_init (RenderInfo       *info,
 
   info->footprint_y = info->y_src_dec;
   info->footshift_y = 0;
-  while (info->footprint_y > 512)
+  while (info->footprint_y > GIMP_DISPLAY_RENDER_MAX_FOOTPRINT)
     {
       info->footprint_y >>= 1;
       info->footshift_y --;
     }
-  while (info->footprint_y < 256)
+  while (info->footprint_y < GIMP_DISPLAY_RENDER_MIN_FOOTPRINT)
     {
       info->footprint_y <<= 1;
       info->footshift_y ++;
     }
 
+  if (info->src_is_premult)
+    info->footprint_recip = RECIPROCAL (info->footprint_x * info->footprint_y);
+  else
+    info->footprint_recip = RECIPROCAL ((info->footprint_x *
+                                         info->footprint_y) >> 4);
+
   switch (shell->display->config->zoom_quality)
     {
     case GIMP_ZOOM_QUALITY_LOW:
@@ -469,25 +764,26 @@ box_filter (const guint    left_weight,
             const guint    top_weight,
             const guint    middle_weight,
             const guint    bottom_weight,
+            const guint64  sum_recip,
             const guchar **src,   /* the 9 surrounding source pixels */
             guchar        *dest,
             const gint     bpp)
 {
-  const guint sum = ((left_weight + center_weight + right_weight) *
-                     (top_weight + middle_weight + bottom_weight));
   gint i;
 
   for (i = 0; i < bpp; i++)
     {
-      dest[i] = ( left_weight   * ((src[0][i] * top_weight) +
-                                   (src[3][i] * middle_weight) +
-                                   (src[6][i] * bottom_weight))
-                + center_weight * ((src[1][i] * top_weight) +
-                                   (src[4][i] * middle_weight) +
-                                   (src[7][i] * bottom_weight))
-                + right_weight  * ((src[2][i] * top_weight) +
-                                   (src[5][i] * middle_weight) +
-                                   (src[8][i] * bottom_weight))) / sum;
+      const guint value = ( left_weight   * ((src[0][i] * top_weight) +
+                                             (src[3][i] * middle_weight) +
+                                             (src[6][i] * bottom_weight))
+                          + center_weight * ((src[1][i] * top_weight) +
+                                             (src[4][i] * middle_weight) +
+                                             (src[7][i] * bottom_weight))
+                          + right_weight  * ((src[2][i] * top_weight) +
+                                             (src[5][i] * middle_weight) +
+                                             (src[8][i] * bottom_weight)));
+
+      dest[i] = RECIPROCAL_DIVIDE (value, sum_recip);
     }
 }
 
@@ -501,6 +797,7 @@ box_filter_premult (const guint    left_weight,
                     const guint    top_weight,
                     const guint    middle_weight,
                     const guint    bottom_weight,
+                    const guint64  sum_recip,
                     const guchar **src,   /* the 9 surrounding source pixels */
                     guchar        *dest,
                     const gint     bpp)
@@ -535,20 +832,22 @@ box_filter_premult (const guint    left_weight,
 
           for (i = 0; i < ALPHA; i++)
             {
-              dest[i] = ((center_weight * (factors[0] * src[1][i] +
-                                           factors[1] * src[4][i] +
-                                           factors[2] * src[7][i]) +
+              const guint value = (center_weight * (factors[0] * src[1][i] +
+                                                    factors[1] * src[4][i] +
+                                                    factors[2] * src[7][i]) +
 
-                          right_weight  * (factors[3] * src[2][i] +
-                                           factors[4] * src[5][i] +
-                                           factors[5] * src[8][i]) +
+                                   right_weight  * (factors[3] * src[2][i] +
+                                                    factors[4] * src[5][i] +
+                                                    factors[5] * src[8][i]) +
 
-                          left_weight   * (factors[6] * src[0][i] +
-                                           factors[7] * src[3][i] +
-                                           factors[8] * src[6][i])) / sum) >> 8;
+                                   left_weight   * (factors[6] * src[0][i] +
+                                                    factors[7] * src[3][i] +
+                                                    factors[8] * src[6][i]));
+
+              dest[i] = RECIPROCAL_DIVIDE (value, sum_recip) >> 8;
             }
 
-          dest[ALPHA] = (a + (sum >> 1)) / sum;
+          dest[ALPHA] = RECIPROCAL_DIVIDE (a + (sum >> 1), sum_recip);
         }
 #undef ALPHA
         break;
@@ -582,20 +881,22 @@ box_filter_premult (const guint    left_weight,
 
           for (i = 0; i < ALPHA; i++)
             {
-              dest[i] = ((center_weight * (factors[0] * src[1][i] +
-                                           factors[1] * src[4][i] +
-                                           factors[2] * src[7][i]) +
+              const guint value = (center_weight * (factors[0] * src[1][i] +
+                                                    factors[1] * src[4][i] +
+                                                    factors[2] * src[7][i]) +
+
+                                   right_weight  * (factors[3] * src[2][i] +
+                                                    factors[4] * src[5][i] +
+                                                    factors[5] * src[8][i]) +
 
-                          right_weight  * (factors[3] * src[2][i] +
-                                           factors[4] * src[5][i] +
-                                           factors[5] * src[8][i]) +
+                                   left_weight   * (factors[6] * src[0][i] +
+                                                    factors[7] * src[3][i] +
+                                                    factors[8] * src[6][i]));
 
-                          left_weight   * (factors[6] * src[0][i] +
-                                           factors[7] * src[3][i] +
-                                           factors[8] * src[6][i])) / sum) >> 8;
+              dest[i] = RECIPROCAL_DIVIDE (value, sum_recip) >> 8;
             }
 
-          dest[ALPHA] = (a + (sum >> 1)) / sum;
+          dest[ALPHA] = RECIPROCAL_DIVIDE (a + (sum >> 1), sum_recip);
         }
 #undef ALPHA
         break;
@@ -852,11 +1153,11 @@ render_image_tile_fault (RenderInfo *info)
       if (info->src_is_premult)
         box_filter (left_weight, center_weight, right_weight,
                     top_weight, middle_weight, bottom_weight,
-                    src, dest, bpp);
+                    info->footprint_recip, src, dest, bpp);
       else
         box_filter_premult (left_weight, center_weight, right_weight,
                             top_weight, middle_weight, bottom_weight,
-                            src, dest, bpp);
+                            info->footprint_recip, src, dest, bpp);
 
       dest += bpp;
 
@@ -1224,11 +1525,11 @@ render_image_tile_fault_one_row (RenderInfo *info)
       if (info->src_is_premult)
         box_filter (left_weight, center_weight, right_weight,
                     top_weight, middle_weight, bottom_weight,
-                    src, dest, bpp);
+                    info->footprint_recip, src, dest, bpp);
       else
         box_filter_premult (left_weight, center_weight, right_weight,
                             top_weight, middle_weight, bottom_weight,
-                            src, dest, bpp);
+                            info->footprint_recip, src, dest, bpp);
 
       dest += bpp;
 
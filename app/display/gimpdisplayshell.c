@@ -31,6 +31,8 @@
 #include "display-types.h"
 #include "tools/tools-types.h"
 
+#include "base/tile-pyramid.h"
+
 #include "config/gimpcoreconfig.h"
 #include "config/gimpdisplayconfig.h"
 #include "config/gimpdisplayoptions.h"
@@ -154,6 +156,13 @@ static void      gimp_display_shell_sync_config    (GimpDisplayShell  *shell,
 static void      gimp_display_shell_remove_overlay (GtkWidget        *canvas,
                                                     GtkWidget        *child,
                                                     GimpDisplayShell *shell);
+static void      gimp_display_shell_mask_update    (GimpDrawable     *mask,
+                                                    gint              x,
+                                                    gint              y,
+                                                    gint              width,
+                                                    gint              height,
+                                                    GimpDisplayShell *shell);
+
 static void   gimp_display_shell_transform_overlay (GimpDisplayShell *shell,
                                                     GtkWidget        *child,
                                                     gdouble          *x,
@@ -770,12 +779,24 @@ gimp_display_shell_dispose (GObject *object)
       shell->filter_idle_id = 0;
     }
 
+  if (shell->filter_lut)
+    {
+      g_free (shell->filter_lut);
+      shell->filter_lut = NULL;
+    }
+
   if (shell->render_surface)
     {
       cairo_surface_destroy (shell->render_surface);
       shell->render_surface = NULL;
     }
 
+  if (shell->render_cache)
+    {
+      g_hash_table_unref (shell->render_cache);
+      shell->render_cache = NULL;
+    }
+
   if (shell->mask_surface)
     {
       cairo_surface_destroy (shell->mask_surface);
@@ -788,8 +809,17 @@ gimp_display_shell_dispose (GObject *object)
       shell->checkerboard = NULL;
     }
 
+  if (shell->mask_pyramid)
+    {
+      tile_pyramid_destroy (shell->mask_pyramid);
+      shell->mask_pyramid = NULL;
+    }
+
   if (shell->mask)
     {
+      g_signal_handlers_disconnect_by_func (shell->mask,
+                                            gimp_display_shell_mask_update,
+                                            shell);
       g_object_unref (shell->mask);
       shell->mask = NULL;
     }
@@ -1085,6 +1115,29 @@ gimp_display_shell_remove_overlay (GtkWidget        *canvas,
   shell->children = g_list_remove (shell->children, child);
 }
 
+static void
+gimp_display_shell_mask_update (GimpDrawable     *mask,
+                                gint              x,
+                                gint              y,
+                                gint              width,
+                                gint              height,
+                                GimpDisplayShell *shell)
+{
+  if (shell->mask_pyramid)
+    {
+      gint mask_width  = tile_pyramid_get_width  (shell->mask_pyramid);
+      gint mask_height = tile_pyramid_get_height (shell->mask_pyramid);
+
+      if (gimp_rectangle_intersect (x, y, width, height,
+                                    0, 0, mask_width, mask_height,
+                                    &x, &y, &width, &height))
+        {
+          tile_pyramid_invalidate_area (shell->mask_pyramid,
+                                        x, y, width, height);
+        }
+    }
+}
+
 static void
 gimp_display_shell_transform_overlay (GimpDisplayShell *shell,
                                       GtkWidget        *child,
@@ -1803,12 +1856,29 @@ gimp_display_shell_set_mask (GimpDisplayShell *shell,
     g_object_ref (mask);
 
   if (shell->mask)
-    g_object_unref (shell->mask);
+    {
+      g_signal_handlers_disconnect_by_func (shell->mask,
+                                            gimp_display_shell_mask_update,
+                                            shell);
+      g_object_unref (shell->mask);
+    }
+
+  if (shell->mask_pyramid)
+    {
+      tile_pyramid_destroy (shell->mask_pyramid);
+      shell->mask_pyramid = NULL;
+    }
 
   shell->mask = mask;
 
   if (mask)
-    shell->mask_color = *color;
+    {
+      shell->mask_color = *color;
+
+      g_signal_connect (mask, "update",
+                        G_CALLBACK (gimp_display_shell_mask_update),
+                        shell);
+    }
 
   gimp_display_shell_expose_full (shell);
 }
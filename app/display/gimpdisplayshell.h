@@ -115,6 +115,11 @@ struct _GimpDisplayShell
   GtkWidget         *statusbar;        /*  statusbar                          */
 
   cairo_surface_t   *render_surface;   /*  buffer for rendering the image     */
+  GHashTable        *render_cache;     /*  rendered image tiles               */
+  gdouble            render_cache_scale_x;
+  gdouble            render_cache_scale_y;
+  gint               render_cache_width;
+  gint               render_cache_height;
   cairo_surface_t   *mask_surface;     /*  buffer for rendering the mask      */
   cairo_pattern_t   *checkerboard;     /*  checkerboard pattern               */
 
@@ -156,6 +161,8 @@ struct _GimpDisplayShell
 
   GimpColorDisplayStack *filter_stack;   /* color display conversion stuff    */
   guint                  filter_idle_id;
+  guchar                *filter_lut;     /* the filter stack as 3D LUT        */
+  gboolean               filter_lut_valid;
   GtkWidget             *filters_dialog; /* color display filter dialog       */
 
   gint               paused_count;
@@ -186,6 +193,7 @@ struct _GimpDisplayShell
 
   GimpDrawable      *mask;
   GimpRGB            mask_color;
+  TilePyramid       *mask_pyramid;     /*  downscaled levels of the mask      */
 
   GimpMotionBuffer  *motion_buffer;
 
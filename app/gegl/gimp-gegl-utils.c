@@ -73,6 +73,20 @@ gimp_gegl_buffer_dup (GeglBuffer *buffer)
   TileManager *tiles;
   GeglBuffer  *dup;
 
+  /*  buffers backed by a tile manager share their tiles copy-on-write
+   *  with the duplicate, so no pixels are copied until either side
+   *  is modified
+   */
+  if (gimp_gegl_buffer_peek_tiles (buffer))
+    {
+      tiles = tile_manager_duplicate (gimp_gegl_buffer_get_tiles (buffer));
+
+      dup = gimp_tile_manager_create_buffer (tiles, format);
+      tile_manager_unref (tiles);
+
+      return dup;
+    }
+
   tiles = tile_manager_new (gegl_buffer_get_width (buffer),
                             gegl_buffer_get_height (buffer),
                             babl_format_get_bytes_per_pixel (format));
@@ -118,6 +132,24 @@ gimp_gegl_buffer_get_tiles (GeglBuffer *buffer)
   return gimp_tile_backend_tile_manager_get_tiles (backend);
 }
 
+/*  like gimp_gegl_buffer_get_tiles(), but doesn't flush @buffer and
+ *  returns NULL if @buffer isn't backed by a tile manager
+ */
+TileManager *
+gimp_gegl_buffer_peek_tiles (GeglBuffer *buffer)
+{
+  GeglTileBackend *backend;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  backend = gegl_buffer_backend (buffer);
+
+  if (GIMP_IS_TILE_BACKEND_TILE_MANAGER (backend))
+    return gimp_tile_backend_tile_manager_get_tiles (backend);
+
+  return NULL;
+}
+
 void
 gimp_gegl_buffer_refetch_tiles (GeglBuffer *buffer)
 {
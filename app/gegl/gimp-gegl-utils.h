@@ -31,6 +31,7 @@ GeglBuffer  * gimp_gegl_buffer_dup               (GeglBuffer            *buffer)
 GeglBuffer  * gimp_tile_manager_create_buffer    (TileManager           *tm,
                                                   const Babl            *format);
 TileManager * gimp_gegl_buffer_get_tiles         (GeglBuffer            *buffer);
+TileManager * gimp_gegl_buffer_peek_tiles        (GeglBuffer            *buffer);
 void          gimp_gegl_buffer_refetch_tiles     (GeglBuffer            *buffer);
 
 GeglColor   * gimp_gegl_color_new                (const GimpRGB         *rgb);
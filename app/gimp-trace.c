@@ -0,0 +1,235 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#ifdef G_OS_WIN32
+#include <process.h>
+#endif
+
+#include "libgimpbase/gimpbase.h"
+
+#include "gimp-trace.h"
+
+#include "gimp-intl.h"
+
+
+/*  Records trace events in memory and writes them in the Chrome
+ *  trace event format, which can be loaded into chrome://tracing or
+ *  https://ui.perfetto.dev
+ */
+
+
+typedef struct _GimpTraceEvent GimpTraceEvent;
+
+struct _GimpTraceEvent
+{
+  const gchar *category;
+  const gchar *name;
+  gint64       time;
+  gint64       value;
+  gint         thread;
+  gchar        phase;
+};
+
+
+gboolean gimp_trace_active = FALSE;
+
+static GMutex    trace_mutex;
+static GArray   *trace_events    = NULL;
+static gchar    *trace_filename  = NULL;
+static gint64    trace_start     = 0;
+static gint      trace_n_threads = 0;
+static GPrivate  trace_thread    = G_PRIVATE_INIT (NULL);
+
+
+void
+gimp_trace_init (void)
+{
+  const gchar *env_trace_val = g_getenv ("GIMP_TRACE");
+
+  if (env_trace_val && *env_trace_val)
+    gimp_trace_start (env_trace_val);
+}
+
+void
+gimp_trace_exit (void)
+{
+  GError *error = NULL;
+
+  if (gimp_trace_active && ! gimp_trace_stop (&error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+    }
+}
+
+gboolean
+gimp_trace_start (const gchar *filename)
+{
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  g_mutex_lock (&trace_mutex);
+
+  if (gimp_trace_active)
+    {
+      g_mutex_unlock (&trace_mutex);
+      return FALSE;
+    }
+
+  g_free (trace_filename);
+  trace_filename = g_strdup (filename);
+
+  trace_events = g_array_sized_new (FALSE, FALSE,
+                                    sizeof (GimpTraceEvent), 4096);
+  trace_start  = g_get_monotonic_time ();
+
+  gimp_trace_active = TRUE;
+
+  g_mutex_unlock (&trace_mutex);
+
+  return TRUE;
+}
+
+gboolean
+gimp_trace_stop (GError **error)
+{
+  GArray   *events;
+  FILE     *file;
+  gint      pid;
+  gint      i;
+  gboolean  success;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  g_mutex_lock (&trace_mutex);
+
+  if (! gimp_trace_active)
+    {
+      g_mutex_unlock (&trace_mutex);
+      return TRUE;
+    }
+
+  gimp_trace_active = FALSE;
+
+  events       = trace_events;
+  trace_events = NULL;
+
+  g_mutex_unlock (&trace_mutex);
+
+  file = g_fopen (trace_filename, "w");
+
+  if (! file)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Could not open '%s' for writing: %s"),
+                   gimp_filename_to_utf8 (trace_filename),
+                   g_strerror (errno));
+      g_array_free (events, TRUE);
+
+      return FALSE;
+    }
+
+  pid = (gint) getpid ();
+
+  fprintf (file, "{\"traceEvents\":[\n");
+
+  for (i = 0; i < events->len; i++)
+    {
+      GimpTraceEvent *event = &g_array_index (events, GimpTraceEvent, i);
+
+      fprintf (file,
+               "{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"%c\","
+               "\"ts\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%d",
+               event->category, event->name, event->phase,
+               event->time, pid, event->thread);
+
+      if (event->phase == 'C')
+        fprintf (file, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}",
+                 event->value);
+
+      fprintf (file, "}%s\n", i + 1 < events->len ? "," : "");
+    }
+
+  fprintf (file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  success = (fclose (file) == 0);
+
+  if (! success)
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                 _("Error writing '%s': %s"),
+                 gimp_filename_to_utf8 (trace_filename),
+                 g_strerror (errno));
+
+  g_array_free (events, TRUE);
+
+  return success;
+}
+
+/*  returns the file the current or last trace is written to  */
+const gchar *
+gimp_trace_get_filename (void)
+{
+  return trace_filename;
+}
+
+/*  don't call this directly, use the GIMP_TRACE_*() macros  */
+void
+gimp_trace_event (const gchar *category,
+                  const gchar *name,
+                  gchar        phase,
+                  gint64       value)
+{
+  GimpTraceEvent event;
+
+  event.thread = GPOINTER_TO_INT (g_private_get (&trace_thread));
+
+  if (! event.thread)
+    {
+      event.thread = g_atomic_int_add (&trace_n_threads, 1) + 1;
+
+      g_private_set (&trace_thread, GINT_TO_POINTER (event.thread));
+    }
+
+  event.category = category;
+  event.name     = name;
+  event.phase    = phase;
+  event.value    = value;
+  event.time     = g_get_monotonic_time ();
+
+  g_mutex_lock (&trace_mutex);
+
+  /*  the trace might have been stopped since the caller checked  */
+  if (trace_events)
+    {
+      event.time -= trace_start;
+
+      g_array_append_val (trace_events, event);
+    }
+
+  g_mutex_unlock (&trace_mutex);
+}
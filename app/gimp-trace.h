@@ -0,0 +1,64 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TRACE_H__
+#define __GIMP_TRACE_H__
+
+
+extern gboolean gimp_trace_active;
+
+
+void          gimp_trace_init         (void);
+void          gimp_trace_exit         (void);
+
+gboolean      gimp_trace_start        (const gchar  *filename);
+gboolean      gimp_trace_stop         (GError      **error);
+const gchar * gimp_trace_get_filename (void);
+
+void          gimp_trace_event        (const gchar  *category,
+                                       const gchar  *name,
+                                       gchar         phase,
+                                       gint64        value);
+
+
+/*  The category and name of trace events are not copied, they must be
+ *  string literals which need no escaping in JSON.  Every
+ *  GIMP_TRACE_BEGIN() must be matched by a GIMP_TRACE_END() with the
+ *  same name on the same thread.  When no trace is recorded, all of
+ *  these only test gimp_trace_active.
+ */
+
+#define GIMP_TRACE_BEGIN(category, name) \
+        G_STMT_START { \
+        if (G_UNLIKELY (gimp_trace_active)) \
+          gimp_trace_event ((category), (name), 'B', 0); \
+        } G_STMT_END
+
+#define GIMP_TRACE_END(category, name) \
+        G_STMT_START { \
+        if (G_UNLIKELY (gimp_trace_active)) \
+          gimp_trace_event ((category), (name), 'E', 0); \
+        } G_STMT_END
+
+#define GIMP_TRACE_COUNTER(category, name, value) \
+        G_STMT_START { \
+        if (G_UNLIKELY (gimp_trace_active)) \
+          gimp_trace_event ((category), (name), 'C', (value)); \
+        } G_STMT_END
+
+
+#endif /* __GIMP_TRACE_H__ */
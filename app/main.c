@@ -73,6 +73,7 @@
 #endif
 
 #include "gimp-log.h"
+#include "gimp-trace.h"
 #include "gimp-intl.h"
 
 
@@ -116,6 +117,7 @@ static const gchar        *session_name      = NULL;
 static const gchar        *batch_interpreter = NULL;
 static const gchar       **batch_commands    = NULL;
 static const gchar       **filenames         = NULL;
+static gboolean            batch_daemon      = FALSE;
 static gboolean            as_new            = FALSE;
 static gboolean            no_interface      = FALSE;
 static gboolean            no_data           = FALSE;
@@ -222,6 +224,11 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_STRING, &batch_interpreter,
     N_("The procedure to process batch commands with"), "<proc>"
   },
+  {
+    "batch-daemon", 0, 0,
+    G_OPTION_ARG_NONE, &batch_daemon,
+    N_("Keep running and read batch commands from stdin"), NULL
+  },
   {
     "console-messages", 'c', 0,
     G_OPTION_ARG_NONE, &console_messages,
@@ -331,6 +338,7 @@ main (int    argc,
   gimp_env_init (FALSE);
 
   gimp_log_init ();
+  gimp_trace_init ();
 
   gimp_init_i18n ();
 
@@ -410,7 +418,8 @@ main (int    argc,
       app_exit (EXIT_FAILURE);
     }
 
-  if (no_interface || be_verbose || console_messages || batch_commands != NULL)
+  if (no_interface || be_verbose || console_messages || batch_commands != NULL ||
+      batch_daemon)
     gimp_open_console_window ();
 
   if (no_interface)
@@ -442,6 +451,7 @@ main (int    argc,
            session_name,
            batch_interpreter,
            batch_commands,
+           batch_daemon,
            as_new,
            no_interface,
            no_data,
@@ -38,6 +38,7 @@
 
 #include "gimpbrushcore.h"
 #include "gimpbrushcore-kernels.h"
+#include "gimppaintcore-replay.h"
 
 #include "gimppaintoptions.h"
 
@@ -1379,17 +1380,25 @@ static const GimpTempBuf *
 gimp_brush_core_transform_mask (GimpBrushCore *core,
                                 GimpBrush     *brush)
 {
+  GimpPaintCore     *paint_core = GIMP_PAINT_CORE (core);
   const GimpTempBuf *mask;
+  gint64             start      = 0;
 
   if (core->scale <= 0.0)
     return NULL;
 
+  if (paint_core->stats)
+    start = g_get_monotonic_time ();
+
   mask = gimp_brush_transform_mask (brush,
                                     core->scale,
                                     core->aspect_ratio,
                                     core->angle,
                                     core->hardness);
 
+  if (paint_core->stats)
+    paint_core->stats->mask_time += g_get_monotonic_time () - start;
+
   if (mask == core->transform_brush)
     return mask;
 
@@ -1404,17 +1413,25 @@ static const GimpTempBuf *
 gimp_brush_core_transform_pixmap (GimpBrushCore *core,
                                   GimpBrush     *brush)
 {
+  GimpPaintCore     *paint_core = GIMP_PAINT_CORE (core);
   const GimpTempBuf *pixmap;
+  gint64             start      = 0;
 
   if (core->scale <= 0.0)
     return NULL;
 
+  if (paint_core->stats)
+    start = g_get_monotonic_time ();
+
   pixmap = gimp_brush_transform_pixmap (brush,
                                         core->scale,
                                         core->aspect_ratio,
                                         core->angle,
                                         core->hardness);
 
+  if (paint_core->stats)
+    paint_core->stats->mask_time += g_get_monotonic_time () - start;
+
   if (pixmap == core->transform_pixmap)
     return pixmap;
 
@@ -176,6 +176,9 @@ gimp_clone_motion (GimpSourceCore   *source_core,
         GimpPattern *pattern    = gimp_context_get_pattern (context);
         GeglBuffer  *src_buffer = gimp_pattern_create_buffer (pattern);
 
+        if (! src_buffer)
+          return;
+
         gegl_buffer_set_pattern (paint_buffer,
                                  GEGL_RECTANGLE (paint_area_offset_x,
                                                  paint_area_offset_y,
@@ -0,0 +1,376 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Recording and replaying of the coordinates of paint strokes.
+ *
+ *  While recording, every stroke started with gimp_paint_core_start()
+ *  and every event passed to gimp_paint_core_interpolate() is kept,
+ *  so the strokes can be saved and replayed later through any paint
+ *  core, to measure paint performance reproducibly.
+ *
+ *  The file format is plain text: a "stroke" line starts a stroke,
+ *  and each following line holds the x, y, pressure, xtilt, ytilt,
+ *  wheel, velocity and direction of one event. Lines starting with
+ *  '#' are comments.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint-types.h"
+
+#include "core/gimpdrawable.h"
+
+#include "gimppaintcore.h"
+#include "gimppaintcore-replay.h"
+#include "gimppaintcore-stroke.h"
+
+#include "gimp-intl.h"
+
+
+#define N_COORDS_FIELDS 8
+
+
+static GPtrArray *recording = NULL;
+
+
+GPtrArray *
+gimp_paint_core_recording_new (void)
+{
+  return g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+}
+
+GPtrArray *
+gimp_paint_core_recording_load (const gchar  *filename,
+                                GError      **error)
+{
+  GPtrArray  *strokes;
+  GArray     *stroke = NULL;
+  gchar      *contents;
+  gchar     **lines;
+  gint        i;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! g_file_get_contents (filename, &contents, NULL, error))
+    return NULL;
+
+  strokes = gimp_paint_core_recording_new ();
+  lines   = g_strsplit (contents, "\n", -1);
+
+  for (i = 0; lines[i]; i++)
+    {
+      gchar      *line = g_strstrip (lines[i]);
+      gdouble     values[N_COORDS_FIELDS];
+      GimpCoords  coords;
+      gint        n;
+
+      if (! *line || *line == '#')
+        continue;
+
+      if (! strcmp (line, "stroke"))
+        {
+          stroke = g_array_new (FALSE, FALSE, sizeof (GimpCoords));
+          g_ptr_array_add (strokes, stroke);
+          continue;
+        }
+
+      for (n = 0; n < N_COORDS_FIELDS && *line; n++)
+        {
+          gchar *end;
+
+          values[n] = g_ascii_strtod (line, &end);
+
+          if (end == line)
+            break;
+
+          line = end;
+        }
+
+      if (! stroke || n != N_COORDS_FIELDS)
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                       _("Invalid stroke recording '%s' at line %d."),
+                       gimp_filename_to_utf8 (filename), i + 1);
+
+          g_ptr_array_unref (strokes);
+          strokes = NULL;
+          break;
+        }
+
+      coords.x         = values[0];
+      coords.y         = values[1];
+      coords.pressure  = values[2];
+      coords.xtilt     = values[3];
+      coords.ytilt     = values[4];
+      coords.wheel     = values[5];
+      coords.velocity  = values[6];
+      coords.direction = values[7];
+
+      g_array_append_val (stroke, coords);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return strokes;
+}
+
+gboolean
+gimp_paint_core_recording_save (GPtrArray    *strokes,
+                                const gchar  *filename,
+                                GError      **error)
+{
+  GString  *string;
+  gboolean  success;
+  gint      i, j;
+
+  g_return_val_if_fail (strokes != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  string = g_string_new ("# GIMP stroke recording\n"
+                         "# x y pressure xtilt ytilt wheel velocity direction\n");
+
+  for (i = 0; i < strokes->len; i++)
+    {
+      GArray *stroke = g_ptr_array_index (strokes, i);
+
+      g_string_append (string, "stroke\n");
+
+      for (j = 0; j < stroke->len; j++)
+        {
+          const GimpCoords *coords = &g_array_index (stroke, GimpCoords, j);
+          const gdouble     values[N_COORDS_FIELDS] = { coords->x,
+                                                        coords->y,
+                                                        coords->pressure,
+                                                        coords->xtilt,
+                                                        coords->ytilt,
+                                                        coords->wheel,
+                                                        coords->velocity,
+                                                        coords->direction };
+          gint              n;
+
+          for (n = 0; n < N_COORDS_FIELDS; n++)
+            {
+              gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+              g_string_append (string, g_ascii_dtostr (buf, sizeof (buf),
+                                                       values[n]));
+              g_string_append_c (string, n < N_COORDS_FIELDS - 1 ? ' ' : '\n');
+            }
+        }
+    }
+
+  success = g_file_set_contents (filename, string->str, string->len, error);
+
+  g_string_free (string, TRUE);
+
+  return success;
+}
+
+void
+gimp_paint_core_record_start (void)
+{
+  g_return_if_fail (recording == NULL);
+
+  recording = gimp_paint_core_recording_new ();
+}
+
+GPtrArray *
+gimp_paint_core_record_stop (void)
+{
+  GPtrArray *strokes = recording;
+
+  g_return_val_if_fail (recording != NULL, NULL);
+
+  recording = NULL;
+
+  return strokes;
+}
+
+gboolean
+gimp_paint_core_is_recording (void)
+{
+  return recording != NULL;
+}
+
+void
+gimp_paint_core_record_stroke (const GimpCoords *coords)
+{
+  GArray *stroke;
+
+  if (! recording)
+    return;
+
+  stroke = g_array_new (FALSE, FALSE, sizeof (GimpCoords));
+  g_array_append_val (stroke, *coords);
+
+  g_ptr_array_add (recording, stroke);
+}
+
+void
+gimp_paint_core_record_coords (const GimpCoords *coords)
+{
+  GArray *stroke;
+
+  if (! recording || recording->len == 0)
+    return;
+
+  stroke = g_ptr_array_index (recording, recording->len - 1);
+
+  g_array_append_val (stroke, *coords);
+}
+
+/**
+ * gimp_paint_core_replay:
+ * @core:          the #GimpPaintCore to paint with
+ * @drawable:      the #GimpDrawable to paint on
+ * @paint_options: the #GimpPaintOptions to paint with
+ * @strokes:       the strokes to replay
+ * @push_undo:     whether to push an undo step for each stroke
+ * @stats:         a #GimpPaintCoreStats to add the timings to, or %NULL
+ * @error:         return location for an error
+ *
+ * Paints all @strokes like gimp_paint_core_stroke()
+ * would, and adds the time spent painting each dab, transforming the
+ * brush, applying the paint and pushing undo to @stats.
+ *
+ * Return value: %TRUE if all strokes were painted.
+ **/
+gboolean
+gimp_paint_core_replay (GimpPaintCore       *core,
+                        GimpDrawable        *drawable,
+                        GimpPaintOptions    *paint_options,
+                        GPtrArray           *strokes,
+                        gboolean             push_undo,
+                        GimpPaintCoreStats  *stats,
+                        GError             **error)
+{
+  GPtrArray *paused_recording;
+  gboolean   success = TRUE;
+  gint64     start;
+  gint       i;
+
+  g_return_val_if_fail (GIMP_IS_PAINT_CORE (core), FALSE);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (strokes != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /*  don't record the strokes we replay  */
+  paused_recording = recording;
+  recording        = NULL;
+
+  core->stats = stats;
+
+  start = g_get_monotonic_time ();
+
+  for (i = 0; success && i < strokes->len; i++)
+    {
+      GArray *stroke = g_ptr_array_index (strokes, i);
+
+      if (stroke->len > 0)
+        success = gimp_paint_core_stroke (core, drawable, paint_options,
+                                          (GimpCoords *) stroke->data,
+                                          stroke->len, push_undo, error);
+    }
+
+  if (stats)
+    stats->total_time += g_get_monotonic_time () - start;
+
+  core->stats = NULL;
+
+  recording = paused_recording;
+
+  return success;
+}
+
+GimpPaintCoreStats *
+gimp_paint_core_stats_new (void)
+{
+  GimpPaintCoreStats *stats = g_slice_new0 (GimpPaintCoreStats);
+
+  stats->dab_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  return stats;
+}
+
+void
+gimp_paint_core_stats_free (GimpPaintCoreStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_array_free (stats->dab_times, TRUE);
+
+  g_slice_free (GimpPaintCoreStats, stats);
+}
+
+gint
+gimp_paint_core_stats_get_n_dabs (GimpPaintCoreStats *stats)
+{
+  g_return_val_if_fail (stats != NULL, 0);
+
+  return stats->dab_times->len;
+}
+
+gdouble
+gimp_paint_core_stats_get_dabs_per_second (GimpPaintCoreStats *stats)
+{
+  g_return_val_if_fail (stats != NULL, 0.0);
+
+  if (stats->total_time == 0)
+    return 0.0;
+
+  return stats->dab_times->len * 1000000.0 / stats->total_time;
+}
+
+static gint
+compare_times (const gint64 *a,
+               const gint64 *b)
+{
+  return (*a > *b) - (*a < *b);
+}
+
+/*  returns the time of the dab at @percentile (0 to 100) of all dabs
+ *  sorted by time, in seconds
+ */
+gdouble
+gimp_paint_core_stats_get_dab_time (GimpPaintCoreStats *stats,
+                                    gdouble             percentile)
+{
+  gint index;
+
+  g_return_val_if_fail (stats != NULL, 0.0);
+
+  if (stats->dab_times->len == 0)
+    return 0.0;
+
+  g_array_sort (stats->dab_times, (GCompareFunc) compare_times);
+
+  index = RINT (CLAMP (percentile, 0.0, 100.0) / 100.0 *
+                (stats->dab_times->len - 1));
+
+  return g_array_index (stats->dab_times, gint64, index) / 1000000.0;
+}
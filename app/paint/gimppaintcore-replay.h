@@ -0,0 +1,70 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PAINT_CORE_REPLAY_H__
+#define __GIMP_PAINT_CORE_REPLAY_H__
+
+
+struct _GimpPaintCoreStats
+{
+  gint64  total_time;      /*  time spent replaying, in microseconds  */
+  gint64  mask_time;       /*  time spent transforming brush masks    */
+  gint64  applicator_time; /*  time spent applying paint              */
+  gint64  undo_time;       /*  time spent pushing undo                */
+
+  GArray *dab_times;       /*  the time of each dab, as gint64        */
+};
+
+
+/*  a recording is a GPtrArray of strokes, each stroke is a GArray of
+ *  GimpCoords
+ */
+
+GPtrArray          * gimp_paint_core_recording_new     (void);
+GPtrArray          * gimp_paint_core_recording_load    (const gchar         *filename,
+                                                        GError             **error);
+gboolean             gimp_paint_core_recording_save    (GPtrArray           *strokes,
+                                                        const gchar         *filename,
+                                                        GError             **error);
+
+void                 gimp_paint_core_record_start      (void);
+GPtrArray          * gimp_paint_core_record_stop       (void);
+gboolean             gimp_paint_core_is_recording      (void);
+
+void                 gimp_paint_core_record_stroke     (const GimpCoords    *coords);
+void                 gimp_paint_core_record_coords     (const GimpCoords    *coords);
+
+gboolean             gimp_paint_core_replay            (GimpPaintCore       *core,
+                                                        GimpDrawable        *drawable,
+                                                        GimpPaintOptions    *paint_options,
+                                                        GPtrArray           *strokes,
+                                                        gboolean             push_undo,
+                                                        GimpPaintCoreStats  *stats,
+                                                        GError             **error);
+
+GimpPaintCoreStats * gimp_paint_core_stats_new         (void);
+void                 gimp_paint_core_stats_free        (GimpPaintCoreStats  *stats);
+
+gint                 gimp_paint_core_stats_get_n_dabs  (GimpPaintCoreStats  *stats);
+gdouble              gimp_paint_core_stats_get_dabs_per_second
+                                                       (GimpPaintCoreStats  *stats);
+gdouble              gimp_paint_core_stats_get_dab_time
+                                                       (GimpPaintCoreStats  *stats,
+                                                        gdouble              percentile);
+
+
+#endif  /*  __GIMP_PAINT_CORE_REPLAY_H__  */
@@ -42,11 +42,14 @@
 #include "core/gimptempbuf.h"
 
 #include "gimppaintcore.h"
+#include "gimppaintcore-replay.h"
 #include "gimppaintcoreundo.h"
 #include "gimppaintoptions.h"
 
 #include "gimpairbrush.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -290,6 +293,7 @@ gimp_paint_core_paint (GimpPaintCore    *core,
                        guint32           time)
 {
   GimpPaintCoreClass *core_class;
+  gint64              start = 0;
 
   g_return_if_fail (GIMP_IS_PAINT_CORE (core));
   g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
@@ -310,11 +314,25 @@ gimp_paint_core_paint (GimpPaintCore    *core,
           core->last_paint.y = core->cur_coords.y;
         }
 
+      GIMP_TRACE_BEGIN ("paint", "dab");
+
+      if (core->stats)
+        start = g_get_monotonic_time ();
+
       core_class->paint (core, drawable,
                          paint_options,
                          &core->cur_coords,
                          paint_state, time);
 
+      if (core->stats && paint_state == GIMP_PAINT_STATE_MOTION)
+        {
+          gint64 dab_time = g_get_monotonic_time () - start;
+
+          g_array_append_val (core->stats->dab_times, dab_time);
+        }
+
+      GIMP_TRACE_END ("paint", "dab");
+
       core_class->post_paint (core, drawable,
                               paint_options,
                               paint_state, time);
@@ -360,6 +378,9 @@ gimp_paint_core_start (GimpPaintCore     *core,
       return FALSE;
     }
 
+  /*  only record strokes that are actually painted  */
+  gimp_paint_core_record_stroke (coords);
+
   /*  Allocate the undo structure  */
   if (core->undo_buffer)
     g_object_unref (core->undo_buffer);
@@ -467,6 +488,10 @@ gimp_paint_core_finish (GimpPaintCore *core,
     {
       GeglBuffer *buffer;
       gint        x, y, width, height;
+      gint64      start = 0;
+
+      if (core->stats)
+        start = g_get_monotonic_time ();
 
       gimp_rectangle_intersect (core->x1, core->y1,
                                 core->x2 - core->x1, core->y2 - core->y1,
@@ -494,6 +519,9 @@ gimp_paint_core_finish (GimpPaintCore *core,
       g_object_unref (buffer);
 
       gimp_image_undo_group_end (image);
+
+      if (core->stats)
+        core->stats->undo_time += g_get_monotonic_time () - start;
     }
 
   g_object_unref (core->undo_buffer);
@@ -598,6 +626,8 @@ gimp_paint_core_interpolate (GimpPaintCore    *core,
 
   core->cur_coords = *coords;
 
+  gimp_paint_core_record_coords (coords);
+
   GIMP_PAINT_CORE_GET_CLASS (core)->interpolate (core, drawable,
                                                  paint_options, time);
 }
@@ -744,6 +774,10 @@ gimp_paint_core_paste (GimpPaintCore            *core,
   GeglBuffer *base_buffer = NULL;
   gint        width       = gegl_buffer_get_width  (core->paint_buffer);
   gint        height      = gegl_buffer_get_height (core->paint_buffer);
+  gint64      start       = 0;
+
+  if (core->stats)
+    start = g_get_monotonic_time ();
 
   /*  If the mode is CONSTANT:
    *   combine the canvas buf, the paint mask to the canvas buffer
@@ -795,6 +829,9 @@ gimp_paint_core_paste (GimpPaintCore            *core,
                          core->paint_buffer_y,
                          image_opacity, paint_mode);
 
+  if (core->stats)
+    core->stats->applicator_time += g_get_monotonic_time () - start;
+
   /*  Update the undo extents  */
   core->x1 = MIN (core->x1, core->paint_buffer_x);
   core->y1 = MIN (core->y1, core->paint_buffer_y);
@@ -827,6 +864,7 @@ gimp_paint_core_replace (GimpPaintCore            *core,
 {
   GeglRectangle mask_rect;
   gint          width, height;
+  gint64        start = 0;
 
   if (! gimp_drawable_has_alpha (drawable))
     {
@@ -838,6 +876,9 @@ gimp_paint_core_replace (GimpPaintCore            *core,
       return;
     }
 
+  if (core->stats)
+    start = g_get_monotonic_time ();
+
   width  = gegl_buffer_get_width  (core->paint_buffer);
   height = gegl_buffer_get_height (core->paint_buffer);
 
@@ -878,6 +919,9 @@ gimp_paint_core_replace (GimpPaintCore            *core,
                                 core->paint_buffer_x,
                                 core->paint_buffer_y);
 
+  if (core->stats)
+    core->stats->applicator_time += g_get_monotonic_time () - start;
+
   /*  Update the undo extents  */
   core->x1 = MIN (core->x1, core->paint_buffer_x);
   core->y1 = MIN (core->y1, core->paint_buffer_y);
@@ -66,6 +66,8 @@ struct _GimpPaintCore
   GArray      *stroke_buffer;
 
   GimpApplicator *applicator;
+
+  GimpPaintCoreStats *stats;      /*  timings of a replayed stroke        */
 };
 
 struct _GimpPaintCoreClass
@@ -64,6 +64,11 @@ typedef struct _GimpPaintCoreUndo GimpPaintCoreUndo;
 typedef struct _GimpInkUndo       GimpInkUndo;
 
 
+/*  misc types  */
+
+typedef struct _GimpPaintCoreStats GimpPaintCoreStats;
+
+
 /*  functions  */
 
 typedef void (* GimpPaintRegisterCallback) (Gimp        *gimp,
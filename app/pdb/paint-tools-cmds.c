@@ -35,9 +35,11 @@
 #include "core/gimpdynamics.h"
 #include "core/gimppaintinfo.h"
 #include "core/gimpparamspecs.h"
+#include "paint/gimppaintcore-replay.h"
 #include "paint/gimppaintcore-stroke.h"
 #include "paint/gimppaintcore.h"
 #include "paint/gimppaintoptions.h"
+#include "paint/gimpsourcecore.h"
 
 #include "gimppdb.h"
 #include "gimppdb-utils.h"
@@ -48,6 +50,31 @@
 
 static const GimpCoords default_coords = GIMP_COORDS_DEFAULT_VALUES;
 
+static void
+paint_tools_setup_options (GimpContext      *context,
+                           GimpPaintOptions *options)
+{
+  GimpBrush *brush;
+  gdouble    brush_size;
+  gint       height, width;
+
+  brush = gimp_context_get_brush (context);
+  gimp_brush_transform_size (brush, 1.0, 1.0, 0.0, &height, &width);
+  brush_size = MAX (height, width);
+
+  g_object_set (options,
+                "brush-size", brush_size,
+                NULL);
+
+  /*  undefine the paint-relevant context properties and get them
+   *  from the current context
+   */
+  gimp_context_define_properties (GIMP_CONTEXT (options),
+                                  GIMP_CONTEXT_PAINT_PROPS_MASK,
+                                  FALSE);
+  gimp_context_set_parent (GIMP_CONTEXT (options), context);
+}
+
 static gboolean
 paint_tools_stroke (Gimp              *gimp,
                     GimpContext       *context,
@@ -61,30 +88,13 @@ paint_tools_stroke (Gimp              *gimp,
 {
   GimpPaintCore *core;
   GimpCoords    *coords;
-  GimpBrush     *brush;
   gboolean       retval;
-  gdouble        brush_size;
-  gint           height, width;
   gint           i;
   va_list        args;
 
   n_strokes /= 2;  /* #doubles -> #points */
 
-  brush = gimp_context_get_brush (context);
-  gimp_brush_transform_size (brush, 1.0, 1.0, 0.0, &height, &width);
-  brush_size = MAX (height, width);
-
-  g_object_set (options,
-                "brush-size", brush_size,
-                NULL);
-
-  /*  undefine the paint-relevant context properties and get them
-   *  from the current context
-   */
-  gimp_context_define_properties (GIMP_CONTEXT (options),
-                                  GIMP_CONTEXT_PAINT_PROPS_MASK,
-                                  FALSE);
-  gimp_context_set_parent (GIMP_CONTEXT (options), context);
+  paint_tools_setup_options (context, options);
 
   va_start (args, first_property_name);
   core = GIMP_PAINT_CORE (g_object_new_valist (options->paint_info->paint_type,
@@ -934,6 +944,110 @@ smudge_default_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+paint_replay_strokes_invoker (GimpProcedure         *procedure,
+                              Gimp                  *gimp,
+                              GimpContext           *context,
+                              GimpProgress          *progress,
+                              const GimpValueArray  *args,
+                              GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpDrawable *drawable;
+  const gchar *paint_method;
+  const gchar *filename;
+  gint32 num_dabs = 0;
+  gdouble dabs_per_second = 0.0;
+  gdouble dab_time_median = 0.0;
+  gdouble dab_time_90 = 0.0;
+  gdouble dab_time_99 = 0.0;
+  gdouble mask_time = 0.0;
+  gdouble applicator_time = 0.0;
+  gdouble undo_time = 0.0;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+  paint_method = g_value_get_string (gimp_value_array_index (args, 1));
+  filename = g_value_get_string (gimp_value_array_index (args, 2));
+
+  if (success)
+    {
+      GimpPaintInfo *info = gimp_pdb_get_paint_info (gimp, paint_method, error);
+
+      if (info &&
+          gimp_pdb_item_is_attached (GIMP_ITEM (drawable), NULL, TRUE, error) &&
+          gimp_pdb_item_is_not_group (GIMP_ITEM (drawable), error))
+        {
+          GPtrArray *strokes = gimp_paint_core_recording_load (filename, error);
+
+          if (strokes)
+            {
+              GimpPaintOptions   *options;
+              GimpPaintCore      *core;
+              GimpPaintCoreStats *stats = gimp_paint_core_stats_new ();
+
+              options =
+                gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
+                                                    gimp_object_get_name (info));
+              options = gimp_config_duplicate (GIMP_CONFIG (options));
+
+              paint_tools_setup_options (context, options);
+
+              core = g_object_new (info->paint_type,
+                                   "undo-desc", info->blurb,
+                                   NULL);
+
+              /*  source cores paint from the drawable itself  */
+              if (GIMP_IS_SOURCE_CORE (core))
+                g_object_set (core,
+                              "src-drawable", drawable,
+                              NULL);
+
+              success = gimp_paint_core_replay (core, drawable, options,
+                                                strokes, TRUE, stats, error);
+
+              if (success)
+                {
+                  num_dabs        = gimp_paint_core_stats_get_n_dabs (stats);
+                  dabs_per_second = gimp_paint_core_stats_get_dabs_per_second (stats);
+                  dab_time_median = gimp_paint_core_stats_get_dab_time (stats, 50.0);
+                  dab_time_90     = gimp_paint_core_stats_get_dab_time (stats, 90.0);
+                  dab_time_99     = gimp_paint_core_stats_get_dab_time (stats, 99.0);
+                  mask_time       = stats->mask_time       / 1000000.0;
+                  applicator_time = stats->applicator_time / 1000000.0;
+                  undo_time       = stats->undo_time       / 1000000.0;
+                }
+
+              gimp_paint_core_stats_free (stats);
+              g_object_unref (core);
+              g_object_unref (options);
+              g_ptr_array_unref (strokes);
+            }
+          else
+            success = FALSE;
+        }
+      else
+        success = FALSE;
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_int (gimp_value_array_index (return_vals, 1), num_dabs);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), dabs_per_second);
+      g_value_set_double (gimp_value_array_index (return_vals, 3), dab_time_median);
+      g_value_set_double (gimp_value_array_index (return_vals, 4), dab_time_90);
+      g_value_set_double (gimp_value_array_index (return_vals, 5), dab_time_99);
+      g_value_set_double (gimp_value_array_index (return_vals, 6), mask_time);
+      g_value_set_double (gimp_value_array_index (return_vals, 7), applicator_time);
+      g_value_set_double (gimp_value_array_index (return_vals, 8), undo_time);
+    }
+
+  return return_vals;
+}
+
 void
 register_paint_tools_procs (GimpPDB *pdb)
 {
@@ -1637,4 +1751,89 @@ register_paint_tools_procs (GimpPDB *pdb)
                                                             GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-paint-replay-strokes
+   */
+  procedure = gimp_procedure_new (paint_replay_strokes_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-paint-replay-strokes");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-paint-replay-strokes",
+                                     "Replay recorded paint strokes with a paint method and time them.",
+                                     "This procedure paints the strokes recorded in a file, which can be created with \"Record Strokes\" in the Debug menu, on the specified drawable using the specified paint method with the current context's paint settings, and returns timings of the painting. It is meant to measure the performance of the paint methods reproducibly.",
+                                     "The GIMP Team",
+                                     "The GIMP Team",
+                                     "2026",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The affected drawable",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("paint-method",
+                                                       "paint method",
+                                                       "The name of the paint method",
+                                                       FALSE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("filename",
+                                                       "filename",
+                                                       "The name of the stroke recording",
+                                                       TRUE, FALSE, FALSE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-dabs",
+                                                          "num dabs",
+                                                          "The number of dabs painted",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("dabs-per-second",
+                                                        "dabs per second",
+                                                        "The number of dabs painted per second",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("dab-time-median",
+                                                        "dab time median",
+                                                        "The median time of a dab, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("dab-time-90",
+                                                        "dab time 90",
+                                                        "The 90th percentile time of a dab, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("dab-time-99",
+                                                        "dab time 99",
+                                                        "The 99th percentile time of a dab, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("mask-time",
+                                                        "mask time",
+                                                        "The time spent transforming brush masks, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("applicator-time",
+                                                        "applicator time",
+                                                        "The time spent applying paint, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("undo-time",
+                                                        "undo time",
+                                                        "The time spent pushing undo steps, in seconds",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
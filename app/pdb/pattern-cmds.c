@@ -61,12 +61,16 @@ pattern_get_info_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPattern *pattern = gimp_pdb_get_pattern (gimp, name, error);
+      GimpTempBuf *mask    = NULL;
 
       if (pattern)
+        mask = gimp_pattern_get_mask (pattern);
+
+      if (mask)
         {
-          width  = gimp_temp_buf_get_width  (pattern->mask);
-          height = gimp_temp_buf_get_height (pattern->mask);
-          bpp    = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (pattern->mask));
+          width  = gimp_temp_buf_get_width  (mask);
+          height = gimp_temp_buf_get_height (mask);
+          bpp    = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (mask));
         }
       else
         success = FALSE;
@@ -107,14 +111,18 @@ pattern_get_pixels_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPattern *pattern = gimp_pdb_get_pattern (gimp, name, error);
+      GimpTempBuf *mask    = NULL;
 
       if (pattern)
+        mask = gimp_pattern_get_mask (pattern);
+
+      if (mask)
         {
-          width           = gimp_temp_buf_get_width  (pattern->mask);
-          height          = gimp_temp_buf_get_height (pattern->mask);
-          bpp             = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (pattern->mask));
-          num_color_bytes = gimp_temp_buf_get_data_size (pattern->mask);
-          color_bytes     = g_memdup (gimp_temp_buf_get_data (pattern->mask),
+          width           = gimp_temp_buf_get_width  (mask);
+          height          = gimp_temp_buf_get_height (mask);
+          bpp             = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (mask));
+          num_color_bytes = gimp_temp_buf_get_data_size (mask);
+          color_bytes     = g_memdup (gimp_temp_buf_get_data (mask),
                                       num_color_bytes);
         }
       else
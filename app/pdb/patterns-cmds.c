@@ -105,12 +105,16 @@ patterns_get_pattern_invoker (GimpProcedure         *procedure,
   gint32 height = 0;
 
   GimpPattern *pattern = gimp_context_get_pattern (context);
+  GimpTempBuf *mask    = NULL;
 
   if (pattern)
+    mask = gimp_pattern_get_mask (pattern);
+
+  if (mask)
     {
       name   = g_strdup (gimp_object_get_name (pattern));
-      width  = gimp_temp_buf_get_width  (pattern->mask);
-      height = gimp_temp_buf_get_height (pattern->mask);
+      width  = gimp_temp_buf_get_width  (mask);
+      height = gimp_temp_buf_get_height (mask);
     }
   else
     success = FALSE;
@@ -151,6 +155,7 @@ patterns_get_pattern_data_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPattern *pattern;
+      GimpTempBuf *mask = NULL;
 
       if (name && strlen (name))
         pattern = gimp_pdb_get_pattern (gimp, name, error);
@@ -158,13 +163,16 @@ patterns_get_pattern_data_invoker (GimpProcedure         *procedure,
         pattern = gimp_context_get_pattern (context);
 
       if (pattern)
+        mask = gimp_pattern_get_mask (pattern);
+
+      if (mask)
         {
           actual_name = g_strdup (gimp_object_get_name (pattern));
-          width       = gimp_temp_buf_get_width  (pattern->mask);
-          height      = gimp_temp_buf_get_height (pattern->mask);
-          mask_bpp    = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (pattern->mask));
-          length      = gimp_temp_buf_get_data_size (pattern->mask);
-          mask_data   = g_memdup (gimp_temp_buf_get_data (pattern->mask), length);
+          width       = gimp_temp_buf_get_width  (mask);
+          height      = gimp_temp_buf_get_height (mask);
+          mask_bpp    = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (mask));
+          length      = gimp_temp_buf_get_data_size (mask);
+          mask_data   = g_memdup (gimp_temp_buf_get_data (mask), length);
         }
       else
         success = FALSE;
@@ -50,6 +50,8 @@
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -124,7 +126,9 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
       break;
 
     case GP_PROC_RUN:
+      GIMP_TRACE_BEGIN ("plug-in", "proc-run");
       gimp_plug_in_handle_proc_run (plug_in, msg->data);
+      GIMP_TRACE_END ("plug-in", "proc-run");
       break;
 
     case GP_PROC_RETURN:
@@ -178,9 +182,21 @@ gimp_plug_in_handle_tile_request (GimpPlugIn *plug_in,
   g_return_if_fail (request != NULL);
 
   if (request->drawable_ID == -1)
-    gimp_plug_in_handle_tile_put (plug_in, request);
+    {
+      GIMP_TRACE_BEGIN ("plug-in", "tile-put");
+      gimp_plug_in_handle_tile_put (plug_in, request);
+      GIMP_TRACE_END ("plug-in", "tile-put");
+
+      plug_in->manager->n_tile_puts++;
+    }
   else
-    gimp_plug_in_handle_tile_get (plug_in, request);
+    {
+      GIMP_TRACE_BEGIN ("plug-in", "tile-get");
+      gimp_plug_in_handle_tile_get (plug_in, request);
+      GIMP_TRACE_END ("plug-in", "tile-get");
+
+      plug_in->manager->n_tile_gets++;
+    }
 }
 
 static void
@@ -157,6 +157,9 @@ gimp_plug_in_manager_init (GimpPlugInManager *manager)
   manager->environ_table      = gimp_environ_table_new ();
   manager->debug              = NULL;
   manager->data_list          = NULL;
+
+  manager->n_tile_gets        = 0;
+  manager->n_tile_puts        = 0;
 }
 
 static void
@@ -62,6 +62,9 @@ struct _GimpPlugInManager
   GimpEnvironTable  *environ_table;
   GimpPlugInDebug   *debug;
   GList             *data_list;
+
+  guint64            n_tile_gets;
+  guint64            n_tile_puts;
 };
 
 struct _GimpPlugInManagerClass
@@ -20,6 +20,8 @@
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "display/display-types.h"
 
 #include "display/gimpdisplay.h"
@@ -30,8 +32,14 @@
 #include "widgets/gimpdialogfactory.h"
 
 #include "core/gimp.h"
+#include "core/gimpbrushgenerated.h"
+#include "core/gimpcontainer.h"
+#include "core/gimpcontext.h"
 #include "core/gimpimage.h"
 #include "core/gimplayer.h"
+#include "core/gimppaintinfo.h"
+
+#include "paint/gimppaintoptions.h"
 
 #include "tests.h"
 
@@ -141,6 +149,226 @@ gimp_test_utils_create_image (Gimp *gimp,
                        1.0 /*scale*/);
 }
 
+/**
+ * gimp_test_utils_create_synthetic_image:
+ * @gimp:      A #Gimp instance.
+ * @width:     Width of image (and layers)
+ * @height:    Height of image (and layers)
+ * @precision: Precision of the image
+ * @n_layers:  Number of layers
+ *
+ * Creates a new RGB image of a given size and precision with
+ * @n_layers semi-transparent layers of same size, each filled with a
+ * different noisy gradient. The image has no display, so it can be
+ * used for headless tests and benchmarks.
+ *
+ * Returns: The new #GimpImage.
+ **/
+GimpImage *
+gimp_test_utils_create_synthetic_image (Gimp          *gimp,
+                                        gint           width,
+                                        gint           height,
+                                        GimpPrecision  precision,
+                                        gint           n_layers)
+{
+  GimpImage *image;
+  GRand     *rand = g_rand_new_with_seed (42);
+  guchar    *row  = g_new (guchar, width * 4);
+  gint       i;
+
+  image = gimp_image_new (gimp, width, height, GIMP_RGB, precision);
+
+  for (i = 0; i < n_layers; i++)
+    {
+      GimpLayer  *layer;
+      GeglBuffer *buffer;
+      gint        x, y;
+
+      layer = gimp_layer_new (image, width, height,
+                              gimp_image_get_layer_format (image, TRUE),
+                              "Synthetic Layer", 1.0, GIMP_NORMAL_MODE);
+
+      buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+
+      for (y = 0; y < height; y++)
+        {
+          for (x = 0; x < width; x++)
+            {
+              guchar *pixel = row + x * 4;
+              gint    noise = g_rand_int_range (rand, -16, 16);
+
+              pixel[0] = CLAMP (x * 255 / width + noise, 0, 255);
+              pixel[1] = CLAMP (y * 255 / height + noise, 0, 255);
+              pixel[2] = CLAMP (i * 255 / n_layers + noise, 0, 255);
+              pixel[3] = (i == 0) ? 255 : CLAMP (128 + noise * 4, 0, 255);
+            }
+
+          gegl_buffer_set (buffer, GEGL_RECTANGLE (0, y, width, 1), 0,
+                           babl_format ("R'G'B'A u8"), row,
+                           GEGL_AUTO_ROWSTRIDE);
+        }
+
+      gimp_image_add_layer (image, layer,
+                            GIMP_IMAGE_ACTIVE_PARENT, -1, FALSE);
+    }
+
+  g_free (row);
+  g_rand_free (rand);
+
+  return image;
+}
+
+/**
+ * gimp_test_utils_create_striped_image:
+ * @gimp:     A #Gimp instance.
+ * @width:    Width of image (and layers)
+ * @height:   Height of image (and layers)
+ * @n_layers: Number of layers
+ * @n_colors: Number of colors, at most 216
+ *
+ * Creates a new 8-bit RGB image of a given size with @n_layers opaque
+ * layers of same size, each filled with @n_colors vertical stripes of
+ * web palette colors. The stripes of each layer are shifted by one
+ * color. The image has no display.
+ *
+ * Returns: The new #GimpImage.
+ **/
+GimpImage *
+gimp_test_utils_create_striped_image (Gimp *gimp,
+                                      gint  width,
+                                      gint  height,
+                                      gint  n_layers,
+                                      gint  n_colors)
+{
+  GimpImage *image;
+  guchar    *row = g_new (guchar, width * 3);
+  gint       i;
+
+  g_return_val_if_fail (n_colors > 0 && n_colors <= 216, NULL);
+
+  image = gimp_image_new (gimp, width, height, GIMP_RGB, GIMP_PRECISION_U8);
+
+  for (i = 0; i < n_layers; i++)
+    {
+      GimpLayer  *layer;
+      GeglBuffer *buffer;
+      gint        x, y;
+
+      layer = gimp_layer_new (image, width, height,
+                              gimp_image_get_layer_format (image, FALSE),
+                              "Striped Layer", 1.0, GIMP_NORMAL_MODE);
+
+      buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+
+      for (x = 0; x < width; x++)
+        {
+          guchar *pixel  = row + x * 3;
+          gint    stripe = (x * n_colors / width + i) % n_colors;
+
+          pixel[0] = 51 * (stripe % 6);
+          pixel[1] = 51 * (stripe / 6 % 6);
+          pixel[2] = 51 * (5 - stripe / 36 % 6);
+        }
+
+      for (y = 0; y < height; y++)
+        gegl_buffer_set (buffer, GEGL_RECTANGLE (0, y, width, 1), 0,
+                         babl_format ("R'G'B' u8"), row,
+                         GEGL_AUTO_ROWSTRIDE);
+
+      gimp_image_add_layer (image, layer,
+                            GIMP_IMAGE_ACTIVE_PARENT, -1, FALSE);
+    }
+
+  g_free (row);
+
+  return image;
+}
+
+/**
+ * gimp_test_utils_create_paint_options:
+ * @gimp:       A #Gimp instance.
+ * @identifier: Identifier of the paint core, e.g. "gimp-paintbrush"
+ * @brush_size: Size of the brush
+ *
+ * Creates the options of the paint core @identifier, painting with a
+ * generated circle brush scaled to @brush_size. The other properties
+ * are taken from the user context.
+ *
+ * Returns: The new #GimpPaintOptions.
+ **/
+GimpPaintOptions *
+gimp_test_utils_create_paint_options (Gimp        *gimp,
+                                      const gchar *identifier,
+                                      gdouble      brush_size)
+{
+  GimpPaintInfo    *info;
+  GimpPaintOptions *options;
+  GimpData         *brush;
+
+  info = (GimpPaintInfo *)
+    gimp_container_get_child_by_name (gimp->paint_info_list, identifier);
+
+  g_assert (info != NULL);
+
+  options = gimp_paint_options_new (info);
+
+  gimp_context_define_properties (GIMP_CONTEXT (options),
+                                  GIMP_CONTEXT_PAINT_PROPS_MASK,
+                                  FALSE);
+  gimp_context_set_parent (GIMP_CONTEXT (options),
+                           gimp_get_user_context (gimp));
+
+  brush = gimp_brush_generated_new ("Test Brush",
+                                    GIMP_BRUSH_GENERATED_CIRCLE,
+                                    50.0, 2, 0.5, 1.0, 0.0);
+
+  gimp_context_set_brush (GIMP_CONTEXT (options), GIMP_BRUSH (brush));
+
+  g_object_set (options,
+                "brush-size", brush_size,
+                NULL);
+
+  g_object_unref (brush);
+
+  return options;
+}
+
+/**
+ * gimp_test_utils_create_stroke:
+ * @coords:   Array to fill
+ * @n_coords: Number of elements of @coords, at least 2
+ * @width:    Width of the image to paint on
+ * @height:   Height of the image to paint on
+ *
+ * Fills @coords with a sine wave across a @width by @height image,
+ * with varying pressure, tilt and velocity like a stroke made with a
+ * tablet.
+ **/
+void
+gimp_test_utils_create_stroke (GimpCoords *coords,
+                               gint        n_coords,
+                               gint        width,
+                               gint        height)
+{
+  const GimpCoords default_coords = GIMP_COORDS_DEFAULT_VALUES;
+  gint             i;
+
+  g_return_if_fail (n_coords >= 2);
+
+  for (i = 0; i < n_coords; i++)
+    {
+      gdouble t = (gdouble) i / (n_coords - 1);
+
+      coords[i]          = default_coords;
+      coords[i].x        = width  * (0.1 + 0.8 * t);
+      coords[i].y        = height * (0.5 + 0.3 * sin (t * 4.0 * G_PI));
+      coords[i].pressure = 0.5 + 0.5 * sin (t * G_PI);
+      coords[i].xtilt    = 0.5 * cos (t * G_PI);
+      coords[i].ytilt    = -0.25;
+      coords[i].velocity = 0.2 + 0.1 * cos (t * 4.0 * G_PI);
+    }
+}
+
 /**
  * gimp_test_utils_synthesize_key_event:
  * @widget: Widget to target.
@@ -28,6 +28,25 @@ void            gimp_test_utils_setup_menus_dir      (void);
 void            gimp_test_utils_create_image         (Gimp        *gimp,
                                                       gint         width,
                                                       gint         height);
+GimpImage     * gimp_test_utils_create_synthetic_image
+                                                     (Gimp          *gimp,
+                                                      gint           width,
+                                                      gint           height,
+                                                      GimpPrecision  precision,
+                                                      gint           n_layers);
+GimpImage     * gimp_test_utils_create_striped_image (Gimp        *gimp,
+                                                      gint         width,
+                                                      gint         height,
+                                                      gint         n_layers,
+                                                      gint         n_colors);
+GimpPaintOptions *
+                gimp_test_utils_create_paint_options (Gimp        *gimp,
+                                                      const gchar *identifier,
+                                                      gdouble      brush_size);
+void            gimp_test_utils_create_stroke        (GimpCoords  *coords,
+                                                      gint         n_coords,
+                                                      gint         width,
+                                                      gint         height);
 void            gimp_test_utils_synthesize_key_event (GtkWidget   *widget,
                                                       guint        keyval);
 GimpUIManager * gimp_test_utils_get_ui_manager       (Gimp        *gimp);
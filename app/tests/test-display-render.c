@@ -0,0 +1,120 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "display/gimpdisplayshell-render-private.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimpdisplayshell-render/" #function, function);
+
+
+/**
+ * check_reciprocals:
+ * @shift:        how far the product of the footprints is shifted
+ *                right to get the sum the filter divides by
+ * @max_quotient: the largest quotient the filter can produce
+ *
+ * Compares RECIPROCAL_DIVIDE() against a division for every sum the
+ * box filters can divide by, and every quotient up to @max_quotient.
+ *
+ * The rounded up reciprocal only ever makes a quotient too large, and
+ * its error grows with the numerator.  So the quotients are exact for
+ * all numerators if and only if they are for the smallest and the
+ * largest numerator giving each quotient, which are the two checked.
+ **/
+static void
+check_reciprocals (gint  shift,
+                   guint max_quotient)
+{
+  const gint  min  = GIMP_DISPLAY_RENDER_MIN_FOOTPRINT;
+  const gint  max  = GIMP_DISPLAY_RENDER_MAX_FOOTPRINT;
+  guchar     *seen = g_new0 (guchar, ((max * max) >> shift) + 1);
+  gint        footprint_x;
+  gint        footprint_y;
+
+  for (footprint_x = min; footprint_x <= max; footprint_x++)
+    for (footprint_y = min; footprint_y <= max; footprint_y++)
+      {
+        const guint   sum   = (footprint_x * footprint_y) >> shift;
+        const guint64 recip = RECIPROCAL (sum);
+        guint         quotient;
+
+        if (seen[sum])
+          continue;
+
+        seen[sum] = TRUE;
+
+        for (quotient = 0; quotient <= max_quotient; quotient++)
+          {
+            const guint first = quotient * sum;
+            const guint last  = first + sum - 1;
+
+            if (RECIPROCAL_DIVIDE (first, recip) != quotient ||
+                RECIPROCAL_DIVIDE (last,  recip) != quotient)
+              {
+                g_error ("%u / %u and %u / %u are not %u",
+                         first, sum, last, sum, quotient);
+              }
+          }
+      }
+
+  g_free (seen);
+}
+
+/**
+ * reciprocal_premultiplied:
+ *
+ * Test that box_filter() divides exactly.  Its numerators are
+ * premultiplied 8 bit values times the weights, which add up to the
+ * product of the footprints, so the quotients are at most 255.
+ **/
+static void
+reciprocal_premultiplied (void)
+{
+  check_reciprocals (0, 255);
+}
+
+/**
+ * reciprocal_separate_alpha:
+ *
+ * Test that box_filter_premult() divides exactly.  Its sum is the
+ * product of the footprints divided by 16, and the color numerators
+ * carry an additional factor of an 8 bit alpha, so the quotients are
+ * below 65536.
+ **/
+static void
+reciprocal_separate_alpha (void)
+{
+  check_reciprocals (4, 65535);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (reciprocal_premultiplied);
+  ADD_TEST (reciprocal_separate_alpha);
+
+  return g_test_run ();
+}
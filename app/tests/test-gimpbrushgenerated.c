@@ -0,0 +1,268 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "core/core-types.h"
+
+#include "core/gimpbrushgenerated.h"
+#include "core/gimptempbuf.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimpbrushgenerated/" #function, function);
+
+#define OVERSAMPLING 4
+
+
+/*  a straightforward copy of the per-pixel mask generation, without
+ *  any symmetry, to compare the optimized code paths against
+ */
+
+static gdouble
+reference_gauss (gdouble f)
+{
+  if (f < -0.5)
+    {
+      f = -1.0 - f;
+      return (2.0 * f*f);
+    }
+
+  if (f < 0.5)
+    return (1.0 - 2.0 * f*f);
+
+  f = 1.0 - f;
+  return (2.0 * f*f);
+}
+
+static guchar *
+reference_calc_lut (gdouble radius,
+                    gdouble hardness)
+{
+  guchar  *lookup;
+  gint     length;
+  gint     x;
+  gdouble  d;
+  gdouble  sum;
+  gdouble  exponent;
+  gdouble  buffer[OVERSAMPLING];
+
+  length = OVERSAMPLING * ceil (1 + sqrt (2 * SQR (ceil (radius + 1.0))));
+
+  lookup = g_malloc (length);
+  sum = 0.0;
+
+  if ((1.0 - hardness) < 0.0000004)
+    exponent = 1000000.0;
+  else
+    exponent = 0.4 / (1.0 - hardness);
+
+  for (x = 0; x < OVERSAMPLING; x++)
+    {
+      d = fabs ((x + 0.5) / OVERSAMPLING - 0.5);
+
+      if (d > radius)
+        buffer[x] = 0.0;
+      else
+        buffer[x] = reference_gauss (pow (d / radius, exponent));
+
+      sum += buffer[x];
+    }
+
+  for (x = 0; d < radius || sum > 0.00001; d += 1.0 / OVERSAMPLING)
+    {
+      sum -= buffer[x % OVERSAMPLING];
+
+      if (d > radius)
+        buffer[x % OVERSAMPLING] = 0.0;
+      else
+        buffer[x % OVERSAMPLING] = reference_gauss (pow (d / radius, exponent));
+
+      sum += buffer[x % OVERSAMPLING];
+      lookup[x++] = RINT (sum * (255.0 / OVERSAMPLING));
+    }
+
+  while (x < length)
+    {
+      lookup[x++] = 0;
+    }
+
+  return lookup;
+}
+
+/*  renders an unrotated two-spike mask of the given size  */
+static GimpTempBuf *
+reference_calc (GimpBrushGeneratedShape shape,
+                gfloat                  radius,
+                gfloat                  hardness,
+                gfloat                  aspect_ratio,
+                gint                    width,
+                gint                    height)
+{
+  GimpTempBuf *mask        = gimp_temp_buf_new (width, height,
+                                                babl_format ("Y u8"));
+  guchar      *data        = gimp_temp_buf_get_data (mask);
+  guchar      *lookup      = reference_calc_lut (radius, hardness);
+  gint         half_width  = width  / 2;
+  gint         half_height = height / 2;
+  gint         x, y;
+
+  for (y = -half_height; y <= half_height; y++)
+    {
+      for (x = -half_width; x <= half_width; x++)
+        {
+          gdouble tx = x;
+          gdouble ty = fabs (y) * aspect_ratio;
+          gdouble d  = 0;
+
+          switch (shape)
+            {
+            case GIMP_BRUSH_GENERATED_CIRCLE:
+              d = sqrt (SQR (tx) + SQR (ty));
+              break;
+            case GIMP_BRUSH_GENERATED_SQUARE:
+              d = MAX (fabs (tx), fabs (ty));
+              break;
+            case GIMP_BRUSH_GENERATED_DIAMOND:
+              d = fabs (tx) + fabs (ty);
+              break;
+            }
+
+          *data++ = (d < radius + 1) ? lookup[(gint) RINT (d * OVERSAMPLING)] : 0;
+        }
+    }
+
+  g_free (lookup);
+
+  return mask;
+}
+
+static GimpTempBuf *
+render_mask (GimpBrush *brush)
+{
+  return GIMP_BRUSH_GET_CLASS (brush)->transform_mask (brush,
+                                                       1.0, 0.0, 0.0, 1.0);
+}
+
+/**
+ * symmetric_masks:
+ *
+ * Test that the masks of unrotated brushes, which are computed for
+ * one quadrant and mirrored, match the masks computed pixel by pixel.
+ **/
+static void
+symmetric_masks (void)
+{
+  const GimpBrushGeneratedShape shapes[]   = { GIMP_BRUSH_GENERATED_CIRCLE,
+                                               GIMP_BRUSH_GENERATED_SQUARE,
+                                               GIMP_BRUSH_GENERATED_DIAMOND };
+  const gfloat                  radii[]    = { 0.5, 1.0, 2.5, 7.3, 25.0,
+                                               99.9, 250.0 };
+  const gfloat                  hardness[] = { 0.0, 0.5, 0.9, 1.0 };
+  const gfloat                  aspects[]  = { 1.0, 1.5, 3.0, 20.0 };
+  gint                          i, j, k, l;
+
+  for (i = 0; i < G_N_ELEMENTS (shapes); i++)
+    for (j = 0; j < G_N_ELEMENTS (radii); j++)
+      for (k = 0; k < G_N_ELEMENTS (hardness); k++)
+        for (l = 0; l < G_N_ELEMENTS (aspects); l++)
+          {
+            GimpData    *brush;
+            GimpTempBuf *mask;
+            GimpTempBuf *reference;
+
+            brush = gimp_brush_generated_new ("test", shapes[i], radii[j], 2,
+                                              hardness[k], aspects[l], 0.0);
+
+            mask = render_mask (GIMP_BRUSH (brush));
+            reference = reference_calc (shapes[i], radii[j],
+                                        hardness[k], aspects[l],
+                                        gimp_temp_buf_get_width  (mask),
+                                        gimp_temp_buf_get_height (mask));
+
+            g_assert_cmpint (0, ==,
+                             memcmp (gimp_temp_buf_get_data (mask),
+                                     gimp_temp_buf_get_data (reference),
+                                     gimp_temp_buf_get_data_size (mask)));
+
+            gimp_temp_buf_unref (reference);
+            gimp_temp_buf_unref (mask);
+            g_object_unref (brush);
+          }
+}
+
+/**
+ * mask_generation_speed:
+ *
+ * Time the generation of circle masks of radius 1 to 1000, unrotated
+ * and rotated.  Only run in performance mode ("-m perf").
+ **/
+static void
+mask_generation_speed (void)
+{
+  const gfloat radii[]  = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+  const gfloat angles[] = { 0.0, 30.0 };
+  gint         i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (angles); i++)
+    for (j = 0; j < G_N_ELEMENTS (radii); j++)
+      {
+        GimpData *brush;
+        gint      n_masks = MAX (1, 100000 / SQR ((gint) radii[j]));
+        gint      n;
+        gdouble   elapsed;
+
+        brush = gimp_brush_generated_new ("test",
+                                          GIMP_BRUSH_GENERATED_CIRCLE,
+                                          radii[j], 2, 0.5, 1.0, angles[i]);
+
+        g_test_timer_start ();
+
+        for (n = 0; n < n_masks; n++)
+          gimp_temp_buf_unref (render_mask (GIMP_BRUSH (brush)));
+
+        elapsed = g_test_timer_elapsed () / n_masks;
+
+        g_test_minimized_result (elapsed,
+                                 "radius %4g, angle %2g: %.3f ms per mask",
+                                 radii[j], angles[i], elapsed * 1000.0);
+
+        g_object_unref (brush);
+      }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  gegl_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (symmetric_masks);
+
+  if (g_test_perf ())
+    ADD_TEST (mask_generation_speed);
+
+  return g_test_run ();
+}
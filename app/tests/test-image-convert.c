@@ -0,0 +1,393 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-colormap.h"
+#include "core/gimpimage-convert.h"
+#include "core/gimplayer.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-image-convert/" #function, gimp, function);
+
+#define PERF_IMAGE_SIZE   1024
+#define PERF_IMAGE_LAYERS 4
+
+#define DITHER_SIZE       32
+
+
+static guchar *
+get_layer_pixels (GimpLayer  *layer,
+                  const Babl *format)
+{
+  gint    width  = gimp_item_get_width  (GIMP_ITEM (layer));
+  gint    height = gimp_item_get_height (GIMP_ITEM (layer));
+  guchar *pixels;
+
+  pixels = g_malloc (width * height * babl_format_get_bytes_per_pixel (format));
+
+  gegl_buffer_get (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                   GEGL_RECTANGLE (0, 0, width, height), 1.0,
+                   format, pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return pixels;
+}
+
+/**
+ * few_colors_are_kept:
+ * @data:
+ *
+ * Test that converting an image with fewer colors than requested
+ * keeps every color exactly, even when dithering was asked for.
+ **/
+static void
+few_colors_are_kept (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpLayer *layer;
+  guchar    *before;
+  guchar    *after;
+
+  image = gimp_test_utils_create_striped_image (gimp, 64, 64, 2, 5);
+  layer = gimp_image_get_layer_iter (image)->data;
+
+  before = get_layer_pixels (layer, babl_format ("R'G'B' u8"));
+
+  g_assert (gimp_image_convert (image, GIMP_INDEXED,
+                                256, GIMP_FS_DITHER, FALSE, FALSE,
+                                GIMP_MAKE_PALETTE, NULL, NULL, NULL));
+
+  g_assert_cmpint (gimp_image_get_colormap_size (image), ==, 5);
+
+  after = get_layer_pixels (layer, babl_format ("R'G'B' u8"));
+
+  g_assert_cmpint (0, ==, memcmp (before, after, 64 * 64 * 3));
+
+  g_free (before);
+  g_free (after);
+  g_object_unref (image);
+}
+
+/**
+ * web_colors_are_kept:
+ * @data:
+ *
+ * Test that converting an image to the web palette maps colors that
+ * are in the palette to themselves.
+ **/
+static void
+web_colors_are_kept (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpLayer *layer;
+  guchar    *before;
+  guchar    *after;
+
+  image = gimp_test_utils_create_striped_image (gimp, 216, 16, 1, 216);
+  layer = gimp_image_get_layer_iter (image)->data;
+
+  before = get_layer_pixels (layer, babl_format ("R'G'B' u8"));
+
+  g_assert (gimp_image_convert (image, GIMP_INDEXED,
+                                256, GIMP_NO_DITHER, FALSE, FALSE,
+                                GIMP_WEB_PALETTE, NULL, NULL, NULL));
+
+  after = get_layer_pixels (layer, babl_format ("R'G'B' u8"));
+
+  g_assert_cmpint (0, ==, memcmp (before, after, 216 * 16 * 3));
+
+  g_free (before);
+  g_free (after);
+  g_object_unref (image);
+}
+
+/**
+ * positioned_dither_is_deterministic:
+ * @data:
+ *
+ * Test that positioned dithering of the same image gives the same
+ * indices twice, and only uses indices from the colormap.
+ **/
+static void
+positioned_dither_is_deterministic (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *images[2];
+  guchar    *indices[2];
+  gint       i;
+
+  for (i = 0; i < 2; i++)
+    {
+      GimpLayer *layer;
+
+      images[i] = gimp_test_utils_create_synthetic_image (gimp, 256, 256,
+                                                          GIMP_PRECISION_U8,
+                                                          1);
+      layer     = gimp_image_get_layer_iter (images[i])->data;
+
+      g_assert (gimp_image_convert (images[i], GIMP_INDEXED,
+                                    16, GIMP_FIXED_DITHER, FALSE, FALSE,
+                                    GIMP_MAKE_PALETTE, NULL, NULL, NULL));
+
+      indices[i] =
+        get_layer_pixels (layer,
+                          gimp_drawable_get_format_without_alpha (GIMP_DRAWABLE (layer)));
+    }
+
+  g_assert_cmpint (0, ==, memcmp (indices[0], indices[1], 256 * 256));
+
+  for (i = 0; i < 256 * 256; i++)
+    g_assert_cmpint (indices[0][i], <,
+                     gimp_image_get_colormap_size (images[0]));
+
+  for (i = 0; i < 2; i++)
+    {
+      g_free (indices[i]);
+      g_object_unref (images[i]);
+    }
+}
+
+/*  This is the positioned dither of median_cut_pass2_fixed_dither_rgb()
+ *  as it was before the candidates of a color were reused, reduced to
+ *  two-color palettes.  With two colors, the candidates are always
+ *  the colormap's entries 0 and 1, so the index only depends on the
+ *  distance of the color to both entries and on the dither matrix.
+ */
+static gint
+old_positioned_dither_index (const guchar *colormap,
+                             const guchar *pixel,
+                             gint          dmval)
+{
+  const guchar *color1 = colormap;
+  const guchar *color2 = colormap + 3;
+  gint          err1;
+  gint          err2;
+
+#define DISTP(R1,G1,B1,R2,G2,B2,D) do {D = sqrt( 30*SQR((R1)-(R2)) + \
+                                                 59*SQR((G1)-(G2)) + \
+                                                 11*SQR((B1)-(B2)) ); }while(0)
+
+  DISTP (color1[0], color1[1], color1[2],
+         pixel[0], pixel[1], pixel[2],
+         err1);
+  DISTP (color2[0], color2[1], color2[2],
+         pixel[0], pixel[1], pixel[2],
+         err2);
+
+#undef DISTP
+
+  if (err1 || err2)
+    {
+      const int proportion2 = (255 * err2) / (err1 + err2);
+
+      if (dmval > proportion2)
+        return 1;
+    }
+
+  return 0;
+}
+
+static void
+check_positioned_dither (GimpImage    *image,
+                         const guchar *matrix)
+{
+  GimpLayer    *layer  = gimp_image_get_layer_iter (image)->data;
+  gint          width  = gimp_item_get_width  (GIMP_ITEM (layer));
+  gint          height = gimp_item_get_height (GIMP_ITEM (layer));
+  const guchar *colormap;
+  guchar       *pixels;
+  guchar       *indices;
+  gint          x, y;
+
+  pixels = get_layer_pixels (layer, babl_format ("R'G'B' u8"));
+
+  g_assert (gimp_image_convert (image, GIMP_INDEXED,
+                                2, GIMP_FIXED_DITHER, FALSE, FALSE,
+                                GIMP_MONO_PALETTE, NULL, NULL, NULL));
+
+  g_assert_cmpint (gimp_image_get_colormap_size (image), ==, 2);
+
+  colormap = gimp_image_get_colormap (image);
+
+  indices =
+    get_layer_pixels (layer,
+                      gimp_drawable_get_format_without_alpha (GIMP_DRAWABLE (layer)));
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gint dmval = matrix[(x % DITHER_SIZE) * DITHER_SIZE +
+                            (y % DITHER_SIZE)];
+        gint i     = y * width + x;
+
+        g_assert_cmpint (indices[i], ==,
+                         old_positioned_dither_index (colormap,
+                                                      pixels + i * 3,
+                                                      dmval));
+      }
+
+  g_free (pixels);
+  g_free (indices);
+}
+
+/**
+ * positioned_dither_matches_old_code:
+ * @data:
+ *
+ * Test that positioned dithering to a two-color palette gives the
+ * same indices as the code before the candidates of a color were
+ * reused, both for an image with runs of the same color and for
+ * a noisy one.
+ **/
+static void
+positioned_dither_matches_old_code (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  guchar     matrix[DITHER_SIZE * DITHER_SIZE];
+  gint       i;
+
+  for (i = 0; i < DITHER_SIZE * DITHER_SIZE; i++)
+    matrix[i] = 1 + (i * 97) % 255;
+
+  gimp_image_convert_set_dither_matrix (matrix, DITHER_SIZE, DITHER_SIZE);
+
+  image = gimp_test_utils_create_striped_image (gimp, 1080, 32, 1, 216);
+  check_positioned_dither (image, matrix);
+  g_object_unref (image);
+
+  image = gimp_test_utils_create_synthetic_image (gimp, 256, 256,
+                                                  GIMP_PRECISION_U8, 1);
+  check_positioned_dither (image, matrix);
+  g_object_unref (image);
+
+  /*  restore the default matrix  */
+  gimp_image_convert_set_dither_matrix (NULL, 0, 0);
+}
+
+/**
+ * conversion_speed:
+ * @data:
+ *
+ * Time the conversion of a multi-layer image to a generated palette
+ * of 256 colors and to the web palette, with each kind of dithering.
+ * Only run in performance mode ("-m perf").
+ **/
+static void
+conversion_speed (gconstpointer data)
+{
+  Gimp                         *gimp            = GIMP (data);
+  const GimpConvertPaletteType  palettes[]      = { GIMP_MAKE_PALETTE,
+                                                    GIMP_WEB_PALETTE };
+  const gchar                  *palette_names[] = { "generated",
+                                                    "web" };
+  const GimpConvertDitherType   dithers[]       = { GIMP_NO_DITHER,
+                                                    GIMP_FS_DITHER,
+                                                    GIMP_FSLOWBLEED_DITHER,
+                                                    GIMP_FIXED_DITHER };
+  const gchar                  *dither_names[]  = { "none",
+                                                    "floyd-steinberg",
+                                                    "floyd-steinberg (low bleed)",
+                                                    "positioned" };
+  gint                          i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (palettes); i++)
+    for (j = 0; j < G_N_ELEMENTS (dithers); j++)
+      {
+        GimpImage *image;
+        gdouble    elapsed;
+
+        image = gimp_test_utils_create_synthetic_image (gimp,
+                                                        PERF_IMAGE_SIZE,
+                                                        PERF_IMAGE_SIZE,
+                                                        GIMP_PRECISION_U8,
+                                                        PERF_IMAGE_LAYERS);
+
+        g_test_timer_start ();
+
+        gimp_image_convert (image, GIMP_INDEXED,
+                            256, dithers[j], FALSE, FALSE,
+                            palettes[i], NULL, NULL, NULL);
+
+        elapsed = g_test_timer_elapsed ();
+
+        g_test_minimized_result (elapsed,
+                                 "%d layers of %dx%d, %s palette, "
+                                 "dither %s: %.3f s",
+                                 PERF_IMAGE_LAYERS,
+                                 PERF_IMAGE_SIZE, PERF_IMAGE_SIZE,
+                                 palette_names[i], dither_names[j], elapsed);
+
+        g_object_unref (image);
+      }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (few_colors_are_kept);
+  ADD_TEST (web_colors_are_kept);
+  ADD_TEST (positioned_dither_is_deterministic);
+  ADD_TEST (positioned_dither_matches_old_code);
+
+  if (g_test_perf ())
+    ADD_TEST (conversion_speed);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
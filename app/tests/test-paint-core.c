@@ -0,0 +1,396 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimppaintinfo.h"
+
+#include "paint/gimpheal-private.h"
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintcore-replay.h"
+#include "paint/gimppaintcore-stroke.h"
+#include "paint/gimppaintoptions.h"
+#include "paint/gimpsourcecore.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-paint-core/" #function, gimp, function);
+
+#define PERF_IMAGE_SIZE  2048
+#define PERF_STROKE_SIZE 500
+
+
+/*  heals one dab at (@x, @y) with the pixels at (@src_x, @src_y)  */
+static void
+heal_dab (GimpImage        *image,
+          GimpPaintOptions *options,
+          gdouble           x,
+          gdouble           y,
+          gdouble           src_x,
+          gdouble           src_y)
+{
+  GimpDrawable  *drawable = gimp_image_get_active_drawable (image);
+  GimpPaintCore *core;
+  GimpCoords     coords   = GIMP_COORDS_DEFAULT_VALUES;
+
+  core = g_object_new (options->paint_info->paint_type,
+                       "src-drawable", drawable,
+                       "src-x",        src_x,
+                       "src-y",        src_y,
+                       NULL);
+
+  coords.x = x;
+  coords.y = y;
+
+  g_assert (gimp_paint_core_stroke (core, drawable, options,
+                                    &coords, 1, FALSE, NULL));
+
+  g_object_unref (core);
+}
+
+/**
+ * heal_multigrid_matches_gauss_seidel:
+ * @data:
+ *
+ * Test that the multigrid laplace solver of the heal core finds the
+ * same solution as the plain Gauss-Siedel solver it replaced, on a
+ * circular mask over a noisy gradient. The solutions may differ by
+ * less than half a level, so that they round to the same 8-bit value
+ * or to adjacent ones; in practice the difference is below 0.05.
+ **/
+static void
+heal_multigrid_matches_gauss_seidel (gconstpointer data)
+{
+  const gint  size  = 64;
+  const gint  depth = 3;
+  const gint  n     = size * size * depth;
+  GRand      *rand  = g_rand_new_with_seed (42);
+  gfloat     *matrix_mg;
+  gfloat     *matrix_gs;
+  gfloat     *solution_mg;
+  gfloat     *solution_gs;
+  guchar     *mask;
+  gdouble     max_diff = 0.0;
+  gint        i, j, k;
+
+  matrix_mg   = g_new (gfloat, n);
+  matrix_gs   = g_new (gfloat, n);
+  solution_mg = g_new (gfloat, n);
+  solution_gs = g_new (gfloat, n);
+  mask        = g_new (guchar, size * size);
+
+  for (i = 0; i < size; i++)
+    for (j = 0; j < size; j++)
+      {
+        gdouble dx = j - size / 2.0;
+        gdouble dy = i - size / 2.0;
+
+        mask[i * size + j] = (SQR (dx) + SQR (dy) <
+                              SQR (size / 2.0 - 1.0));
+
+        for (k = 0; k < depth; k++)
+          {
+            gint off = (i * size + j) * depth + k;
+
+            matrix_mg[off] = ((j * 255.0 / size - i * 128.0 / size) *
+                              (k + 1) / 3.0 +
+                              g_rand_int_range (rand, -32, 32));
+            matrix_gs[off] = matrix_mg[off];
+          }
+      }
+
+  gimp_heal_laplace_loop (matrix_mg, size, depth, size,
+                          solution_mg, mask, TRUE);
+  gimp_heal_laplace_loop (matrix_gs, size, depth, size,
+                          solution_gs, mask, FALSE);
+
+  for (i = 0; i < n; i++)
+    max_diff = MAX (max_diff, fabs (solution_mg[i] - solution_gs[i]));
+
+  g_assert_cmpfloat (max_diff, <, 0.5);
+
+  g_free (mask);
+  g_free (solution_gs);
+  g_free (solution_mg);
+  g_free (matrix_gs);
+  g_free (matrix_mg);
+  g_rand_free (rand);
+}
+
+/**
+ * recording_round_trip:
+ * @data:
+ *
+ * Test that a recorded stroke holds the painted coordinates, and that
+ * saving and loading the recording keeps them exactly.
+ **/
+static void
+recording_round_trip (gconstpointer data)
+{
+  Gimp             *gimp = GIMP (data);
+  GimpImage        *image;
+  GimpPaintOptions *options;
+  GimpPaintCore    *core;
+  GimpCoords        coords[50];
+  GPtrArray        *recording;
+  GPtrArray        *loaded;
+  GArray           *stroke;
+  gchar            *filename;
+
+  image   = gimp_test_utils_create_synthetic_image (gimp, 256, 256,
+                                                    GIMP_PRECISION_U8, 1);
+  options = gimp_test_utils_create_paint_options (gimp, "gimp-paintbrush",
+                                                  20.0);
+
+  gimp_test_utils_create_stroke (coords, G_N_ELEMENTS (coords), 256, 256);
+
+  core = g_object_new (options->paint_info->paint_type, NULL);
+
+  gimp_paint_core_record_start ();
+
+  g_assert (gimp_paint_core_stroke (core,
+                                    gimp_image_get_active_drawable (image),
+                                    options,
+                                    coords, G_N_ELEMENTS (coords),
+                                    FALSE, NULL));
+
+  recording = gimp_paint_core_record_stop ();
+
+  g_assert_cmpint (recording->len, ==, 1);
+
+  stroke = g_ptr_array_index (recording, 0);
+
+  g_assert_cmpint (stroke->len, ==, G_N_ELEMENTS (coords));
+  g_assert_cmpint (0, ==, memcmp (stroke->data, coords, sizeof (coords)));
+
+  filename = g_build_filename (g_get_tmp_dir (), "gimp-test-strokes.txt",
+                               NULL);
+
+  g_assert (gimp_paint_core_recording_save (recording, filename, NULL));
+
+  loaded = gimp_paint_core_recording_load (filename, NULL);
+
+  g_assert (loaded != NULL);
+  g_assert_cmpint (loaded->len, ==, 1);
+
+  stroke = g_ptr_array_index (loaded, 0);
+
+  g_assert_cmpint (stroke->len, ==, G_N_ELEMENTS (coords));
+  g_assert_cmpint (0, ==, memcmp (stroke->data, coords, sizeof (coords)));
+
+  g_unlink (filename);
+
+  g_free (filename);
+  g_ptr_array_unref (loaded);
+  g_ptr_array_unref (recording);
+  g_object_unref (core);
+  g_object_unref (options);
+  g_object_unref (image);
+}
+
+/**
+ * heal_dab_speed:
+ * @data:
+ *
+ * Time single heal dabs with brush sizes from 25 to 800 pixels.
+ * Only run in performance mode ("-m perf").
+ **/
+static void
+heal_dab_speed (gconstpointer data)
+{
+  Gimp         *gimp    = GIMP (data);
+  const gdouble sizes[] = { 25, 50, 100, 200, 400, 800 };
+  GimpImage    *image;
+  gint          i;
+
+  image = gimp_test_utils_create_synthetic_image (gimp,
+                                                 PERF_IMAGE_SIZE,
+                                                 PERF_IMAGE_SIZE,
+                                                 GIMP_PRECISION_U8, 1);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      GimpPaintOptions *options;
+      gint              n_dabs = MAX (1, 2000 / (gint) sizes[i]);
+      gint              n;
+      gdouble           elapsed;
+
+      options = gimp_test_utils_create_paint_options (gimp, "gimp-heal",
+                                                      sizes[i]);
+
+      g_test_timer_start ();
+
+      for (n = 0; n < n_dabs; n++)
+        heal_dab (image, options,
+                  PERF_IMAGE_SIZE / 4 * 3, PERF_IMAGE_SIZE / 2,
+                  PERF_IMAGE_SIZE / 4,     PERF_IMAGE_SIZE / 2);
+
+      elapsed = g_test_timer_elapsed () / n_dabs;
+
+      g_test_minimized_result (elapsed,
+                               "brush size %3g: %.1f ms per dab",
+                               sizes[i], elapsed * 1000.0);
+
+      g_object_unref (options);
+    }
+
+  g_object_unref (image);
+}
+
+/**
+ * replay_speed:
+ * @data:
+ *
+ * Time replaying a recorded stroke through each kind of paint core,
+ * and report the dab rate, dab time percentiles and the time spent
+ * in brush transforms, paint application and undo.
+ * Only run in performance mode ("-m perf").
+ **/
+static void
+replay_speed (gconstpointer data)
+{
+  Gimp        *gimp    = GIMP (data);
+  const gchar *cores[] = { "gimp-paintbrush",
+                           "gimp-airbrush",
+                           "gimp-smudge",
+                           "gimp-clone",
+                           "gimp-heal",
+                           "gimp-ink",
+                           "gimp-dodge-burn" };
+  GPtrArray   *recording;
+  GArray      *stroke;
+  gint         i;
+
+  recording = gimp_paint_core_recording_new ();
+  stroke    = g_array_sized_new (FALSE, FALSE, sizeof (GimpCoords),
+                                 PERF_STROKE_SIZE);
+
+  g_array_set_size (stroke, PERF_STROKE_SIZE);
+  gimp_test_utils_create_stroke ((GimpCoords *) stroke->data,
+                                 PERF_STROKE_SIZE,
+                                 PERF_IMAGE_SIZE, PERF_IMAGE_SIZE);
+
+  g_ptr_array_add (recording, stroke);
+
+  for (i = 0; i < G_N_ELEMENTS (cores); i++)
+    {
+      GimpImage          *image;
+      GimpDrawable       *drawable;
+      GimpPaintOptions   *options;
+      GimpPaintCore      *core;
+      GimpPaintCoreStats *stats = gimp_paint_core_stats_new ();
+      gdouble             dabs_per_second;
+
+      image    = gimp_test_utils_create_synthetic_image (gimp,
+                                                         PERF_IMAGE_SIZE,
+                                                         PERF_IMAGE_SIZE,
+                                                         GIMP_PRECISION_U8,
+                                                         1);
+      drawable = gimp_image_get_active_drawable (image);
+      options  = gimp_test_utils_create_paint_options (gimp, cores[i], 50.0);
+
+      core = g_object_new (options->paint_info->paint_type, NULL);
+
+      if (GIMP_IS_SOURCE_CORE (core))
+        g_object_set (core,
+                      "src-drawable", drawable,
+                      "src-x",        PERF_IMAGE_SIZE / 4.0,
+                      "src-y",        PERF_IMAGE_SIZE / 4.0,
+                      NULL);
+
+      g_assert (gimp_paint_core_replay (core, drawable, options,
+                                        recording, TRUE, stats, NULL));
+
+      dabs_per_second = gimp_paint_core_stats_get_dabs_per_second (stats);
+
+      g_test_minimized_result (1.0 / dabs_per_second,
+                               "%s: %d dabs, %.0f dabs/s, "
+                               "median %.2f ms, 90%% %.2f ms, 99%% %.2f ms, "
+                               "mask %.3f s, apply %.3f s, undo %.3f s",
+                               cores[i],
+                               gimp_paint_core_stats_get_n_dabs (stats),
+                               dabs_per_second,
+                               gimp_paint_core_stats_get_dab_time (stats, 50) * 1000,
+                               gimp_paint_core_stats_get_dab_time (stats, 90) * 1000,
+                               gimp_paint_core_stats_get_dab_time (stats, 99) * 1000,
+                               stats->mask_time       / 1000000.0,
+                               stats->applicator_time / 1000000.0,
+                               stats->undo_time       / 1000000.0);
+
+      gimp_paint_core_stats_free (stats);
+      g_object_unref (core);
+      g_object_unref (options);
+      g_object_unref (image);
+    }
+
+  g_ptr_array_unref (recording);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (heal_multigrid_matches_gauss_seidel);
+  ADD_TEST (recording_round_trip);
+
+  if (g_test_perf ())
+    {
+      ADD_TEST (heal_dab_speed);
+      ADD_TEST (replay_speed);
+    }
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,825 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A headless benchmark suite, built and run by "make check-performance".
+ *
+ *  Every benchmark takes the best of PERF_N_RUNS runs and records the
+ *  result as a "name<TAB>seconds" line in the file given by --results.
+ *  If a baseline file in the same format is given by --baseline, any
+ *  benchmark that got slower than the baseline by more than --threshold
+ *  percent fails.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpchannel.h"
+#include "core/gimpchannel-select.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable-blend.h"
+#include "core/gimpdrawable-histogram.h"
+#include "core/gimphistogram.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-convert.h"
+#include "core/gimpimage-scale.h"
+#include "core/gimplayer.h"
+#include "core/gimppaintinfo.h"
+#include "core/gimppickable.h"
+#include "core/gimpprojection.h"
+
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintcore-stroke.h"
+#include "paint/gimppaintoptions.h"
+
+#include "file/file-open.h"
+#include "file/file-procedure.h"
+#include "file/file-save.h"
+
+#include "plug-in/gimppluginmanager.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-performance/" #function, gimp, function);
+
+#define PERF_N_RUNS       3
+#define PERF_IMAGE_SIZE   2048
+#define PERF_IMAGE_LAYERS 8
+#define PERF_STROKE_SIZE  1000
+
+
+typedef void (* BenchmarkFunc) (GimpImage *image,
+                                gpointer   data);
+
+
+static const GimpPrecision precisions[] =
+{
+  GIMP_PRECISION_U8,
+  GIMP_PRECISION_U16,
+  GIMP_PRECISION_U32,
+  GIMP_PRECISION_HALF,
+  GIMP_PRECISION_FLOAT
+};
+
+static const gchar *precision_names[] =
+{
+  "u8",
+  "u16",
+  "u32",
+  "half",
+  "float"
+};
+
+
+static gchar      *results_filename  = NULL;
+static gchar      *baseline_filename = NULL;
+static gdouble     threshold         = 10.0;
+
+static FILE       *results_file      = NULL;
+static GHashTable *baseline          = NULL;
+
+
+static const GOptionEntry perf_options[] =
+{
+  {
+    "results", 0, 0,
+    G_OPTION_ARG_FILENAME, &results_filename,
+    "Write the results to FILE", "FILE"
+  },
+  {
+    "baseline", 0, 0,
+    G_OPTION_ARG_FILENAME, &baseline_filename,
+    "Compare the results against the baseline in FILE", "FILE"
+  },
+  {
+    "threshold", 0, 0,
+    G_OPTION_ARG_DOUBLE, &threshold,
+    "Fail benchmarks that got slower by more than PERCENT (default 10)",
+    "PERCENT"
+  },
+  { NULL }
+};
+
+
+/*  reads a file of "name<TAB>seconds" lines, skipping empty lines and
+ *  lines starting with '#'
+ */
+static GHashTable *
+load_baseline (const gchar  *filename,
+               GError      **error)
+{
+  GHashTable  *table;
+  gchar       *contents;
+  gchar      **lines;
+  gint         i;
+
+  if (! g_file_get_contents (filename, &contents, NULL, error))
+    return NULL;
+
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  lines = g_strsplit (contents, "\n", -1);
+
+  for (i = 0; lines[i]; i++)
+    {
+      gchar   *tab = strchr (lines[i], '\t');
+      gdouble *seconds;
+
+      if (! tab || lines[i][0] == '#')
+        continue;
+
+      *tab = '\0';
+
+      seconds  = g_new (gdouble, 1);
+      *seconds = g_ascii_strtod (tab + 1, NULL);
+
+      g_hash_table_insert (table, g_strdup (lines[i]), seconds);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return table;
+}
+
+/*  records one result, and fails the current test if it regressed
+ *  against the baseline
+ */
+static void
+record_result (const gchar *name,
+               gdouble      seconds)
+{
+  g_test_minimized_result (seconds, "%s: %.3f s", name, seconds);
+
+  if (results_file)
+    {
+      gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+      fprintf (results_file, "%s\t%s\n",
+               name, g_ascii_formatd (buf, sizeof (buf), "%.6f", seconds));
+      fflush (results_file);
+    }
+
+  if (baseline)
+    {
+      const gdouble *base = g_hash_table_lookup (baseline, name);
+
+      if (base && seconds > *base * (1.0 + threshold / 100.0))
+        {
+          g_test_message ("%s regressed: %.3f s, baseline %.3f s (+%.0f%%)",
+                          name, seconds, *base,
+                          (seconds / *base - 1.0) * 100.0);
+          g_test_fail ();
+        }
+    }
+}
+
+/*  runs @func PERF_N_RUNS times, each time on a new synthetic image of
+ *  the given @precision and @n_layers, and records the best time
+ */
+static void
+run_benchmark (Gimp          *gimp,
+               const gchar   *name,
+               gint           size,
+               GimpPrecision  precision,
+               gint           n_layers,
+               BenchmarkFunc  func,
+               gpointer       data)
+{
+  gdouble best = G_MAXDOUBLE;
+  gint    run;
+
+  for (run = 0; run < PERF_N_RUNS; run++)
+    {
+      GimpImage *image;
+      gdouble    elapsed;
+
+      image = gimp_test_utils_create_synthetic_image (gimp, size, size,
+                                                      precision, n_layers);
+
+      g_test_timer_start ();
+
+      func (image, data);
+
+      elapsed = g_test_timer_elapsed ();
+
+      best = MIN (best, elapsed);
+
+      g_object_unref (image);
+    }
+
+  record_result (name, best);
+}
+
+static void
+construct_projection (GimpImage *image,
+                      gpointer   data)
+{
+  GimpPickable *pickable = GIMP_PICKABLE (gimp_image_get_projection (image));
+  GeglBuffer   *buffer;
+  gint          width    = gimp_image_get_width  (image);
+  gint          height   = gimp_image_get_height (image);
+  gint          y;
+
+  gimp_pickable_flush (pickable);
+
+  buffer = gimp_pickable_get_buffer (pickable);
+
+  /*  reading the buffer validates the projection, one row of tiles at
+   *  a time so we don't need to hold the whole image in memory
+   */
+  for (y = 0; y < height; y += 64)
+    {
+      gint    rows   = MIN (64, height - y);
+      guchar *pixels = g_malloc (width * rows * 4);
+
+      gegl_buffer_get (buffer, GEGL_RECTANGLE (0, y, width, rows), 1.0,
+                       babl_format ("R'G'B'A u8"), pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      g_free (pixels);
+    }
+}
+
+static void
+set_layer_modes (GimpImage *image,
+                 gpointer   data)
+{
+  GList *list;
+
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gimp_layer_set_mode (list->data, GPOINTER_TO_INT (data), FALSE);
+    }
+}
+
+static void
+composite_layers (GimpImage *image,
+                  gpointer   data)
+{
+  set_layer_modes (image, data);
+  construct_projection (image, NULL);
+}
+
+static gchar *
+get_temp_uri (void)
+{
+  gchar *filename = g_build_filename (g_get_tmp_dir (),
+                                      "gimp-performance.xcf", NULL);
+  gchar *uri      = g_filename_to_uri (filename, NULL, NULL);
+
+  g_free (filename);
+
+  return uri;
+}
+
+static void
+save_xcf (GimpImage *image,
+          gpointer   data)
+{
+  gchar               *uri  = get_temp_uri ();
+  GimpPlugInProcedure *proc;
+
+  proc = file_procedure_find (image->gimp->plug_in_manager->save_procs,
+                              uri, NULL);
+
+  g_assert (file_save (image->gimp, image, NULL, uri, proc,
+                       GIMP_RUN_NONINTERACTIVE,
+                       FALSE, FALSE, FALSE, NULL) == GIMP_PDB_SUCCESS);
+
+  g_free (uri);
+}
+
+/*  loads the file written by save_xcf() PERF_N_RUNS times and records
+ *  the best time
+ */
+static void
+load_xcf (Gimp        *gimp,
+          const gchar *name)
+{
+  gchar               *uri  = get_temp_uri ();
+  GimpPlugInProcedure *proc;
+  gdouble              best = G_MAXDOUBLE;
+  gint                 run;
+
+  proc = file_procedure_find (gimp->plug_in_manager->load_procs, uri, NULL);
+
+  for (run = 0; run < PERF_N_RUNS; run++)
+    {
+      GimpImage         *image;
+      GimpPDBStatusType  status;
+
+      g_test_timer_start ();
+
+      image = file_open_image (gimp, gimp_get_user_context (gimp),
+                               NULL, uri, uri, FALSE, proc,
+                               GIMP_RUN_NONINTERACTIVE,
+                               &status, NULL, NULL);
+
+      best = MIN (best, g_test_timer_elapsed ());
+
+      g_assert (image != NULL);
+
+      g_object_unref (image);
+    }
+
+  record_result (name, best);
+
+  g_free (uri);
+}
+
+static void
+rotate_layers (GimpImage *image,
+               gpointer   data)
+{
+  GimpContext *context = gimp_get_user_context (image->gimp);
+  GimpMatrix3  matrix;
+  GList       *list;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_translate (&matrix,
+                          -gimp_image_get_width  (image) / 2.0,
+                          -gimp_image_get_height (image) / 2.0);
+  gimp_matrix3_rotate (&matrix, G_PI / 6.0);
+  gimp_matrix3_translate (&matrix,
+                          gimp_image_get_width  (image) / 2.0,
+                          gimp_image_get_height (image) / 2.0);
+
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gimp_item_transform (list->data, context, &matrix,
+                           GIMP_TRANSFORM_FORWARD,
+                           GPOINTER_TO_INT (data), 3,
+                           GIMP_TRANSFORM_RESIZE_ADJUST, NULL);
+    }
+}
+
+static void
+fuzzy_select (GimpImage *image,
+              gpointer   data)
+{
+  gimp_channel_select_fuzzy (gimp_image_get_mask (image),
+                             gimp_image_get_active_drawable (image),
+                             FALSE,
+                             gimp_image_get_width  (image) / 2,
+                             gimp_image_get_height (image) / 2,
+                             0.5, FALSE,
+                             GIMP_SELECT_CRITERION_COMPOSITE,
+                             GIMP_CHANNEL_OP_REPLACE,
+                             TRUE, FALSE, 0.0, 0.0);
+}
+
+static void
+calculate_histogram (GimpImage *image,
+                     gpointer   data)
+{
+  GimpHistogram *histogram = gimp_histogram_new ();
+
+  gimp_drawable_calculate_histogram (gimp_image_get_active_drawable (image),
+                                     histogram);
+
+  gimp_histogram_unref (histogram);
+}
+
+static void
+blend (GimpImage *image,
+       gpointer   data)
+{
+  gimp_drawable_blend (gimp_image_get_active_drawable (image),
+                       gimp_get_user_context (image->gimp),
+                       GIMP_FG_BG_RGB_MODE, GIMP_NORMAL_MODE,
+                       GPOINTER_TO_INT (data),
+                       100.0, 0.0, GIMP_REPEAT_NONE, FALSE,
+                       FALSE, 3, 0.2, TRUE,
+                       0.0, 0.0,
+                       gimp_image_get_width  (image),
+                       gimp_image_get_height (image),
+                       NULL);
+}
+
+static void
+scale_image (GimpImage *image,
+             gpointer   data)
+{
+  gimp_image_scale (image,
+                    gimp_image_get_width  (image) * 3 / 4,
+                    gimp_image_get_height (image) * 3 / 4,
+                    GPOINTER_TO_INT (data), NULL);
+}
+
+static void
+convert_indexed (GimpImage *image,
+                 gpointer   data)
+{
+  g_assert (gimp_image_convert (image, GIMP_INDEXED,
+                                256, GPOINTER_TO_INT (data), FALSE, FALSE,
+                                GIMP_MAKE_PALETTE, NULL, NULL, NULL));
+}
+
+static void
+paint_stroke (GimpImage *image,
+              gpointer   data)
+{
+  GimpPaintOptions *options  = data;
+  GimpDrawable     *drawable = gimp_image_get_active_drawable (image);
+  GimpPaintCore    *core;
+  GimpCoords       *coords;
+
+  coords = g_new (GimpCoords, PERF_STROKE_SIZE);
+
+  gimp_test_utils_create_stroke (coords, PERF_STROKE_SIZE,
+                                 gimp_image_get_width  (image),
+                                 gimp_image_get_height (image));
+
+  core = g_object_new (options->paint_info->paint_type, NULL);
+
+  g_assert (gimp_paint_core_stroke (core, drawable, options,
+                                    coords, PERF_STROKE_SIZE, FALSE, NULL));
+
+  g_object_unref (core);
+  g_free (coords);
+}
+
+/**
+ * projection_speed:
+ * @data:
+ *
+ * Time the construction of the projection of a many-layer image in
+ * every precision.
+ **/
+static void
+projection_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+  gint  i;
+
+  for (i = 0; i < G_N_ELEMENTS (precisions); i++)
+    {
+      gchar *name = g_strdup_printf ("projection/%s", precision_names[i]);
+
+      run_benchmark (gimp, name, PERF_IMAGE_SIZE, precisions[i],
+                     PERF_IMAGE_LAYERS, construct_projection, NULL);
+
+      g_free (name);
+    }
+}
+
+/**
+ * layer_mode_speed:
+ * @data:
+ *
+ * Time the compositing of a many-layer image with a selection of
+ * layer modes, in 8-bit and floating point precision.
+ **/
+static void
+layer_mode_speed (gconstpointer data)
+{
+  Gimp                       *gimp         = GIMP (data);
+  const GimpLayerModeEffects  modes[]      = { GIMP_NORMAL_MODE,
+                                               GIMP_MULTIPLY_MODE,
+                                               GIMP_OVERLAY_MODE,
+                                               GIMP_DIFFERENCE_MODE,
+                                               GIMP_HUE_MODE,
+                                               GIMP_SOFTLIGHT_MODE };
+  const gchar                *mode_names[] = { "normal",
+                                               "multiply",
+                                               "overlay",
+                                               "difference",
+                                               "hue",
+                                               "soft-light" };
+  const GimpPrecision         precs[]      = { GIMP_PRECISION_U8,
+                                               GIMP_PRECISION_FLOAT };
+  const gchar                *prec_names[] = { "u8",
+                                               "float" };
+  gint                        i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (precs); i++)
+    for (j = 0; j < G_N_ELEMENTS (modes); j++)
+      {
+        gchar *name = g_strdup_printf ("layer-mode/%s/%s",
+                                       mode_names[j], prec_names[i]);
+
+        run_benchmark (gimp, name, PERF_IMAGE_SIZE / 2, precs[i],
+                       PERF_IMAGE_LAYERS, composite_layers,
+                       GINT_TO_POINTER (modes[j]));
+
+        g_free (name);
+      }
+}
+
+/**
+ * xcf_speed:
+ * @data:
+ *
+ * Time saving a many-layer image to XCF and loading it again, in every
+ * precision.
+ **/
+static void
+xcf_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+  gint  i;
+
+  for (i = 0; i < G_N_ELEMENTS (precisions); i++)
+    {
+      gchar *name;
+
+      name = g_strdup_printf ("xcf-save/%s", precision_names[i]);
+      run_benchmark (gimp, name, PERF_IMAGE_SIZE / 2, precisions[i],
+                     PERF_IMAGE_LAYERS, save_xcf, NULL);
+      g_free (name);
+
+      /*  the last save left a file of the same image to load  */
+      name = g_strdup_printf ("xcf-load/%s", precision_names[i]);
+      load_xcf (gimp, name);
+      g_free (name);
+    }
+
+  {
+    gchar *uri      = get_temp_uri ();
+    gchar *filename = g_filename_from_uri (uri, NULL, NULL);
+
+    g_unlink (filename);
+
+    g_free (filename);
+    g_free (uri);
+  }
+}
+
+/**
+ * transform_speed:
+ * @data:
+ *
+ * Time rotating all layers of an image with each interpolation.
+ **/
+static void
+transform_speed (gconstpointer data)
+{
+  Gimp                        *gimp             = GIMP (data);
+  const GimpInterpolationType  interpolations[] = { GIMP_INTERPOLATION_NONE,
+                                                    GIMP_INTERPOLATION_LINEAR,
+                                                    GIMP_INTERPOLATION_CUBIC,
+                                                    GIMP_INTERPOLATION_LOHALO };
+  const gchar                 *names[]          = { "none",
+                                                    "linear",
+                                                    "cubic",
+                                                    "lohalo" };
+  gint                         i;
+
+  for (i = 0; i < G_N_ELEMENTS (interpolations); i++)
+    {
+      gchar *name = g_strdup_printf ("rotate/%s", names[i]);
+
+      run_benchmark (gimp, name, PERF_IMAGE_SIZE / 2, GIMP_PRECISION_U8,
+                     PERF_IMAGE_LAYERS / 2, rotate_layers,
+                     GINT_TO_POINTER (interpolations[i]));
+
+      g_free (name);
+    }
+}
+
+/**
+ * scale_speed:
+ * @data:
+ *
+ * Time scaling an image with each interpolation.
+ **/
+static void
+scale_speed (gconstpointer data)
+{
+  Gimp                        *gimp             = GIMP (data);
+  const GimpInterpolationType  interpolations[] = { GIMP_INTERPOLATION_NONE,
+                                                    GIMP_INTERPOLATION_LINEAR,
+                                                    GIMP_INTERPOLATION_CUBIC,
+                                                    GIMP_INTERPOLATION_LOHALO };
+  const gchar                 *names[]          = { "none",
+                                                    "linear",
+                                                    "cubic",
+                                                    "lohalo" };
+  gint                         i;
+
+  for (i = 0; i < G_N_ELEMENTS (interpolations); i++)
+    {
+      gchar *name = g_strdup_printf ("scale/%s", names[i]);
+
+      run_benchmark (gimp, name, PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                     PERF_IMAGE_LAYERS / 2, scale_image,
+                     GINT_TO_POINTER (interpolations[i]));
+
+      g_free (name);
+    }
+}
+
+/**
+ * fuzzy_select_speed:
+ * @data:
+ *
+ * Time a fuzzy select from the center of a large image.
+ **/
+static void
+fuzzy_select_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  run_benchmark (gimp, "fuzzy-select", PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                 1, fuzzy_select, NULL);
+}
+
+/**
+ * histogram_speed:
+ * @data:
+ *
+ * Time calculating the histogram of a large layer in 8-bit and
+ * floating point precision.
+ **/
+static void
+histogram_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  run_benchmark (gimp, "histogram/u8", PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                 1, calculate_histogram, NULL);
+  run_benchmark (gimp, "histogram/float", PERF_IMAGE_SIZE,
+                 GIMP_PRECISION_FLOAT,
+                 1, calculate_histogram, NULL);
+}
+
+/**
+ * blend_speed:
+ * @data:
+ *
+ * Time rendering linear and radial gradients over a large layer.
+ **/
+static void
+blend_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  run_benchmark (gimp, "blend/linear", PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                 1, blend, GINT_TO_POINTER (GIMP_GRADIENT_LINEAR));
+  run_benchmark (gimp, "blend/radial", PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                 1, blend, GINT_TO_POINTER (GIMP_GRADIENT_RADIAL));
+}
+
+/**
+ * convert_indexed_speed:
+ * @data:
+ *
+ * Time converting a many-layer image to indexed, without and with
+ * dithering.
+ **/
+static void
+convert_indexed_speed (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  run_benchmark (gimp, "convert-indexed/none", PERF_IMAGE_SIZE / 2,
+                 GIMP_PRECISION_U8, PERF_IMAGE_LAYERS / 2,
+                 convert_indexed, GINT_TO_POINTER (GIMP_NO_DITHER));
+  run_benchmark (gimp, "convert-indexed/floyd-steinberg", PERF_IMAGE_SIZE / 2,
+                 GIMP_PRECISION_U8, PERF_IMAGE_LAYERS / 2,
+                 convert_indexed, GINT_TO_POINTER (GIMP_FS_DITHER));
+}
+
+/**
+ * paint_stroke_speed:
+ * @data:
+ *
+ * Time painting a long stroke with the paintbrush and the airbrush.
+ **/
+static void
+paint_stroke_speed (gconstpointer data)
+{
+  Gimp        *gimp    = GIMP (data);
+  const gchar *cores[] = { "gimp-paintbrush",
+                           "gimp-airbrush" };
+  gint         i;
+
+  for (i = 0; i < G_N_ELEMENTS (cores); i++)
+    {
+      GimpPaintOptions *options;
+      gchar            *name;
+
+      options = gimp_test_utils_create_paint_options (gimp, cores[i], 50.0);
+      name    = g_strdup_printf ("paint-stroke/%s",
+                                 cores[i] + strlen ("gimp-"));
+
+      run_benchmark (gimp, name, PERF_IMAGE_SIZE, GIMP_PRECISION_U8,
+                     1, paint_stroke, options);
+
+      g_free (name);
+      g_object_unref (options);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp           *gimp;
+  GOptionContext *context;
+  GError         *error = NULL;
+  int             result;
+
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, perf_options, NULL);
+  g_option_context_set_ignore_unknown_options (context, TRUE);
+  g_option_context_set_help_enabled (context, FALSE);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    g_error ("%s", error->message);
+
+  g_option_context_free (context);
+
+  g_test_init (&argc, &argv, NULL);
+
+  if (baseline_filename)
+    {
+      baseline = load_baseline (baseline_filename, &error);
+
+      /*  without the baseline, no regression could ever be detected,
+       *  so don't let the benchmarks pass silently
+       */
+      if (! baseline)
+        g_error ("Could not load the baseline: %s", error->message);
+    }
+
+  if (results_filename)
+    {
+      results_file = g_fopen (results_filename, "w");
+
+      if (! results_file)
+        g_error ("Could not open '%s' for writing: %s",
+                 results_filename, g_strerror (errno));
+    }
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (projection_speed);
+  ADD_TEST (layer_mode_speed);
+  ADD_TEST (xcf_speed);
+  ADD_TEST (transform_speed);
+  ADD_TEST (scale_speed);
+  ADD_TEST (fuzzy_select_speed);
+  ADD_TEST (histogram_speed);
+  ADD_TEST (blend_speed);
+  ADD_TEST (convert_indexed_speed);
+  ADD_TEST (paint_stroke_speed);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  if (results_file)
+    fclose (results_file);
+
+  if (baseline)
+    g_hash_table_unref (baseline);
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,170 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "gimp-trace.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimp-trace/" #function, function);
+
+
+static gchar *
+get_trace_filename (void)
+{
+  gchar *basename = g_strdup_printf ("test-trace-%d.json", (gint) getpid ());
+  gchar *filename = g_build_filename (g_get_tmp_dir (), basename, NULL);
+
+  g_free (basename);
+
+  return filename;
+}
+
+static gint
+count_substrings (const gchar *haystack,
+                  const gchar *needle)
+{
+  gint count = 0;
+
+  while ((haystack = strstr (haystack, needle)))
+    {
+      haystack += strlen (needle);
+      count++;
+    }
+
+  return count;
+}
+
+/**
+ * disabled_records_nothing:
+ *
+ * Test that events are dropped while no trace is recorded.
+ **/
+static void
+disabled_records_nothing (void)
+{
+  gchar *filename = get_trace_filename ();
+  gchar *contents;
+
+  GIMP_TRACE_BEGIN ("test", "before");
+  GIMP_TRACE_END ("test", "before");
+
+  g_assert (gimp_trace_start (filename));
+  g_assert (gimp_trace_stop (NULL));
+
+  GIMP_TRACE_BEGIN ("test", "after");
+  GIMP_TRACE_END ("test", "after");
+
+  g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+
+  g_assert (g_str_has_prefix (contents, "{\"traceEvents\":["));
+  g_assert (strstr (contents, "before") == NULL);
+  g_assert (strstr (contents, "after") == NULL);
+
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static gpointer
+emit_events (gpointer data)
+{
+  gint i;
+
+  for (i = 0; i < 100; i++)
+    {
+      GIMP_TRACE_BEGIN ("test", "span");
+      GIMP_TRACE_COUNTER ("test", "counter", i);
+      GIMP_TRACE_END ("test", "span");
+    }
+
+  return NULL;
+}
+
+/**
+ * events_are_written:
+ *
+ * Test that begin, end and counter events from several threads are
+ * all written, each with the id of its thread.
+ **/
+static void
+events_are_written (void)
+{
+  gchar   *filename = get_trace_filename ();
+  gchar   *contents;
+  GThread *threads[4];
+  gint     i;
+
+  g_assert (gimp_trace_start (filename));
+
+  /*  a second start while recording fails  */
+  g_assert (! gimp_trace_start (filename));
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("test-trace", emit_events, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  g_assert (gimp_trace_stop (NULL));
+
+  g_assert_cmpstr (gimp_trace_get_filename (), ==, filename);
+  g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+
+  g_assert_cmpint (count_substrings (contents, "\"ph\":\"B\""), ==, 400);
+  g_assert_cmpint (count_substrings (contents, "\"ph\":\"E\""), ==, 400);
+  g_assert_cmpint (count_substrings (contents, "\"ph\":\"C\""), ==, 400);
+  g_assert_cmpint (count_substrings (contents, "\"args\":{\"value\":99}"), ==, 4);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+      gchar *tid = g_strdup_printf ("\"tid\":%d}", i + 1);
+
+      g_assert_cmpint (count_substrings (contents, tid), ==, 200);
+
+      g_free (tid);
+    }
+
+  g_assert (g_str_has_suffix (contents, "}\n],\"displayTimeUnit\":\"ms\"}\n"));
+
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (disabled_records_nothing);
+  ADD_TEST (events_are_written);
+
+  return g_test_run ();
+}
@@ -0,0 +1,508 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdashboard.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_TIMES_H
+#include <sys/times.h>
+#endif
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+#include "libgimpwidgets/gimpwidgets.h"
+
+#include "widgets-types.h"
+
+#include "base/tile-cache.h"
+#include "base/tile-swap.h"
+
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
+#include "core/gimpprojection.h"
+
+#include "plug-in/gimppluginmanager.h"
+
+#include "gimpdashboard.h"
+
+#include "gimp-intl.h"
+
+
+#define GIMP_DASHBOARD_UPDATE_INTERVAL 1000  /*  milliseconds  */
+
+
+static void        gimp_dashboard_dispose   (GObject       *object);
+
+static void        gimp_dashboard_map       (GtkWidget     *widget);
+static void        gimp_dashboard_unmap     (GtkWidget     *widget);
+
+static GtkWidget * gimp_dashboard_add_frame (GimpDashboard *dashboard,
+                                             const gchar   *title,
+                                             gint           n_rows);
+static GtkWidget * gimp_dashboard_add_value (GtkWidget     *table,
+                                             gint           row,
+                                             const gchar   *name);
+
+static gboolean    gimp_dashboard_update    (GimpDashboard *dashboard);
+static void        gimp_dashboard_set_last_image
+                                            (GimpDashboard *dashboard,
+                                             GimpImage     *image);
+static gint64      gimp_dashboard_cpu_time  (void);
+
+static void        gimp_dashboard_set_size  (GtkWidget     *label,
+                                             guint64        size);
+static void        gimp_dashboard_set_usage (GtkWidget     *label,
+                                             guint64        used,
+                                             guint64        total);
+static void        gimp_dashboard_set_rate  (GtkWidget     *label,
+                                             guint64        bytes,
+                                             gdouble        seconds);
+
+
+G_DEFINE_TYPE (GimpDashboard, gimp_dashboard, GIMP_TYPE_EDITOR)
+
+#define parent_class gimp_dashboard_parent_class
+
+
+static void
+gimp_dashboard_class_init (GimpDashboardClass *klass)
+{
+  GObjectClass   *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = gimp_dashboard_dispose;
+
+  widget_class->map     = gimp_dashboard_map;
+  widget_class->unmap   = gimp_dashboard_unmap;
+}
+
+static void
+gimp_dashboard_init (GimpDashboard *dashboard)
+{
+  GtkWidget *table;
+
+  /* Tile cache */
+
+  table = gimp_dashboard_add_frame (dashboard, _("Tile Cache"), 2);
+
+  dashboard->cache_size_label =
+    gimp_dashboard_add_value (table, 0, _("Size"));
+  dashboard->cache_hit_rate_label =
+    gimp_dashboard_add_value (table, 1, _("Hit rate"));
+
+  /* Swap */
+
+  table = gimp_dashboard_add_frame (dashboard, _("Swap"), 3);
+
+  dashboard->swap_size_label =
+    gimp_dashboard_add_value (table, 0, _("Size"));
+  dashboard->swap_read_label =
+    gimp_dashboard_add_value (table, 1, _("Read"));
+  dashboard->swap_written_label =
+    gimp_dashboard_add_value (table, 2, _("Written"));
+
+  /* Image */
+
+  table = gimp_dashboard_add_frame (dashboard, _("Image"), 3);
+
+  dashboard->undo_size_label =
+    gimp_dashboard_add_value (table, 0, _("Undo memory"));
+  dashboard->pending_area_label =
+    gimp_dashboard_add_value (table, 1, _("Pending render"));
+  dashboard->render_speed_label =
+    gimp_dashboard_add_value (table, 2, _("Render speed"));
+
+  /* CPU */
+
+  table = gimp_dashboard_add_frame (dashboard, _("CPU"), 1);
+
+  dashboard->cpu_usage_label =
+    gimp_dashboard_add_value (table, 0, _("Usage"));
+
+  /* Plug-ins */
+
+  table = gimp_dashboard_add_frame (dashboard, _("Plug-In Tiles"), 2);
+
+  dashboard->tiles_read_label =
+    gimp_dashboard_add_value (table, 0, _("Read"));
+  dashboard->tiles_written_label =
+    gimp_dashboard_add_value (table, 1, _("Written"));
+}
+
+static void
+gimp_dashboard_dispose (GObject *object)
+{
+  GimpDashboard *dashboard = GIMP_DASHBOARD (object);
+
+  gimp_dashboard_set_last_image (dashboard, NULL);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gimp_dashboard_map (GtkWidget *widget)
+{
+  GimpDashboard *dashboard = GIMP_DASHBOARD (widget);
+
+  GTK_WIDGET_CLASS (parent_class)->map (widget);
+
+  if (! dashboard->timeout_id)
+    {
+      /*  the first sample only shows sizes, rates need two  */
+      dashboard->last_time = 0;
+
+      gimp_dashboard_update (dashboard);
+
+      dashboard->timeout_id =
+        g_timeout_add_full (G_PRIORITY_LOW,
+                            GIMP_DASHBOARD_UPDATE_INTERVAL,
+                            (GSourceFunc) gimp_dashboard_update,
+                            dashboard, NULL);
+    }
+}
+
+static void
+gimp_dashboard_unmap (GtkWidget *widget)
+{
+  GimpDashboard *dashboard = GIMP_DASHBOARD (widget);
+
+  if (dashboard->timeout_id)
+    {
+      g_source_remove (dashboard->timeout_id);
+      dashboard->timeout_id = 0;
+    }
+
+  GTK_WIDGET_CLASS (parent_class)->unmap (widget);
+}
+
+
+/*  public functions  */
+
+GtkWidget *
+gimp_dashboard_new (Gimp *gimp)
+{
+  GimpDashboard *dashboard;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+
+  dashboard = g_object_new (GIMP_TYPE_DASHBOARD, NULL);
+
+  dashboard->gimp = gimp;
+
+  return GTK_WIDGET (dashboard);
+}
+
+
+/*  private functions  */
+
+static GtkWidget *
+gimp_dashboard_add_frame (GimpDashboard *dashboard,
+                          const gchar   *title,
+                          gint           n_rows)
+{
+  GtkWidget *frame;
+  GtkWidget *table;
+
+  frame = gimp_frame_new (title);
+  gtk_box_pack_start (GTK_BOX (dashboard), frame, FALSE, FALSE, 0);
+  gtk_widget_show (frame);
+
+  table = gtk_table_new (n_rows, 2, FALSE);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 2);
+  gtk_container_add (GTK_CONTAINER (frame), table);
+  gtk_widget_show (table);
+
+  return table;
+}
+
+static GtkWidget *
+gimp_dashboard_add_value (GtkWidget   *table,
+                          gint         row,
+                          const gchar *name)
+{
+  GtkWidget *label = gtk_label_new (_("n/a"));
+
+  gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+  gimp_table_attach_aligned (GTK_TABLE (table), 0, row,
+                             name, 0.0, 0.5,
+                             label, 1, FALSE);
+
+  return label;
+}
+
+static gboolean
+gimp_dashboard_update (GimpDashboard *dashboard)
+{
+  Gimp              *gimp    = dashboard->gimp;
+  GimpPlugInManager *manager = gimp->plug_in_manager;
+  GimpImage         *image;
+  gint64             time;
+  gint64             cpu_time;
+  gdouble            seconds = 0.0;
+  gboolean           rates;
+  guint64            cache_size;
+  guint64            cache_max;
+  guint64            cache_hits;
+  guint64            cache_misses;
+  gint64             swap_size;
+  gint64             swap_used;
+  guint64            swap_read;
+  guint64            swap_written;
+  guint64            constructed = 0;
+  gchar             *str;
+
+  time     = g_get_monotonic_time ();
+  cpu_time = gimp_dashboard_cpu_time ();
+
+  rates = (dashboard->last_time != 0 && time > dashboard->last_time);
+
+  if (rates)
+    seconds = (gdouble) (time - dashboard->last_time) / G_USEC_PER_SEC;
+
+  /*  tile cache  */
+
+  tile_cache_get_stats (&cache_size, &cache_max, NULL,
+                        &cache_hits, &cache_misses);
+
+  gimp_dashboard_set_usage (dashboard->cache_size_label,
+                            cache_size, cache_max);
+
+  if (rates)
+    {
+      guint64 hits   = cache_hits   - dashboard->last_cache_hits;
+      guint64 misses = cache_misses - dashboard->last_cache_misses;
+
+      if (hits + misses > 0)
+        {
+          str = g_strdup_printf ("%.1f%%", 100.0 * hits / (hits + misses));
+          gtk_label_set_text (GTK_LABEL (dashboard->cache_hit_rate_label),
+                              str);
+          g_free (str);
+        }
+      else
+        {
+          gtk_label_set_text (GTK_LABEL (dashboard->cache_hit_rate_label),
+                              _("n/a"));
+        }
+    }
+
+  /*  swap  */
+
+  tile_swap_get_stats (&swap_size, &swap_used, &swap_read, &swap_written);
+
+  gimp_dashboard_set_usage (dashboard->swap_size_label,
+                            swap_used, swap_size);
+
+  if (rates)
+    {
+      gimp_dashboard_set_rate (dashboard->swap_read_label,
+                               swap_read - dashboard->last_swap_read,
+                               seconds);
+      gimp_dashboard_set_rate (dashboard->swap_written_label,
+                               swap_written - dashboard->last_swap_written,
+                               seconds);
+    }
+
+  /*  the active image  */
+
+  image = gimp_context_get_image (gimp_get_user_context (gimp));
+
+  if (image)
+    {
+      GimpProjection *projection = gimp_image_get_projection (image);
+      gint64          undo_size;
+
+      undo_size =
+        gimp_object_get_memsize (GIMP_OBJECT (gimp_image_get_undo_stack (image)),
+                                 NULL) +
+        gimp_object_get_memsize (GIMP_OBJECT (gimp_image_get_redo_stack (image)),
+                                 NULL);
+
+      gimp_dashboard_set_size (dashboard->undo_size_label, undo_size);
+
+      str = g_strdup_printf (_("%.2f MPixels"),
+                             gimp_projection_get_pending_area (projection) /
+                             1000000.0);
+      gtk_label_set_text (GTK_LABEL (dashboard->pending_area_label), str);
+      g_free (str);
+
+      constructed = projection->constructed_pixels;
+
+      if (rates && image == dashboard->last_image)
+        {
+          str = g_strdup_printf (_("%.1f MPixels/s"),
+                                 (constructed -
+                                  dashboard->last_constructed_pixels) /
+                                 (1000000.0 * seconds));
+          gtk_label_set_text (GTK_LABEL (dashboard->render_speed_label), str);
+          g_free (str);
+        }
+      else
+        {
+          gtk_label_set_text (GTK_LABEL (dashboard->render_speed_label),
+                              _("n/a"));
+        }
+    }
+  else
+    {
+      gtk_label_set_text (GTK_LABEL (dashboard->undo_size_label),    _("n/a"));
+      gtk_label_set_text (GTK_LABEL (dashboard->pending_area_label), _("n/a"));
+      gtk_label_set_text (GTK_LABEL (dashboard->render_speed_label), _("n/a"));
+    }
+
+  /*  CPU usage, relative to the number of threads GEGL may use  */
+
+  if (rates && cpu_time >= 0 && dashboard->last_cpu_time >= 0)
+    {
+      gint    n_threads = GIMP_GEGL_CONFIG (gimp->config)->num_processors;
+      gdouble usage;
+
+      usage = (gdouble) (cpu_time - dashboard->last_cpu_time) /
+              ((time - dashboard->last_time) * MAX (n_threads, 1));
+
+      str = g_strdup_printf (ngettext ("%d%% of %d thread",
+                                       "%d%% of %d threads", n_threads),
+                             (gint) RINT (100.0 * usage), n_threads);
+      gtk_label_set_text (GTK_LABEL (dashboard->cpu_usage_label), str);
+      g_free (str);
+    }
+
+  /*  plug-in tile transfers  */
+
+  if (rates && manager)
+    {
+      str = g_strdup_printf (_("%.0f tiles/s"),
+                             (manager->n_tile_gets -
+                              dashboard->last_tile_gets) / seconds);
+      gtk_label_set_text (GTK_LABEL (dashboard->tiles_read_label), str);
+      g_free (str);
+
+      str = g_strdup_printf (_("%.0f tiles/s"),
+                             (manager->n_tile_puts -
+                              dashboard->last_tile_puts) / seconds);
+      gtk_label_set_text (GTK_LABEL (dashboard->tiles_written_label), str);
+      g_free (str);
+    }
+
+  dashboard->last_time               = time;
+  dashboard->last_cpu_time           = cpu_time;
+  dashboard->last_cache_hits         = cache_hits;
+  dashboard->last_cache_misses       = cache_misses;
+  dashboard->last_swap_read          = swap_read;
+  dashboard->last_swap_written       = swap_written;
+  dashboard->last_constructed_pixels = constructed;
+  dashboard->last_tile_gets          = manager ? manager->n_tile_gets : 0;
+  dashboard->last_tile_puts          = manager ? manager->n_tile_puts : 0;
+
+  gimp_dashboard_set_last_image (dashboard, image);
+
+  return TRUE;
+}
+
+/*  remembers the image the rates were sampled from, the pointer is
+ *  cleared when the image goes away, so that a new image at the same
+ *  address isn't mistaken for it
+ */
+static void
+gimp_dashboard_set_last_image (GimpDashboard *dashboard,
+                               GimpImage     *image)
+{
+  if (image == dashboard->last_image)
+    return;
+
+  if (dashboard->last_image)
+    g_object_remove_weak_pointer (G_OBJECT (dashboard->last_image),
+                                  (gpointer) &dashboard->last_image);
+
+  dashboard->last_image = image;
+
+  if (dashboard->last_image)
+    g_object_add_weak_pointer (G_OBJECT (dashboard->last_image),
+                               (gpointer) &dashboard->last_image);
+}
+
+/*  returns the processor time used by GIMP in microseconds, or -1 if
+ *  it can't be determined
+ */
+static gint64
+gimp_dashboard_cpu_time (void)
+{
+#if defined (HAVE_SYS_TIMES_H) && defined (HAVE_UNISTD_H)
+  struct tms tms;
+
+  if (times (&tms) == (clock_t) -1)
+    return -1;
+
+  return (gint64) (tms.tms_utime + tms.tms_stime) *
+         G_USEC_PER_SEC / sysconf (_SC_CLK_TCK);
+#else
+  return -1;
+#endif
+}
+
+static void
+gimp_dashboard_set_size (GtkWidget *label,
+                         guint64    size)
+{
+  gchar *str = gimp_memsize_to_string (size);
+
+  gtk_label_set_text (GTK_LABEL (label), str);
+  g_free (str);
+}
+
+static void
+gimp_dashboard_set_usage (GtkWidget *label,
+                          guint64    used,
+                          guint64    total)
+{
+  gchar *used_str  = gimp_memsize_to_string (used);
+  gchar *total_str = gimp_memsize_to_string (total);
+  gchar *str       = g_strdup_printf (_("%s of %s"), used_str, total_str);
+
+  gtk_label_set_text (GTK_LABEL (label), str);
+
+  g_free (str);
+  g_free (total_str);
+  g_free (used_str);
+}
+
+static void
+gimp_dashboard_set_rate (GtkWidget *label,
+                         guint64    bytes,
+                         gdouble    seconds)
+{
+  gchar *size = gimp_memsize_to_string (bytes / seconds);
+  gchar *str  = g_strdup_printf (_("%s/s"), size);
+
+  gtk_label_set_text (GTK_LABEL (label), str);
+
+  g_free (str);
+  g_free (size);
+}
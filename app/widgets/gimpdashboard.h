@@ -0,0 +1,81 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdashboard.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DASHBOARD_H__
+#define __GIMP_DASHBOARD_H__
+
+
+#include "gimpeditor.h"
+
+
+#define GIMP_TYPE_DASHBOARD            (gimp_dashboard_get_type ())
+#define GIMP_DASHBOARD(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_DASHBOARD, GimpDashboard))
+#define GIMP_DASHBOARD_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GIMP_TYPE_DASHBOARD, GimpDashboardClass))
+#define GIMP_IS_DASHBOARD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_DASHBOARD))
+#define GIMP_IS_DASHBOARD_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GIMP_TYPE_DASHBOARD))
+#define GIMP_DASHBOARD_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_DASHBOARD, GimpDashboardClass))
+
+
+typedef struct _GimpDashboardClass GimpDashboardClass;
+
+struct _GimpDashboard
+{
+  GimpEditor  parent_instance;
+
+  Gimp       *gimp;
+
+  GtkWidget  *cache_size_label;
+  GtkWidget  *cache_hit_rate_label;
+  GtkWidget  *swap_size_label;
+  GtkWidget  *swap_read_label;
+  GtkWidget  *swap_written_label;
+  GtkWidget  *undo_size_label;
+  GtkWidget  *pending_area_label;
+  GtkWidget  *render_speed_label;
+  GtkWidget  *cpu_usage_label;
+  GtkWidget  *tiles_read_label;
+  GtkWidget  *tiles_written_label;
+
+  guint       timeout_id;
+
+  /*  the previous sample, to compute rates from  */
+  gint64      last_time;
+  gint64      last_cpu_time;
+  guint64     last_cache_hits;
+  guint64     last_cache_misses;
+  guint64     last_swap_read;
+  guint64     last_swap_written;
+  GimpImage  *last_image;
+  guint64     last_constructed_pixels;
+  guint64     last_tile_gets;
+  guint64     last_tile_puts;
+};
+
+struct _GimpDashboardClass
+{
+  GimpEditorClass  parent_class;
+};
+
+
+GType       gimp_dashboard_get_type (void) G_GNUC_CONST;
+
+GtkWidget * gimp_dashboard_new      (Gimp *gimp);
+
+
+#endif  /*  __GIMP_DASHBOARD_H__  */
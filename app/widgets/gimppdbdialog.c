@@ -326,7 +326,9 @@ gimp_pdb_dialog_run_callback (GimpPdbDialog *dialog,
 
           return_vals = klass->run_callback (dialog, object, closing, &error);
 
-          if (g_value_get_enum (gimp_value_array_index (return_vals, 0)) !=
+          /*  run_callback() returns NULL if it could not run the callback  */
+          if (return_vals &&
+              g_value_get_enum (gimp_value_array_index (return_vals, 0)) !=
               GIMP_PDB_SUCCESS)
             {
               gimp_message (dialog->context->gimp, G_OBJECT (dialog),
@@ -344,7 +346,8 @@ gimp_pdb_dialog_run_callback (GimpPdbDialog *dialog,
               g_error_free (error);
             }
 
-          gimp_value_array_unref (return_vals);
+          if (return_vals)
+            gimp_value_array_unref (return_vals);
         }
 
       dialog->callback_busy = FALSE;
@@ -53,6 +53,7 @@ typedef struct _GimpToolbox                  GimpToolbox;
 /*  GimpEditor widgets  */
 
 typedef struct _GimpColorEditor              GimpColorEditor;
+typedef struct _GimpDashboard                GimpDashboard;
 typedef struct _GimpDeviceStatus             GimpDeviceStatus;
 typedef struct _GimpEditor                   GimpEditor;
 typedef struct _GimpErrorConsole             GimpErrorConsole;
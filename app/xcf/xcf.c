@@ -42,6 +42,8 @@
 #include "xcf-read.h"
 #include "xcf-save.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -246,6 +248,8 @@ xcf_load_invoker (GimpProcedure         *procedure,
 
   gimp_set_busy (gimp);
 
+  GIMP_TRACE_BEGIN ("xcf", "load");
+
   filename = g_value_get_string (gimp_value_array_index (args, 1));
 
   info.fp = g_fopen (filename, "rb");
@@ -337,6 +341,8 @@ xcf_load_invoker (GimpProcedure         *procedure,
   if (success)
     gimp_value_set_image (gimp_value_array_index (return_vals, 1), image);
 
+  GIMP_TRACE_END ("xcf", "load");
+
   gimp_unset_busy (gimp);
 
   return return_vals;
@@ -358,6 +364,8 @@ xcf_save_invoker (GimpProcedure         *procedure,
 
   gimp_set_busy (gimp);
 
+  GIMP_TRACE_BEGIN ("xcf", "save");
+
   image    = gimp_value_get_image (gimp_value_array_index (args, 1), gimp);
   filename = g_value_get_string (gimp_value_array_index (args, 3));
 
@@ -427,6 +435,8 @@ xcf_save_invoker (GimpProcedure         *procedure,
   return_vals = gimp_procedure_get_return_values (procedure, success,
                                                   error ? *error : NULL);
 
+  GIMP_TRACE_END ("xcf", "save");
+
   gimp_unset_busy (gimp);
 
   return return_vals;
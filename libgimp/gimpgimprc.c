@@ -58,3 +58,36 @@ gimp_get_color_configuration (void)
 
   return config;
 }
+
+/**
+ * gimp_get_num_processors:
+ *
+ * Returns the number of threads the user allows GIMP to use, as set
+ * in the "num-processors" gimprc option.  Plug-ins that process
+ * data on several threads should not use more than that.
+ *
+ * Returns: The number of threads to use, between 1 and
+ *          %GIMP_MAX_NUM_THREADS.
+ *
+ * Since: GIMP 2.10
+ */
+gint
+gimp_get_num_processors (void)
+{
+  gchar  *value = gimp_gimprc_query ("num-processors");
+  gint64  n     = 1;
+
+  if (value)
+    {
+      gchar *end;
+
+      n = g_ascii_strtoll (value, &end, 10);
+
+      if (end == value || *end != '\0')
+        n = 1;
+
+      g_free (value);
+    }
+
+  return CLAMP (n, 1, GIMP_MAX_NUM_THREADS);
+}
@@ -31,6 +31,7 @@ G_BEGIN_DECLS
 
 
 GimpColorConfig * gimp_get_color_configuration (void);
+gint              gimp_get_num_processors      (void);
 
 
 G_END_DECLS
@@ -91,6 +91,16 @@ G_BEGIN_DECLS
                                                   *  and must be < G_MAXDOUBLE
                                                   */
 
+/**
+ * GIMP_MAX_NUM_THREADS:
+ *
+ * The maximum number of threads GIMP uses for processing, and so the
+ * largest value the "num-processors" gimprc setting can take.
+ *
+ * Since: GIMP 2.10
+ **/
+#define GIMP_MAX_NUM_THREADS 16
+
 
 G_END_DECLS
 
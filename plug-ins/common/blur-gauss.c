@@ -32,6 +32,8 @@
 #define PLUG_IN_BINARY  "blur-gauss"
 #define PLUG_IN_ROLE    "gimp-blur-gauss"
 
+#define BLUR_GROUP      16  /* columns transposed together */
+
 typedef enum
 {
   BLUR_IIR,
@@ -45,6 +47,37 @@ typedef struct
   BlurMethod  method;
 } BlurValues;
 
+typedef struct
+{
+  BlurMethod  method;
+  gint        bytes;
+  gboolean    has_alpha;
+
+  /*  IIR constants  */
+  gdouble     n_p[5], n_m[5];
+  gdouble     d_p[5], d_m[5];
+  gdouble     bd_p[5], bd_m[5];
+
+  /*  RLE curve  */
+  gint       *curve;
+  gint       *sum;
+  gint        length;
+  gint        total;
+} BlurParams;
+
+typedef struct
+{
+  const BlurParams *params;
+  gboolean          vertical;    /* the lines are the columns of the block */
+  const guchar     *src;
+  gint              src_stride;  /* in pixels */
+  guchar           *dest;
+  gint              dest_stride; /* in pixels */
+  gint              length;      /* length of a line, in pixels */
+  gint              first;
+  gint              n_lines;
+} BlurJob;
+
 
 /* Declare local functions.
  */
@@ -104,6 +137,20 @@ static inline gint run_length_encode (const guchar *src,
                                       gint          border,
                                       gboolean      pack);
 
+static void      blur_pass         (const BlurParams *params,
+                                    gboolean          vertical,
+                                    GimpPixelRgn     *src_rgn,
+                                    GimpPixelRgn     *dest_rgn,
+                                    guchar           *preview_buffer,
+                                    gint              x1,
+                                    gint              y1,
+                                    gint              width,
+                                    gint              height,
+                                    gdouble           progress_start,
+                                    gdouble           progress_end);
+static void      blur_lines        (BlurJob          *job,
+                                    gpointer          user_data);
+
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -870,299 +917,370 @@ do_full_lre (const gint *src,
     }
 }
 
+/* Blurs one line of pixels with the IIR filter. src is modified. */
 static void
-gauss_iir (GimpDrawable *drawable,
-           gdouble       horz,
-           gdouble       vert,
-           BlurMethod    method,
-           guchar       *preview_buffer,
-           gint          x1,
-           gint          y1,
-           gint          width,
-           gint          height)
+iir_line (const BlurParams *params,
+          guchar           *src,
+          guchar           *dest,
+          gint              length,
+          gdouble          *val_p,
+          gdouble          *val_m)
 {
-  GimpPixelRgn  src_rgn, dest_rgn;
-  gint          bytes;
-  gint          has_alpha;
-  guchar       *dest;
-  guchar       *src,  *sp_p, *sp_m;
-  gdouble       n_p[5], n_m[5];
-  gdouble       d_p[5], d_m[5];
-  gdouble       bd_p[5], bd_m[5];
-  gdouble      *val_p = NULL;
-  gdouble      *val_m = NULL;
-  gdouble      *vp, *vm;
-  gint          i, j;
-  gint          row, col, b;
-  gint          terms;
-  gdouble       progress, max_progress;
-  gint          initial_p[4];
-  gint          initial_m[4];
-  gdouble       std_dev;
-  gboolean      direct;
-  gint          progress_step;
-
-  direct = (preview_buffer == NULL);
-
-  bytes = drawable->bpp;
-  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
-
-  val_p = g_new (gdouble, MAX (width, height) * bytes);
-  val_m = g_new (gdouble, MAX (width, height) * bytes);
-
-  src =  g_new (guchar, MAX (width, height) * bytes);
-  dest = g_new (guchar, MAX (width, height) * bytes);
-
-  gimp_pixel_rgn_init (&src_rgn,
-                       drawable, 0, 0, drawable->width, drawable->height,
-                       FALSE, FALSE);
-  if (direct)
+  gint     bytes = params->bytes;
+  guchar  *sp_p, *sp_m;
+  gdouble *vp, *vm;
+  gint     initial_p[4];
+  gint     initial_m[4];
+  gint     i, j;
+  gint     pos, b;
+  gint     terms;
+
+  memset (val_p, 0, length * bytes * sizeof (gdouble));
+  memset (val_m, 0, length * bytes * sizeof (gdouble));
+
+  if (params->has_alpha)
+    multiply_alpha (src, length, bytes);
+
+  sp_p = src;
+  sp_m = src + (length - 1) * bytes;
+  vp = val_p;
+  vm = val_m + (length - 1) * bytes;
+
+  /*  Set up the first vals  */
+  for (i = 0; i < bytes; i++)
     {
-      gimp_pixel_rgn_init (&dest_rgn,
-                           drawable, 0, 0, drawable->width, drawable->height,
-                           TRUE, TRUE);
+      initial_p[i] = sp_p[i];
+      initial_m[i] = sp_m[i];
     }
 
-
-  progress = 0.0;
-  max_progress  = (horz <= 0.0) ? 0 : width * height * horz;
-  max_progress += (vert <= 0.0) ? 0 : width * height * vert;
-
-
-  /*  First the vertical pass  */
-  if (vert > 0.0)
+  for (pos = 0; pos < length; pos++)
     {
-      vert = fabs (vert) + 1.0;
-      std_dev = sqrt (-(vert * vert) / (2 * log (1.0 / 255.0)));
-
-      /* We do not want too many progress updates because they
-       * can slow down the processing significantly for very
-       * large images
-       */
-      progress_step = width / 16;
-
-      if (progress_step < 5)
-        progress_step = 5;
+      gdouble *vpptr, *vmptr;
 
-      /*  derive the constants for calculating the gaussian
-       *  from the std dev
-       */
+      terms = (pos < 4) ? pos : 4;
 
-      find_iir_constants (n_p, n_m, d_p, d_m, bd_p, bd_m, std_dev);
-
-      for (col = 0; col < width; col++)
+      for (b = 0; b < bytes; b++)
         {
-          memset (val_p, 0, height * bytes * sizeof (gdouble));
-          memset (val_m, 0, height * bytes * sizeof (gdouble));
-
-          gimp_pixel_rgn_get_col (&src_rgn, src, col + x1, y1, height);
-
-          if (has_alpha)
-            multiply_alpha (src, height, bytes);
-
-          sp_p = src;
-          sp_m = src + (height - 1) * bytes;
-          vp = val_p;
-          vm = val_m + (height - 1) * bytes;
+          vpptr = vp + b; vmptr = vm + b;
 
-          /*  Set up the first vals  */
-          for (i = 0; i < bytes; i++)
+          for (i = 0; i <= terms; i++)
             {
-              initial_p[i] = sp_p[i];
-              initial_m[i] = sp_m[i];
+              *vpptr += params->n_p[i] * sp_p[(-i * bytes) + b] -
+                params->d_p[i] * vp[(-i * bytes) + b];
+              *vmptr += params->n_m[i] * sp_m[(i * bytes) + b] -
+                params->d_m[i] * vm[(i * bytes) + b];
             }
-
-          for (row = 0; row < height; row++)
+          for (j = i; j <= 4; j++)
             {
-              gdouble *vpptr, *vmptr;
-              terms = (row < 4) ? row : 4;
-
-              for (b = 0; b < bytes; b++)
-                {
-                  vpptr = vp + b; vmptr = vm + b;
-                  for (i = 0; i <= terms; i++)
-                    {
-                      *vpptr += n_p[i] * sp_p[(-i * bytes) + b] - d_p[i] * vp[(-i * bytes) + b];
-                      *vmptr += n_m[i] * sp_m[(i * bytes) + b] - d_m[i] * vm[(i * bytes) + b];
-                    }
-                  for (j = i; j <= 4; j++)
-                    {
-                      *vpptr += (n_p[j] - bd_p[j]) * initial_p[b];
-                      *vmptr += (n_m[j] - bd_m[j]) * initial_m[b];
-                    }
-                }
-
-              sp_p += bytes;
-              sp_m -= bytes;
-              vp += bytes;
-              vm -= bytes;
+              *vpptr += (params->n_p[j] - params->bd_p[j]) * initial_p[b];
+              *vmptr += (params->n_m[j] - params->bd_m[j]) * initial_m[b];
             }
+        }
 
-          transfer_pixels (val_p, val_m, dest, bytes, height);
+      sp_p += bytes;
+      sp_m -= bytes;
+      vp += bytes;
+      vm -= bytes;
+    }
 
+  transfer_pixels (val_p, val_m, dest, bytes, length);
 
-          if (has_alpha)
-            separate_alpha (dest, height, bytes);
+  if (params->has_alpha)
+    separate_alpha (dest, length, bytes);
+}
 
-          if (direct)
-            {
-              gimp_pixel_rgn_set_col(&dest_rgn, dest, col + x1, y1, height);
+/* Blurs one line of pixels with the RLE curve. src is modified. */
+static void
+rle_line (const BlurParams *params,
+          guchar           *src,
+          guchar           *dest,
+          gint              length,
+          gint             *rle,
+          gint             *pix)
+{
+  gint bytes = params->bytes;
+  gint b;
 
-              progress += height * vert;
+  if (params->has_alpha)
+    multiply_alpha (src, length, bytes);
 
-              if ((col % progress_step) == 0)
-                gimp_progress_update (progress / max_progress);
-            }
-          else
-            {
-              for (row = 0; row < height; row++)
-                memcpy (preview_buffer + (row * width + col) * bytes,
-                        dest + row * bytes,
-                        bytes);
-            }
+  for (b = 0; b < bytes; b++)
+    {
+      gint same = run_length_encode (src + b, rle, pix, bytes,
+                                     length, params->length, TRUE);
+
+      if (same > (3 * length) / 4)
+        {
+          /* encoded_rle is only fastest if there are a lot of
+           * repeating pixels
+           */
+          do_encoded_lre (rle, pix, dest + b, length, params->length, bytes,
+                          params->curve, params->total, params->sum);
         }
+      else
+        {
+          /* else a full but more simple algorithm is better */
+          do_full_lre (pix, dest + b, length, params->length, bytes,
+                       params->curve, params->total);
+        }
+    }
 
-      /*  prepare for the horizontal pass  */
-      gimp_pixel_rgn_init (&src_rgn,
-                           drawable,
-                           0, 0,
-                           drawable->width, drawable->height,
-                           FALSE, TRUE);
+  if (params->has_alpha)
+    separate_alpha (dest, length, bytes);
+}
+
+/* Blurs the lines of a job, also runs on the thread pool. The lines
+ * are copied to contiguous buffers first, columns are transposed
+ * BLUR_GROUP at a time so the reads stay within the same rows of the
+ * block. On the pool, user_data is the queue the finished job is
+ * pushed to.
+ */
+static void
+blur_lines (BlurJob  *job,
+            gpointer  user_data)
+{
+  const BlurParams *params = job->params;
+  gint              bytes  = params->bytes;
+  gint              length = job->length;
+  gsize             line_size = (gsize) length * bytes;
+  guchar           *lines_src;
+  guchar           *lines_dest;
+  gdouble          *val_p = NULL;
+  gdouble          *val_m = NULL;
+  gint             *rle   = NULL;
+  gint             *pix   = NULL;
+  gint              line;
+  gint              g, i;
+
+  lines_src  = g_new (guchar, BLUR_GROUP * line_size);
+  lines_dest = g_new (guchar, BLUR_GROUP * line_size);
+
+  if (params->method == BLUR_IIR)
+    {
+      val_p = g_new (gdouble, length * bytes);
+      val_m = g_new (gdouble, length * bytes);
     }
-  else if (!direct)
+  else
     {
-      gimp_pixel_rgn_get_rect (&src_rgn,
-                               preview_buffer,
-                               x1, y1,
-                               width, height);
+      rle = g_new (gint, length + 2 * params->length);
+      rle += params->length; /* rle[] extends from -length to length+length-1 */
+
+      pix = g_new (gint, length + 2 * params->length);
+      pix += params->length; /* pix[] extends from -length to length+length-1 */
     }
 
-  /*  Now the horizontal pass  */
-  if (horz > 0.0)
+  for (line = job->first; line < job->first + job->n_lines; line += BLUR_GROUP)
     {
+      gint n_group = MIN (BLUR_GROUP, job->first + job->n_lines - line);
 
-      /* We do not want too many progress updates because they
-       * can slow down the processing significantly for very
-       * large images
-       */
-      progress_step = height / 16;
-
-      if (progress_step < 5)
-        progress_step = 5;
+      if (job->vertical)
+        {
+          for (i = 0; i < length; i++)
+            {
+              const guchar *s = job->src + ((gsize) i * job->src_stride + line) * bytes;
 
-      horz = fabs (horz) + 1.0;
+              for (g = 0; g < n_group; g++)
+                memcpy (lines_src + g * line_size + i * bytes,
+                        s + g * bytes, bytes);
+            }
+        }
+      else
+        {
+          for (g = 0; g < n_group; g++)
+            memcpy (lines_src + g * line_size,
+                    job->src + (gsize) (line + g) * job->src_stride * bytes,
+                    line_size);
+        }
 
-      if (horz != vert)
+      for (g = 0; g < n_group; g++)
         {
-          std_dev = sqrt (-(horz * horz) / (2 * log (1.0 / 255.0)));
+          if (params->method == BLUR_IIR)
+            iir_line (params, lines_src + g * line_size,
+                      lines_dest + g * line_size, length, val_p, val_m);
+          else
+            rle_line (params, lines_src + g * line_size,
+                      lines_dest + g * line_size, length, rle, pix);
+        }
 
-          /*  derive the constants for calculating the gaussian
-           *  from the std dev
-           */
-          find_iir_constants (n_p, n_m, d_p, d_m, bd_p, bd_m, std_dev);
+      if (job->vertical)
+        {
+          for (i = 0; i < length; i++)
+            {
+              guchar *d = job->dest + ((gsize) i * job->dest_stride + line) * bytes;
 
+              for (g = 0; g < n_group; g++)
+                memcpy (d + g * bytes,
+                        lines_dest + g * line_size + i * bytes, bytes);
+            }
+        }
+      else
+        {
+          for (g = 0; g < n_group; g++)
+            memcpy (job->dest + (gsize) (line + g) * job->dest_stride * bytes,
+                    lines_dest + g * line_size,
+                    line_size);
         }
+    }
 
+  g_free (val_p);
+  g_free (val_m);
 
-      for (row = 0; row < height; row++)
-        {
+  if (rle)
+    g_free (rle - params->length);
+  if (pix)
+    g_free (pix - params->length);
 
-          memset (val_p, 0, width * bytes * sizeof (gdouble));
-          memset (val_m, 0, width * bytes * sizeof (gdouble));
+  g_free (lines_src);
+  g_free (lines_dest);
 
-          if (direct)
-            {
-              gimp_pixel_rgn_get_row (&src_rgn, src, x1, row + y1, width);
-            }
-          else
-            {
-              memcpy (src,
-                      preview_buffer + row * width * bytes,
-                      width * bytes);
-            }
+  if (user_data)
+    g_async_queue_push (user_data, job);
+}
 
+/* Runs one pass of the blur over the area, in blocks of columns for the
+ * vertical pass and blocks of rows for the horizontal one. Pixels are
+ * read from src_rgn, or from preview_buffer if it is NULL, and written
+ * to dest_rgn, or to preview_buffer if it is NULL. The lines of each
+ * block are independent, and blurred in parallel on a thread pool
+ * that is kept for the whole pass.
+ */
+static void
+blur_pass (const BlurParams *params,
+           gboolean          vertical,
+           GimpPixelRgn     *src_rgn,
+           GimpPixelRgn     *dest_rgn,
+           guchar           *preview_buffer,
+           gint              x1,
+           gint              y1,
+           gint              width,
+           gint              height,
+           gdouble           progress_start,
+           gdouble           progress_end)
+{
+  BlurJob     *jobs;
+  GThreadPool *pool = NULL;
+  GAsyncQueue *done = NULL;
+  guchar      *src  = NULL;
+  guchar      *dest = NULL;
+  gint         bytes = params->bytes;
+  gint         n_threads;
+  gint         step;
+  gint         total;
+  gint         pos;
+  gint         i;
+
+  n_threads = gimp_get_num_processors ();
+
+  if (vertical)
+    {
+      step  = MIN (gimp_tile_width () * n_threads, width);
+      total = width;
+    }
+  else
+    {
+      step  = MIN (gimp_tile_height () * n_threads, height);
+      total = height;
+    }
 
-          if (has_alpha)
-            multiply_alpha (src, width, bytes);
+  if (src_rgn)
+    src = g_new (guchar, (gsize) (vertical ? step : width) *
+                         (vertical ? height : step) * bytes);
+  if (dest_rgn)
+    dest = g_new (guchar, (gsize) (vertical ? step : width) *
+                          (vertical ? height : step) * bytes);
 
+  jobs = g_new0 (BlurJob, n_threads);
 
-          sp_p = src;
-          sp_m = src + (width - 1) * bytes;
-          vp = val_p;
-          vm = val_m + (width - 1) * bytes;
+  if (n_threads > 1)
+    {
+      done = g_async_queue_new ();
+      pool = g_thread_pool_new ((GFunc) blur_lines, done,
+                                n_threads - 1, FALSE, NULL);
+    }
 
-          /*  Set up the first vals  */
-          for (i = 0; i < bytes; i++)
-            {
-              initial_p[i] = sp_p[i];
-              initial_m[i] = sp_m[i];
-            }
+  for (pos = 0; pos < total; pos += step)
+    {
+      gint          bx = vertical ? pos : 0;
+      gint          by = vertical ? 0   : pos;
+      gint          bw = vertical ? MIN (step, width - pos) : width;
+      gint          bh = vertical ? height : MIN (step, height - pos);
+      const guchar *block_src;
+      guchar       *block_dest;
+      gint          src_stride;
+      gint          dest_stride;
+      gint          n_lines = vertical ? bw : bh;
+      gint          n_jobs  = MIN (n_threads, n_lines);
+
+      if (src_rgn)
+        {
+          gimp_pixel_rgn_get_rect (src_rgn, src, x1 + bx, y1 + by, bw, bh);
+          block_src  = src;
+          src_stride = bw;
+        }
+      else
+        {
+          block_src  = preview_buffer + ((gsize) by * width + bx) * bytes;
+          src_stride = width;
+        }
 
-          for (col = 0; col < width; col++)
-            {
-              gdouble *vpptr, *vmptr;
-
-              terms = (col < 4) ? col : 4;
-
-              for (b = 0; b < bytes; b++)
-                {
-                  vpptr = vp + b; vmptr = vm + b;
-
-                  for (i = 0; i <= terms; i++)
-                    {
-                      *vpptr += n_p[i] * sp_p[(-i * bytes) + b] -
-                        d_p[i] * vp[(-i * bytes) + b];
-                      *vmptr += n_m[i] * sp_m[(i * bytes) + b] -
-                        d_m[i] * vm[(i * bytes) + b];
-                    }
-                  for (j = i; j <= 4; j++)
-                    {
-                      *vpptr += (n_p[j] - bd_p[j]) * initial_p[b];
-                      *vmptr += (n_m[j] - bd_m[j]) * initial_m[b];
-                    }
-                }
-
-              sp_p += bytes;
-              sp_m -= bytes;
-              vp += bytes;
-              vm -= bytes;
-            }
+      if (dest_rgn)
+        {
+          block_dest  = dest;
+          dest_stride = bw;
+        }
+      else
+        {
+          block_dest  = preview_buffer + ((gsize) by * width + bx) * bytes;
+          dest_stride = width;
+        }
 
-          transfer_pixels (val_p, val_m, dest, bytes, width);
+      for (i = 0; i < n_jobs; i++)
+        {
+          jobs[i].params      = params;
+          jobs[i].vertical    = vertical;
+          jobs[i].src         = block_src;
+          jobs[i].src_stride  = src_stride;
+          jobs[i].dest        = block_dest;
+          jobs[i].dest_stride = dest_stride;
+          jobs[i].length      = vertical ? bh : bw;
+          jobs[i].first       = n_lines * i / n_jobs;
+          jobs[i].n_lines     = n_lines * (i + 1) / n_jobs - jobs[i].first;
+        }
 
-          if (has_alpha)
-            separate_alpha (dest, width, bytes);
+      /*  the other jobs run on the pool while this thread blurs the
+       *  first one, then wait for them to finish
+       */
+      for (i = 1; i < n_jobs; i++)
+        g_thread_pool_push (pool, &jobs[i], NULL);
 
-          if (direct)
-            {
-              gimp_pixel_rgn_set_row (&dest_rgn, dest, x1, row + y1, width);
+      blur_lines (&jobs[0], NULL);
 
-              progress += width * horz;
+      for (i = 1; i < n_jobs; i++)
+        g_async_queue_pop (done);
 
-              if ((row % progress_step) == 0)
-                gimp_progress_update (progress / max_progress);
-            }
-          else
-            {
-              memcpy (preview_buffer + row * width * bytes,
-                      dest,
-                      width * bytes);
-            }
+      if (dest_rgn)
+        {
+          gimp_pixel_rgn_set_rect (dest_rgn, dest, x1 + bx, y1 + by, bw, bh);
+
+          gimp_progress_update (progress_start +
+                                (progress_end - progress_start) *
+                                (pos + n_lines) / total);
         }
     }
 
-  /*  free up buffers  */
-
-  g_free (val_p);
-  g_free (val_m);
+  if (pool)
+    {
+      g_thread_pool_free (pool, FALSE, TRUE);
+      g_async_queue_unref (done);
+    }
 
+  g_free (jobs);
   g_free (src);
   g_free (dest);
 }
 
-
 static void
-gauss_rle (GimpDrawable *drawable,
+gauss_iir (GimpDrawable *drawable,
            gdouble       horz,
            gdouble       vert,
            BlurMethod    method,
@@ -1173,121 +1291,138 @@ gauss_rle (GimpDrawable *drawable,
            gint          height)
 {
   GimpPixelRgn  src_rgn, dest_rgn;
-  gint          bytes;
-  gboolean      has_alpha;
-  guchar       *dest;
-  guchar       *src;
-  gint          row, col, b;
-  gdouble       progress, max_progress;
+  BlurParams    params = { 0, };
   gdouble       std_dev;
-  gint          total = 1;
-  gint         *curve = NULL;
-  gint         *sum   = NULL;
-  gint          length;
+  gdouble       vert_progress;
   gboolean      direct;
-  gint          progress_step;
 
   direct = (preview_buffer == NULL);
 
-  bytes = drawable->bpp;
-  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
-
-  src  = g_new (guchar, MAX (width, height) * bytes);
-  dest = g_new (guchar, MAX (width, height) * bytes);
+  params.method    = BLUR_IIR;
+  params.bytes     = drawable->bpp;
+  params.has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
 
   gimp_pixel_rgn_init (&src_rgn,
                        drawable, 0, 0, drawable->width, drawable->height,
                        FALSE, FALSE);
-
   if (direct)
-    gimp_pixel_rgn_init (&dest_rgn,
-                         drawable, 0, 0, drawable->width, drawable->height,
-                         TRUE, TRUE);
-
-  progress = 0.0;
-  max_progress  = (horz <= 0.0) ? 0 : width * height * horz;
-  max_progress += (vert <= 0.0) ? 0 : width * height * vert;
+    {
+      gimp_pixel_rgn_init (&dest_rgn,
+                           drawable, 0, 0, drawable->width, drawable->height,
+                           TRUE, TRUE);
+    }
 
+  /*  the share of the progress taken by the vertical pass  */
+  if (horz <= 0.0)
+    vert_progress = 1.0;
+  else if (vert <= 0.0)
+    vert_progress = 0.0;
+  else
+    vert_progress = vert / (horz + vert);
 
   /*  First the vertical pass  */
   if (vert > 0.0)
     {
-      gint   * rle = NULL;
-      gint   * pix = NULL;
-
       vert = fabs (vert) + 1.0;
       std_dev = sqrt (-(vert * vert) / (2 * log (1.0 / 255.0)));
 
-      /* Insure that we do not have too many progress updates for
-       * images with a lot of rows or columns
+      /*  derive the constants for calculating the gaussian
+       *  from the std dev
        */
-      progress_step = width / 16;
+      find_iir_constants (params.n_p, params.n_m, params.d_p, params.d_m,
+                          params.bd_p, params.bd_m, std_dev);
 
-      if (progress_step < 5)
-        progress_step = 5;
+      blur_pass (&params, TRUE, &src_rgn, direct ? &dest_rgn : NULL,
+                 preview_buffer, x1, y1, width, height,
+                 0.0, vert_progress);
 
-      make_rle_curve (std_dev, &curve, &length, &sum, &total);
+      /*  prepare for the horizontal pass  */
+      gimp_pixel_rgn_init (&src_rgn,
+                           drawable,
+                           0, 0,
+                           drawable->width, drawable->height,
+                           FALSE, TRUE);
+    }
+  else if (!direct)
+    {
+      gimp_pixel_rgn_get_rect (&src_rgn,
+                               preview_buffer,
+                               x1, y1,
+                               width, height);
+    }
 
-      rle = g_new (gint, height + 2 * length);
-      rle += length; /* rle[] extends from -length to height+length-1 */
+  /*  Now the horizontal pass  */
+  if (horz > 0.0)
+    {
+      horz = fabs (horz) + 1.0;
+      std_dev = sqrt (-(horz * horz) / (2 * log (1.0 / 255.0)));
 
-      pix = g_new (gint, height + 2 * length);
-      pix += length; /* pix[] extends from -length to height+length-1 */
+      /*  derive the constants for calculating the gaussian
+       *  from the std dev
+       */
+      find_iir_constants (params.n_p, params.n_m, params.d_p, params.d_m,
+                          params.bd_p, params.bd_m, std_dev);
 
-      for (col = 0; col < width; col++)
-        {
+      blur_pass (&params, FALSE,
+                 direct ? &src_rgn : NULL, direct ? &dest_rgn : NULL,
+                 preview_buffer, x1, y1, width, height,
+                 vert_progress, 1.0);
+    }
+}
 
-          gimp_pixel_rgn_get_col (&src_rgn, src, col + x1, y1, height);
 
-          if (has_alpha)
-            multiply_alpha (src, height, bytes);
+static void
+gauss_rle (GimpDrawable *drawable,
+           gdouble       horz,
+           gdouble       vert,
+           BlurMethod    method,
+           guchar       *preview_buffer,
+           gint          x1,
+           gint          y1,
+           gint          width,
+           gint          height)
+{
+  GimpPixelRgn  src_rgn, dest_rgn;
+  BlurParams    params = { 0, };
+  gdouble       std_dev;
+  gdouble       vert_progress;
+  gboolean      direct;
 
-          for (b = 0; b < bytes; b++)
-            {
-              gint same =  run_length_encode (src + b, rle, pix, bytes,
-                                              height, length, TRUE);
-
-              if (same > (3 * height) / 4)
-                {
-                  /* encoded_rle is only fastest if there are a lot of
-                   * repeating pixels
-                   */
-                  do_encoded_lre (rle, pix, dest + b, height, length, bytes,
-                                  curve, total, sum);
-                }
-              else
-                {
-                  /* else a full but more simple algorithm is better */
-                  do_full_lre (pix, dest + b, height, length, bytes,
-                               curve, total);
-                }
-            }
+  direct = (preview_buffer == NULL);
 
-          if (has_alpha)
-            separate_alpha (dest, height, bytes);
+  params.method    = BLUR_RLE;
+  params.bytes     = drawable->bpp;
+  params.has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
 
-          if (direct)
-            {
-              gimp_pixel_rgn_set_col (&dest_rgn, dest, col + x1, y1, height);
+  gimp_pixel_rgn_init (&src_rgn,
+                       drawable, 0, 0, drawable->width, drawable->height,
+                       FALSE, FALSE);
 
-              progress += height * vert;
+  if (direct)
+    gimp_pixel_rgn_init (&dest_rgn,
+                         drawable, 0, 0, drawable->width, drawable->height,
+                         TRUE, TRUE);
 
-              if ((col % progress_step) == 0)
-                gimp_progress_update (progress / max_progress);
-            }
-          else
-            {
-              for (row = 0; row < height; row++)
-                memcpy (preview_buffer + (row * width + col) * bytes,
-                        dest + row * bytes,
-                        bytes);
-            }
+  /*  the share of the progress taken by the vertical pass  */
+  if (horz <= 0.0)
+    vert_progress = 1.0;
+  else if (vert <= 0.0)
+    vert_progress = 0.0;
+  else
+    vert_progress = vert / (horz + vert);
 
-        }
+  /*  First the vertical pass  */
+  if (vert > 0.0)
+    {
+      vert = fabs (vert) + 1.0;
+      std_dev = sqrt (-(vert * vert) / (2 * log (1.0 / 255.0)));
 
+      make_rle_curve (std_dev, &params.curve, &params.length,
+                      &params.sum, &params.total);
 
-      g_free (rle - length);
-      g_free (pix - length);
+      blur_pass (&params, TRUE, &src_rgn, direct ? &dest_rgn : NULL,
+                 preview_buffer, x1, y1, width, height,
+                 0.0, vert_progress);
 
       /* prepare for the horizontal pass  */
       gimp_pixel_rgn_init (&src_rgn,
@@ -1303,108 +1438,28 @@ gauss_rle (GimpDrawable *drawable,
   /*  Now the horizontal pass  */
   if (horz > 0.0)
     {
-      gint   * rle = NULL;
-      gint   * pix = NULL;
-
-      /* Insure that we do not have too many progress updates for
-       * images with a lot of rows or columns
-       */
-      progress_step = height / 16;
-
-      if (progress_step < 5) {
-        progress_step = 5;
-      }
-
       horz = fabs (horz) + 1.0;
 
-      /* euse the same curve if possible else recompute a new one */
+      /* reuse the same curve if possible else recompute a new one */
       if (horz != vert)
         {
-
           std_dev = sqrt (-(horz * horz) / (2 * log (1.0 / 255.0)));
 
-          if (curve != NULL) {
-            free_rle_curve(curve, length, sum);
-          }
-
-          make_rle_curve(std_dev, &curve, &length, &sum, &total);
-
-        }
-
-
-      rle = g_new (gint, width+2*length);
-      rle += length; /* so rle[] extends from -width to width+length-1 */
-
-      pix = g_new (gint, width+2*length);
-      pix += length; /* so pix[] extends from -width to width+length-1 */
-
-      for (row = 0; row < height; row++)
-        {
-          if (direct)
-            {
-              gimp_pixel_rgn_get_row (&src_rgn, src, x1, row + y1, width);
-            }
-          else
-            {
-              memcpy (src,
-                      preview_buffer + row * width * bytes,
-                      width * bytes);
-            }
-
-          if (has_alpha)
-            multiply_alpha (src, width, bytes);
-
-          for (b = 0; b < bytes; b++)
-            {
-              gint same = run_length_encode (src + b, rle, pix, bytes,
-                                             width, length, TRUE);
-
-              if (same > (3 * width) / 4)
-                {
-                  /* encoded_rle is only fastest if there are a lot of
-                   * repeating pixels
-                   */
-                  do_encoded_lre (rle, pix, dest + b, width, length, bytes,
-                                  curve, total, sum);
-                }
-              else
-                {
-                  /* else a full but more simple algorithm is better */
-                  do_full_lre (pix, dest + b, width, length, bytes,
-                               curve, total);
-                }
-            }
-
-
-          if (has_alpha)
-            separate_alpha (dest, width, bytes);
-
-          if (direct)
-            {
-              gimp_pixel_rgn_set_row (&dest_rgn, dest, x1, row + y1, width);
+          if (params.curve != NULL)
+            free_rle_curve (params.curve, params.length, params.sum);
 
-              progress += width * horz;
-
-              if ((row % progress_step) == 0)
-                gimp_progress_update (progress / max_progress);
-            }
-          else
-            {
-              memcpy (preview_buffer + row * width * bytes,
-                      dest,
-                      width * bytes);
-            }
+          make_rle_curve (std_dev, &params.curve, &params.length,
+                          &params.sum, &params.total);
         }
 
-      g_free (rle - length);
-      g_free (pix - length);
+      blur_pass (&params, FALSE,
+                 direct ? &src_rgn : NULL, direct ? &dest_rgn : NULL,
+                 preview_buffer, x1, y1, width, height,
+                 vert_progress, 1.0);
     }
 
-  if (curve)
-    free_rle_curve (curve, length, sum);
-
-  g_free (src);
-  g_free (dest);
+  if (params.curve)
+    free_rle_curve (params.curve, params.length, params.sum);
 }
 
 
@@ -99,6 +99,48 @@ typedef struct
   gint *pages;
 } TiffSelectedPages;
 
+typedef enum
+{
+  READ_RGBA,    /* 8 bit RGBA through TIFFReadRGBAStrip() / Tile() */
+  READ_SAMPLES  /* the samples as stored, in one or more planes     */
+} ReadMode;
+
+/* One band of rows of the image, read strip by strip or tile by tile.
+ * Bands are a whole number of strips or tiles high, so each strip or
+ * tile is decoded exactly once.
+ */
+typedef struct
+{
+  ReadMode   mode;
+  uint32     width;
+  uint32     length;
+  uint32     unit_width;   /* width of a strip or tile  */
+  uint32     unit_length;  /* height of a strip or tile */
+  gboolean   tiled;
+  gint       n_planes;
+  gint       bpp;          /* bytes per pixel of a plane */
+  uint32     y;            /* first row of the band      */
+  uint32     rows;         /* number of rows in the band */
+  guchar   **planes;       /* rows * width * bpp bytes per plane */
+} TiffBand;
+
+typedef struct
+{
+  TiffBand *band;
+  TIFF     *tif;           /* each job reads through its own handle */
+  gsize     buffer_size;
+  guchar   *buffer;        /* room for one strip or tile, allocated
+                              when the job reads its first one      */
+  gint      first;
+  gint      n_jobs;
+  GSList   *messages;      /* libtiff messages, reported later      */
+  gboolean  success;
+} TiffBandJob;
+
+typedef void (* TiffBandFunc) (TiffBand     *band,
+                               channel_data *channel,
+                               gint          extra);
+
 /* Declare some local functions.
  */
 static void   query     (void);
@@ -116,14 +158,17 @@ static gint32    load_image       (const gchar        *filename,
                                    TiffSelectedPages  *pages,
                                    GError            **error);
 
-static void      load_rgba        (TIFF         *tif,
+static void      load_rgba        (const gchar  *filename,
+                                   TIFF         *tif,
                                    channel_data *channel);
-static void      load_contiguous  (TIFF         *tif,
+static void      load_contiguous  (const gchar  *filename,
+                                   TIFF         *tif,
                                    channel_data *channel,
                                    gushort       bps,
                                    gushort       spp,
                                    gint          extra);
-static void      load_separate    (TIFF         *tif,
+static void      load_separate    (const gchar  *filename,
+                                   TIFF         *tif,
                                    channel_data *channel,
                                    gushort       bps,
                                    gushort       spp,
@@ -150,10 +195,31 @@ static void      tiff_warning  (const gchar  *module,
 static void      tiff_error    (const gchar  *module,
                                 const gchar  *fmt,
                                 va_list       ap);
+static void      tiff_log      (const gchar  *fmt,
+                                va_list       ap);
 static TIFF     *tiff_open     (const gchar  *filename,
                                 const gchar  *mode,
                                 GError      **error);
 
+static void      read_bands         (const gchar  *filename,
+                                     TIFF         *tif,
+                                     ReadMode      mode,
+                                     gint          n_planes,
+                                     gint          bpp,
+                                     TiffBandFunc  write_band,
+                                     channel_data *channel,
+                                     gint          extra);
+static void      read_band_units    (TiffBandJob  *job);
+static void      read_band_job      (TiffBandJob  *job,
+                                     gpointer      user_data);
+static void      report_band_job    (TiffBandJob  *job);
+static gboolean  read_unit          (TiffBand     *band,
+                                     TIFF         *tif,
+                                     guchar       *buffer,
+                                     gint          sample,
+                                     uint32        x,
+                                     uint32        y);
+
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -175,6 +241,14 @@ static GimpPageSelectorTarget  target        = GIMP_PAGE_SELECTOR_TARGET_LAYERS;
 
 static guchar       bit2byte[256 * 8];
 
+/*  protects band_jobs_left  */
+static GMutex       band_mutex;
+static GCond        band_cond;
+static gint         band_jobs_left = 0;
+
+/*  the TiffBandJob read by the current pool thread, if any  */
+static GPrivate     band_job_private;
+
 
 MAIN ()
 
@@ -376,7 +450,7 @@ tiff_warning (const gchar *module,
       return;
     }
 
-  g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
+  tiff_log (fmt, ap);
 }
 
 static void
@@ -389,7 +463,25 @@ tiff_error (const gchar *module,
   if (! strcmp (fmt, "Compression algorithm does not support random access"))
     return;
 
-  g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
+  tiff_log (fmt, ap);
+}
+
+/* The libtiff handlers are global, but messages must only be sent to
+ * the core from the main thread.  Messages about bands read on the
+ * thread pool are kept in their TiffBandJob, and reported once the
+ * band is read.
+ */
+static void
+tiff_log (const gchar *fmt,
+          va_list      ap)
+{
+  TiffBandJob *job = g_private_get (&band_job_private);
+
+  if (job)
+    job->messages = g_slist_append (job->messages,
+                                    g_strdup_vprintf (fmt, ap));
+  else
+    g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
 }
 
 static TIFF *
@@ -1030,15 +1122,15 @@ load_image (const gchar        *filename,
 
       if (worst_case)
         {
-          load_rgba (tif, channel);
+          load_rgba (filename, tif, channel);
         }
       else if (planar == PLANARCONFIG_CONTIG)
         {
-          load_contiguous (tif, channel, bps, spp, extra);
+          load_contiguous (filename, tif, channel, bps, spp, extra);
         }
       else
         {
-          load_separate (tif, channel, bps, spp, extra);
+          load_separate (filename, tif, channel, bps, spp, extra);
         }
 
       if (TIFFGetField (tif, TIFFTAG_ORIENTATION, &orientation))
@@ -1160,46 +1252,34 @@ load_image (const gchar        *filename,
 }
 
 static void
-load_rgba (TIFF         *tif,
-           channel_data *channel)
+write_rgba_band (TiffBand     *band,
+                 channel_data *channel,
+                 gint          extra)
 {
-  uint32  imageWidth, imageLength;
-  uint32  row;
-  uint32 *buffer;
-
-  g_printerr ("%s\n", __func__);
-
-  TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &imageWidth);
-  TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &imageLength);
-
-  buffer = g_new (uint32, imageWidth * imageLength);
-
-  if (!TIFFReadRGBAImage (tif, imageWidth, imageLength, buffer, 0))
-    g_message ("Unsupported layout, no RGBA loader");
-
-  for (row = 0; row < imageLength; ++row)
-    {
 #if G_BYTE_ORDER != G_LITTLE_ENDIAN
-      /* Make sure our channels are in the right order */
-      uint32 i;
-      uint32 rowStart = row * imageWidth;
-      uint32 rowEnd   = rowStart + imageWidth;
+  /* Make sure our channels are in the right order */
+  uint32 *pixels   = (uint32 *) band->planes[0];
+  gsize   n_pixels = (gsize) band->width * band->rows;
+  gsize   i;
 
-      for (i = rowStart; i < rowEnd; i++)
-        buffer[i] = GUINT32_TO_LE (buffer[i]);
+  for (i = 0; i < n_pixels; i++)
+    pixels[i] = GUINT32_TO_LE (pixels[i]);
 #endif
 
-      gegl_buffer_set (channel[0].buffer,
-                       GEGL_RECTANGLE (0, imageLength - row - 1, imageWidth, 1),
-                       0, channel[0].format,
-                       ((guchar *) buffer) + row * imageWidth * 4,
-                       GEGL_AUTO_ROWSTRIDE);
-
-      if ((row % 32) == 0)
-        gimp_progress_update ((gdouble) row / (gdouble) imageLength);
-    }
+  /* the RGBA interface always returns 8 bit samples */
+  gegl_buffer_set (channel[0].buffer,
+                   GEGL_RECTANGLE (0, band->y, band->width, band->rows),
+                   0, babl_format ("RGBA u8"),
+                   band->planes[0], GEGL_AUTO_ROWSTRIDE);
+}
 
-  g_free (buffer);
+static void
+load_rgba (const gchar  *filename,
+           TIFF         *tif,
+           channel_data *channel)
+{
+  read_bands (filename, tif, READ_RGBA, 1, 4,
+              write_rgba_band, channel, 0);
 }
 
 static void
@@ -1391,257 +1471,428 @@ load_paths (TIFF *tif, gint image)
 }
 
 
+/* Moves the components of each channel out of the interleaved samples */
 static void
-load_contiguous (TIFF         *tif,
+write_contiguous_band (TiffBand     *band,
+                       channel_data *channel,
+                       gint          extra)
+{
+  GeglRectangle  rect     = { 0, band->y, band->width, band->rows };
+  gsize          n_pixels = (gsize) band->width * band->rows;
+  guchar        *pixels;
+  gint           offset   = 0;
+  gint           i;
+
+  if (extra == 0)
+    {
+      gegl_buffer_set (channel[0].buffer, &rect, 0, channel[0].format,
+                       band->planes[0], GEGL_AUTO_ROWSTRIDE);
+      return;
+    }
+
+  pixels = g_malloc (n_pixels *
+                     babl_format_get_bytes_per_pixel (channel[0].format));
+
+  for (i = 0; i <= extra; i++)
+    {
+      gint          dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
+      const guchar *s        = band->planes[0] + offset;
+      guchar       *d        = pixels;
+      gsize         n;
+
+      for (n = 0; n < n_pixels; n++)
+        {
+          memcpy (d, s, dest_bpp);
+          d += dest_bpp;
+          s += band->bpp;
+        }
+
+      gegl_buffer_set (channel[i].buffer, &rect, 0, channel[i].format,
+                       pixels, GEGL_AUTO_ROWSTRIDE);
+
+      offset += dest_bpp;
+    }
+
+  g_free (pixels);
+}
+
+static void
+load_contiguous (const gchar  *filename,
+                 TIFF         *tif,
                  channel_data *channel,
                  gushort       bps,
                  gushort       spp,
                  gint          extra)
 {
-  uint32  imageWidth, imageLength;
-  uint32  tileWidth, tileLength;
-  uint32  x, y, rows, cols;
-  int bytes_per_pixel;
-  GeglBuffer *src_buf;
-  const Babl *src_format;
-  GeglBufferIterator *iter;
-  guchar *buffer;
-  gdouble progress = 0.0, one_row;
-  gint    i;
+  gint sample_bpp = (bps <= 8) ? 1 : 2;
+
+  read_bands (filename, tif, READ_SAMPLES, 1, spp * sample_bpp,
+              write_contiguous_band, channel, extra);
+}
+
+/* Interleaves the sample planes into the components of each channel.
+ * The first channel holds the first samples, each extra channel one
+ * of the remaining samples.
+ */
+static void
+write_separate_band (TiffBand     *band,
+                     channel_data *channel,
+                     gint          extra)
+{
+  GeglRectangle  rect     = { 0, band->y, band->width, band->rows };
+  gsize          n_pixels = (gsize) band->width * band->rows;
+  guchar        *pixels;
+  gint           sample   = 0;
+  gint           i;
+
+  pixels = g_malloc (n_pixels *
+                     babl_format_get_bytes_per_pixel (channel[0].format));
+
+  for (i = 0; i <= extra; i++)
+    {
+      gint n_comps  = babl_format_get_n_components (channel[i].format);
+      gint dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
+      gint j;
+
+      for (j = 0; j < n_comps && sample < band->n_planes; j++, sample++)
+        {
+          const guchar *s = band->planes[sample];
+          guchar       *d = pixels + j * band->bpp;
+          gsize         n;
+
+          for (n = 0; n < n_pixels; n++)
+            {
+              memcpy (d, s, band->bpp);
+              d += dest_bpp;
+              s += band->bpp;
+            }
+        }
+
+      gegl_buffer_set (channel[i].buffer, &rect, 0, channel[i].format,
+                       pixels, GEGL_AUTO_ROWSTRIDE);
+    }
 
-  g_printerr ("%s\n", __func__);
+  g_free (pixels);
+}
 
-  TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &imageWidth);
-  TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &imageLength);
+static void
+load_separate (const gchar  *filename,
+               TIFF         *tif,
+               channel_data *channel,
+               gushort       bps,
+               gushort       spp,
+               gint          extra)
+{
+  gint sample_bpp = (bps <= 8) ? 1 : 2;
 
-  tileWidth = imageWidth;
+  read_bands (filename, tif, READ_SAMPLES, spp, sample_bpp,
+              write_separate_band, channel, extra);
+}
 
-  if (TIFFIsTiled (tif))
+/* Reads the image in bands of whole strips or tiles, at least as high
+ * as GIMP's tiles, and hands each band to @write_band. The strips or
+ * tiles of a band are decoded in parallel, each thread through its own
+ * handle on the file, so only the band and one strip or tile per
+ * thread are kept in memory. There are never more threads than strips
+ * or tiles in a band.
+ */
+static void
+read_bands (const gchar  *filename,
+            TIFF         *tif,
+            ReadMode      mode,
+            gint          n_planes,
+            gint          bpp,
+            TiffBandFunc  write_band,
+            channel_data *channel,
+            gint          extra)
+{
+  TiffBand          band;
+  TiffBandJob      *jobs;
+  GThreadPool      *pool = NULL;
+  TIFFErrorHandler  warning_handler;
+  TIFFErrorHandler  error_handler;
+  gsize             buffer_size;
+  uint32            band_length;
+  uint32            target;
+  gint              n_units;
+  gint              n_threads;
+  gint              i;
+
+  TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &band.width);
+  TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &band.length);
+
+  band.mode     = mode;
+  band.tiled    = TIFFIsTiled (tif);
+  band.n_planes = n_planes;
+  band.bpp      = bpp;
+
+  if (band.tiled)
     {
-      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &tileWidth);
-      TIFFGetField (tif, TIFFTAG_TILELENGTH, &tileLength);
-      buffer = g_malloc (TIFFTileSize (tif));
+      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &band.unit_width);
+      TIFFGetField (tif, TIFFTAG_TILELENGTH, &band.unit_length);
+
+      buffer_size = TIFFTileSize (tif);
     }
   else
     {
-      tileWidth = imageWidth;
-      tileLength = 1;
-      buffer = g_malloc (TIFFScanlineSize (tif));
+      TIFFGetFieldDefaulted (tif, TIFFTAG_ROWSPERSTRIP, &band.unit_length);
+
+      band.unit_width  = band.width;
+      band.unit_length = CLAMP (band.unit_length, 1, band.length);
+
+      /*  strips are decoded in place  */
+      buffer_size = 0;
     }
 
-  one_row = (gdouble) tileLength / (gdouble) imageLength;
+  if (mode == READ_RGBA)
+    buffer_size = (gsize) band.unit_width * band.unit_length * 4;
 
-  if (bps <= 8)
-    src_format = babl_format_n (babl_type ("u8"), spp);
-  else
-    src_format = babl_format_n (babl_type ("u16"), spp);
+  n_threads = gimp_get_num_processors ();
 
-  /* consistency check */
-  bytes_per_pixel = 0;
-  for (i = 0; i <= extra; i++)
-    bytes_per_pixel += babl_format_get_bytes_per_pixel (channel[i].format);
+  /*  enough rows to keep all threads busy, rounded up to whole units  */
+  target      = gimp_tile_height () * n_threads;
+  band_length = ((target + band.unit_length - 1) / band.unit_length *
+                 band.unit_length);
+  band_length = MIN (band_length, band.length);
+
+  /*  small images may have fewer strips or tiles than threads  */
+  n_units = (((band.width + band.unit_width - 1) / band.unit_width) *
+             ((band_length + band.unit_length - 1) / band.unit_length) *
+             n_planes);
+  n_threads = MIN (n_threads, n_units);
+
+  band.planes = g_new (guchar *, n_planes);
+
+  for (i = 0; i < n_planes; i++)
+    band.planes[i] = g_malloc ((gsize) band.width * band_length * bpp);
+
+  jobs = g_new0 (TiffBandJob, n_threads);
 
-  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel,
-              babl_format_get_bytes_per_pixel (src_format));
+  jobs[0].tif = tif;
 
-  for (y = 0; y < imageLength; y += tileLength)
+  /*  the directory was already read through @tif, and any message
+   *  about it reported, don't report them again for every handle
+   */
+  warning_handler = TIFFSetWarningHandler (NULL);
+  error_handler   = TIFFSetErrorHandler (NULL);
+
+  for (i = 1; i < n_threads; i++)
+    {
+      jobs[i].tif = tiff_open (filename, "r", NULL);
+
+      if (! jobs[i].tif)
+        break;
+
+      TIFFSetDirectory (jobs[i].tif, TIFFCurrentDirectory (tif));
+    }
+
+  TIFFSetWarningHandler (warning_handler);
+  TIFFSetErrorHandler (error_handler);
+
+  n_threads = i;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      jobs[i].band        = &band;
+      jobs[i].buffer_size = buffer_size;
+      jobs[i].first       = i;
+      jobs[i].n_jobs      = n_threads;
+    }
+
+  if (n_threads > 1)
+    pool = g_thread_pool_new ((GFunc) read_band_job, NULL,
+                              n_threads, FALSE, NULL);
+
+  for (band.y = 0; band.y < band.length; band.y += band_length)
     {
-      for (x = 0; x < imageWidth; x += tileWidth)
+      gboolean success = TRUE;
+
+      band.rows = MIN (band_length, band.length - band.y);
+
+      if (pool)
         {
-          int offset;
+          band_jobs_left = n_threads;
 
-          gimp_progress_update (progress + one_row *
-                                ( (gdouble) x / (gdouble) imageWidth));
+          for (i = 0; i < n_threads; i++)
+            g_thread_pool_push (pool, &jobs[i], NULL);
 
-          if (TIFFIsTiled (tif))
-            TIFFReadTile (tif, buffer, x, y, 0, 0);
-          else
-            TIFFReadScanline (tif, buffer, y, 0);
-
-          cols = MIN (imageWidth - x, tileWidth);
-          rows = MIN (imageLength - y, tileLength);
-
-          src_buf = gegl_buffer_linear_new_from_data (buffer,
-                                                      src_format,
-                                                      GEGL_RECTANGLE (0, 0, cols, rows),
-                                                      GEGL_AUTO_ROWSTRIDE,
-                                                      NULL, NULL);
-         
-          offset = 0;
-         
-          for (i = 0; i <= extra; i++)
-            {
-              gint src_bpp, dest_bpp;
-         
-              src_bpp = babl_format_get_bytes_per_pixel (src_format);
-              dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
-         
-              iter = gegl_buffer_iterator_new (src_buf,
-                                               GEGL_RECTANGLE (0, 0, cols, rows),
-                                               0, NULL,
-                                               GEGL_BUFFER_READ,
-                                               GEGL_ABYSS_NONE);
-              gegl_buffer_iterator_add (iter, channel[i].buffer,
-                                        GEGL_RECTANGLE (x, y, cols, rows),
-                                        0, NULL,
-                                        GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
-         
-              while (gegl_buffer_iterator_next (iter))
-                {
-                  guchar *s = iter->data[0];
-                  guchar *d = iter->data[1];
-                  gint length = iter->length;
-         
-                  s += offset;
+          g_mutex_lock (&band_mutex);
 
-                  while (length--)
-                    {
-                      memcpy (d, s, dest_bpp);
-                      d += dest_bpp;
-                      s += src_bpp;
-                    }
-                }
-         
-              offset += dest_bpp;
-            }
+          while (band_jobs_left > 0)
+            g_cond_wait (&band_cond, &band_mutex);
 
-          g_object_unref (src_buf);
+          g_mutex_unlock (&band_mutex);
+        }
+      else
+        {
+          read_band_units (&jobs[0]);
         }
 
-      progress += one_row;
-    }
-}
+      for (i = 0; i < n_threads; i++)
+        {
+          report_band_job (&jobs[i]);
 
+          success = success && jobs[i].success;
+        }
 
-static void
-load_separate (TIFF         *tif,
-               channel_data *channel,
-               gushort       bps,
-               gushort       spp,
-               gint          extra)
-{
-  uint32  imageWidth, imageLength;
-  uint32  tileWidth, tileLength;
-  uint32  x, y, rows, cols;
-  int bytes_per_pixel;
-  GeglBuffer *src_buf;
-  const Babl *src_format;
-  GeglBufferIterator *iter;
-  guchar *buffer;
-  gdouble progress = 0.0, one_row;
-  gint    i;
+      if (! success)
+        g_message ("Failed to read rows %d to %d",
+                   band.y, band.y + band.rows - 1);
 
-  g_printerr ("%s\n", __func__);
+      write_band (&band, channel, extra);
 
-  TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &imageWidth);
-  TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &imageLength);
+      gimp_progress_update ((gdouble) (band.y + band.rows) /
+                            (gdouble) band.length);
+    }
 
-  tileWidth = imageWidth;
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
 
-  if (TIFFIsTiled (tif))
+  for (i = 0; i < n_threads; i++)
     {
-      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &tileWidth);
-      TIFFGetField (tif, TIFFTAG_TILELENGTH, &tileLength);
-      buffer = g_malloc (TIFFTileSize (tif));
+      if (jobs[i].tif != tif)
+        TIFFClose (jobs[i].tif);
+
+      g_free (jobs[i].buffer);
     }
-  else
+
+  g_free (jobs);
+
+  for (i = 0; i < n_planes; i++)
+    g_free (band.planes[i]);
+
+  g_free (band.planes);
+}
+
+/* Reads every n_jobs'th strip or tile of the band, starting at first */
+static void
+read_band_units (TiffBandJob *job)
+{
+  TiffBand *band      = job->band;
+  gint      n_across  = (band->width + band->unit_width - 1) / band->unit_width;
+  gint      n_down    = (band->rows + band->unit_length - 1) / band->unit_length;
+  gint      per_plane = n_across * n_down;
+  gint      n_units   = per_plane * band->n_planes;
+  gint      unit;
+
+  job->success = TRUE;
+
+  for (unit = job->first; unit < n_units; unit += job->n_jobs)
     {
-      tileWidth = imageWidth;
-      tileLength = 1;
-      buffer = g_malloc (TIFFScanlineSize (tif));
+      gint sample = unit / per_plane;
+      gint index  = unit % per_plane;
+
+      if (! job->buffer && job->buffer_size)
+        job->buffer = g_malloc (job->buffer_size);
+
+      if (! read_unit (band, job->tif, job->buffer, sample,
+                       (index % n_across) * band->unit_width,
+                       band->y + (index / n_across) * band->unit_length))
+        {
+          job->success = FALSE;
+        }
     }
+}
+
+/* Runs on the thread pool, and lets read_bands() know when it's done */
+static void
+read_band_job (TiffBandJob *job,
+               gpointer     user_data)
+{
+  g_private_set (&band_job_private, job);
 
-  one_row = (gdouble) tileLength / (gdouble) imageLength;
+  read_band_units (job);
 
-  if (bps <= 8)
-    src_format = babl_format_n (babl_type ("u8"), 1);
-  else
-    src_format = babl_format_n (babl_type ("u16"), 1);
+  g_private_set (&band_job_private, NULL);
 
-  /* consistency check */
-  bytes_per_pixel = 0;
-  for (i = 0; i <= extra; i++)
-    bytes_per_pixel += babl_format_get_bytes_per_pixel (channel[i].format);
+  g_mutex_lock (&band_mutex);
 
-  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel,
-              babl_format_get_bytes_per_pixel (src_format));
+  band_jobs_left--;
 
-  for (i = 0; i <= extra; i++)
-    {
-      gint src_bpp, dest_bpp;
-      gint n_comps, j, offset;
+  g_cond_signal (&band_cond);
+  g_mutex_unlock (&band_mutex);
+}
+
+/* Sends the messages libtiff gave while reading a job's part of the
+ * band, must only be called from the main thread.
+ */
+static void
+report_band_job (TiffBandJob *job)
+{
+  GSList *list;
+
+  for (list = job->messages; list; list = g_slist_next (list))
+    g_message ("%s", (const gchar *) list->data);
+
+  g_slist_free_full (job->messages, g_free);
+  job->messages = NULL;
+}
+
+/* Decodes the strip or tile of @sample at @x, @y into its band plane */
+static gboolean
+read_unit (TiffBand *band,
+           TIFF     *tif,
+           guchar   *buffer,
+           gint      sample,
+           uint32    x,
+           uint32    y)
+{
+  guchar *plane  = band->planes[sample];
+  gsize   stride = (gsize) band->width * band->bpp;
+  uint32  cols   = MIN (band->unit_width,  band->width  - x);
+  uint32  rows   = MIN (band->unit_length, band->length - y);
+  uint32  row;
+
+  plane += (y - band->y) * stride + x * band->bpp;
 
-      n_comps = babl_format_get_n_components (channel[i].format);
-      src_bpp = babl_format_get_bytes_per_pixel (src_format);
-      dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
+  if (band->mode == READ_RGBA)
+    {
+      uint32 height;
 
-      offset = 0;
-             
-      for (j = 0; j < n_comps; j++)
+      /* the RGBA interface returns the rows bottom-up, edge tiles
+       * are padded to full size
+       */
+      if (band->tiled)
         {
-          g_printerr ("i: %d, j: %d\n", i, j);
+          if (! TIFFReadRGBATile (tif, x, y, (uint32 *) buffer))
+            return FALSE;
 
-          for (y = 0; y < imageLength; y += tileLength)
-            {
-              for (x = 0; x < imageWidth; x += tileWidth)
-                {
-     
-                  gimp_progress_update (progress + one_row *
-                                        ( (gdouble) x / (gdouble) imageWidth));
-     
-                  /* that sample index is wrong */
-                  if (TIFFIsTiled (tif))
-                    TIFFReadTile (tif, buffer, x, y, 0, i+j);
-                  else
-                    TIFFReadScanline (tif, buffer, y, i+j);
-     
-                  cols = MIN (imageWidth - x, tileWidth);
-                  rows = MIN (imageLength - y, tileLength);
-     
-                  src_buf = gegl_buffer_linear_new_from_data (buffer,
-                                                              src_format,
-                                                              GEGL_RECTANGLE (0, 0, cols, rows),
-                                                              GEGL_AUTO_ROWSTRIDE,
-                                                              NULL, NULL);
-                 
-                  iter = gegl_buffer_iterator_new (src_buf,
-                                                   GEGL_RECTANGLE (0, 0, cols, rows),
-                                                   0, NULL,
-                                                   GEGL_BUFFER_READ,
-                                                   GEGL_ABYSS_NONE);
-                  gegl_buffer_iterator_add (iter, channel[i].buffer,
-                                            GEGL_RECTANGLE (x, y, cols, rows),
-                                            0, NULL,
-                                            GEGL_BUFFER_READWRITE,
-                                            GEGL_ABYSS_NONE);
-             
-                  while (gegl_buffer_iterator_next (iter))
-                    {
-                      guchar *s = iter->data[0];
-                      guchar *d = iter->data[1];
-                      gint length = iter->length;
-             
-                      d += offset;
-         
-                      while (length--)
-                        {
-                          memcpy (d, s, src_bpp);
-                          d += dest_bpp;
-                          s += src_bpp;
-                        }
-                    }
-             
-                  g_object_unref (src_buf);
-                }
-            }
+          height = band->unit_length;
+        }
+      else
+        {
+          if (! TIFFReadRGBAStrip (tif, y, (uint32 *) buffer))
+            return FALSE;
 
-          offset += src_bpp;
+          height = rows;
         }
 
-      progress += one_row;
+      for (row = 0; row < rows; row++)
+        memcpy (plane + row * stride,
+                buffer + (gsize) (height - row - 1) * band->unit_width * 4,
+                cols * 4);
+    }
+  else if (band->tiled)
+    {
+      if (TIFFReadEncodedTile (tif, TIFFComputeTile (tif, x, y, 0, sample),
+                               buffer, -1) < 0)
+        return FALSE;
+
+      for (row = 0; row < rows; row++)
+        memcpy (plane + row * stride,
+                buffer + (gsize) row * band->unit_width * band->bpp,
+                cols * band->bpp);
+    }
+  else
+    {
+      /* strips are as wide as the image, decode them in place */
+      if (TIFFReadEncodedStrip (tif, TIFFComputeStrip (tif, y, sample),
+                                plane, rows * stride) < 0)
+        return FALSE;
     }
-}
 
+  return TRUE;
+}
 
 /* Step through all <= 8-bit samples in an image */
 
@@ -76,6 +76,8 @@
 #define PLUG_IN_BINARY "file-tiff-save"
 #define PLUG_IN_ROLE   "gimp-file-tiff-save"
 
+#define TILE_SIZE      256  /* width and height of the tiles we write */
+
 
 typedef struct
 {
@@ -84,6 +86,34 @@ typedef struct
   gboolean  save_transp_pixels;
 } TiffSaveVals;
 
+typedef struct
+{
+  GByteArray *data;
+  toff_t      offset;
+} MemoryFile;
+
+typedef struct
+{
+  gushort  compression;
+  gshort   predictor;
+  gshort   photometric;
+  gshort   samplesperpixel;
+  gshort   bitspersample;
+} TileFormat;
+
+typedef struct
+{
+  const TileFormat *format;
+  ttile_t           tile;
+  guchar           *pixels;
+  tsize_t           size;
+  guchar           *encoded;
+  tsize_t           encoded_size;
+  GSList           *messages;   /*  libtiff messages, reported later  */
+  gboolean          done;
+  gboolean          success;
+} TileJob;
+
 typedef struct
 {
   gint32        ID;
@@ -129,10 +159,34 @@ static void      tiff_warning           (const gchar *module,
 static void      tiff_error             (const gchar *module,
                                          const gchar *fmt,
                                          va_list      ap);
+static void      tiff_log               (const gchar *fmt,
+                                         va_list      ap);
 static TIFF     *tiff_open              (const gchar *filename,
                                          const gchar *mode,
                                          GError     **error);
 
+static void      convert_row            (GimpImageType     drawable_type,
+                                         const guchar     *src,
+                                         guchar           *dest,
+                                         gint              cols,
+                                         gint              bytesperrow,
+                                         gboolean          is_bw,
+                                         gboolean          invert);
+static gboolean  write_tiles            (TIFF             *tif,
+                                         GThreadPool      *pool,
+                                         GQueue           *pending,
+                                         const TileFormat *format,
+                                         const guchar     *data,
+                                         gint              rowbytes,
+                                         gint              y,
+                                         gint              n_rows);
+static gboolean  write_pending_tile     (TIFF             *tif,
+                                         GQueue           *pending);
+static void      encode_tile            (TileJob          *job,
+                                         gpointer          user_data);
+static void      tile_job_report        (TileJob          *job);
+static void      tile_job_free          (TileJob          *job);
+
 const GimpPlugInInfo PLUG_IN_INFO =
 {
   NULL,  /* init_proc  */
@@ -150,6 +204,13 @@ static TiffSaveVals tsvals =
 static gchar       *image_comment = NULL;
 static GimpRunMode  run_mode      = GIMP_RUN_INTERACTIVE;
 
+/*  protects the done and success fields of all TileJobs  */
+static GMutex       tile_mutex;
+static GCond        tile_cond;
+
+/*  the TileJob compressed by the current thread, if any  */
+static GPrivate     tile_job_private;
+
 
 MAIN ()
 
@@ -232,6 +293,8 @@ run (const gchar      *name,
   *nreturn_vals = 1;
   *return_vals  = values;
 
+  gegl_init (NULL, NULL);
+
   values[0].type          = GIMP_PDB_STATUS;
   values[0].data.d_status = GIMP_PDB_EXECUTION_ERROR;
 
@@ -401,7 +464,7 @@ tiff_warning (const gchar *module,
         return;
     }
 
-  g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
+  tiff_log (fmt, ap);
 }
 
 static void
@@ -413,7 +476,25 @@ tiff_error (const gchar *module,
   /* Ignore the errors related to random access and JPEG compression */
   if (! strcmp (fmt, "Compression algorithm does not support random access"))
     return;
-  g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
+  tiff_log (fmt, ap);
+}
+
+/* The libtiff handlers are global, but messages must only be sent to
+ * the core from the main thread.  Messages about tiles compressed on
+ * the thread pool are kept in their TileJob, and reported when the
+ * tile is written.
+ */
+static void
+tiff_log (const gchar *fmt,
+          va_list      ap)
+{
+  TileJob *job = g_private_get (&tile_job_private);
+
+  if (job)
+    job->messages = g_slist_append (job->messages,
+                                    g_strdup_vprintf (fmt, ap));
+  else
+    g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, fmt, ap);
 }
 
 static TIFF *
@@ -664,8 +745,8 @@ save_image (const gchar  *filename,
   gushort        red[256];
   gushort        grn[256];
   gushort        blu[256];
-  gint           cols, col, rows, row, i;
-  glong          rowsperstrip;
+  const gchar   *mode = "w";
+  gint           cols, rows, row, i;
   gushort        compression;
   gushort        extra_samples[1];
   gboolean       alpha;
@@ -674,14 +755,18 @@ save_image (const gchar  *filename,
   gshort         samplesperpixel;
   gshort         bitspersample;
   gint           bytesperrow;
-  guchar        *t, *src, *data;
+  gint           rowbytes;
+  guchar        *src, *data;
   guchar        *cmap;
   gint           num_colors;
-  gint           success;
-  GimpDrawable  *drawable;
+  gboolean       success  = TRUE;
+  GeglBuffer    *buffer;
+  const Babl    *file_format = NULL;
   GimpImageType  drawable_type;
-  GimpPixelRgn   pixel_rgn;
-  gint           tile_height;
+  gboolean       tiled;
+  TileFormat     format;
+  GThreadPool   *pool     = NULL;
+  GQueue        *pending  = NULL;
   gint           y, yend;
   gboolean       is_bw    = FALSE;
   gboolean       invert   = TRUE;
@@ -698,35 +783,20 @@ save_image (const gchar  *filename,
 #endif
 
   predictor = 0;
-  tile_height = gimp_tile_height ();
-  rowsperstrip = tile_height;
-
-  tif = tiff_open (filename, "w", error);
-
-  if (! tif)
-    {
-      if (! error)
-        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
-                     _("Could not open '%s' for writing: %s"),
-                     gimp_filename_to_utf8 (filename), g_strerror (errno));
-      return FALSE;
-    }
-
-  TIFFSetWarningHandler (tiff_warning);
-  TIFFSetErrorHandler (tiff_error);
 
   gimp_progress_init_printf (_("Saving '%s'"),
                              gimp_filename_to_utf8 (filename));
 
-  drawable = gimp_drawable_get (layer);
   drawable_type = gimp_drawable_type (layer);
-  gimp_pixel_rgn_init (&pixel_rgn, drawable,
-                       0, 0, drawable->width, drawable->height, FALSE, FALSE);
 
-  cols = drawable->width;
-  rows = drawable->height;
+  cols = gimp_drawable_width (layer);
+  rows = gimp_drawable_height (layer);
 
-  gimp_tile_cache_ntiles (1 + drawable->width / gimp_tile_width ());
+  /* The fax codecs are only used with strips by most readers, everything
+   * else is written as tiles, which can be compressed in parallel.
+   */
+  tiled = (compression != COMPRESSION_CCITTFAX3 &&
+           compression != COMPRESSION_CCITTFAX4);
 
   switch (drawable_type)
     {
@@ -737,6 +807,7 @@ save_image (const gchar  *filename,
       photometric     = PHOTOMETRIC_RGB;
       bytesperrow     = cols * 3;
       alpha           = FALSE;
+      file_format     = babl_format ("R'G'B' u8");
       break;
 
     case GIMP_GRAY_IMAGE:
@@ -745,6 +816,7 @@ save_image (const gchar  *filename,
       photometric     = PHOTOMETRIC_MINISBLACK;
       bytesperrow     = cols;
       alpha           = FALSE;
+      file_format     = babl_format ("Y' u8");
       break;
 
     case GIMP_RGBA_IMAGE:
@@ -754,6 +826,7 @@ save_image (const gchar  *filename,
       photometric     = PHOTOMETRIC_RGB;
       bytesperrow     = cols * 4;
       alpha           = TRUE;
+      file_format     = babl_format ("R'G'B'A u8");
       break;
 
     case GIMP_GRAYA_IMAGE:
@@ -762,6 +835,7 @@ save_image (const gchar  *filename,
       photometric     = PHOTOMETRIC_MINISBLACK;
       bytesperrow     = cols * 2;
       alpha           = TRUE;
+      file_format     = babl_format ("Y'A u8");
       break;
 
     case GIMP_INDEXED_IMAGE:
@@ -801,6 +875,7 @@ save_image (const gchar  *filename,
       samplesperpixel = 1;
       bytesperrow     = cols;
       alpha           = FALSE;
+      file_format     = gimp_drawable_get_format (layer);
 
       g_free (cmap);
       break;
@@ -823,6 +898,28 @@ save_image (const gchar  *filename,
         }
     }
 
+  /* Classic TIFF uses 32 bit file offsets, switch to BigTIFF if the
+   * file might not fit, allowing for compression making the data larger.
+   */
+#ifdef TIFF_BIGTIFF_VERSION
+  if ((guint64) bytesperrow * rows / 2 * 3 > G_MAXUINT32 - 1024 * 1024)
+    mode = "w8";
+#endif
+
+  tif = tiff_open (filename, mode, error);
+
+  if (! tif)
+    {
+      if (! error)
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     _("Could not open '%s' for writing: %s"),
+                     gimp_filename_to_utf8 (filename), g_strerror (errno));
+      return FALSE;
+    }
+
+  TIFFSetWarningHandler (tiff_warning);
+  TIFFSetErrorHandler (tiff_error);
+
   /* Set TIFF parameters. */
   TIFFSetField (tif, TIFFTAG_SUBFILETYPE, 0);
   TIFFSetField (tif, TIFFTAG_IMAGEWIDTH, cols);
@@ -850,8 +947,17 @@ save_image (const gchar  *filename,
   TIFFSetField (tif, TIFFTAG_PHOTOMETRIC, photometric);
   TIFFSetField (tif, TIFFTAG_DOCUMENTNAME, filename);
   TIFFSetField (tif, TIFFTAG_SAMPLESPERPIXEL, samplesperpixel);
-  TIFFSetField (tif, TIFFTAG_ROWSPERSTRIP, rowsperstrip);
-  /* TIFFSetField( tif, TIFFTAG_STRIPBYTECOUNTS, rows / rowsperstrip ); */
+
+  if (tiled)
+    {
+      TIFFSetField (tif, TIFFTAG_TILEWIDTH, TILE_SIZE);
+      TIFFSetField (tif, TIFFTAG_TILELENGTH, TILE_SIZE);
+    }
+  else
+    {
+      TIFFSetField (tif, TIFFTAG_ROWSPERSTRIP, TILE_SIZE);
+    }
+
   TIFFSetField (tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
 
   /* resolution fields */
@@ -960,113 +1066,442 @@ save_image (const gchar  *filename,
   if (!is_bw && drawable_type == GIMP_INDEXED_IMAGE)
     TIFFSetField (tif, TIFFTAG_COLORMAP, red, grn, blu);
 
-  /* array to rearrange data */
-  src = g_new (guchar, bytesperrow * tile_height);
-  data = g_new (guchar, bytesperrow);
+  format.compression     = compression;
+  format.predictor       = 0;
+  format.photometric     = photometric;
+  format.samplesperpixel = samplesperpixel;
+  format.bitspersample   = bitspersample;
+
+  if ((compression == COMPRESSION_LZW || compression == COMPRESSION_DEFLATE)
+      && (predictor != 0))
+    {
+      format.predictor = predictor;
+    }
+
+  /* Only compressions without state shared between tiles can be done
+   * on other threads, JPEG for example writes shared tables.
+   */
+  if (tiled &&
+      (compression == COMPRESSION_LZW     ||
+       compression == COMPRESSION_DEFLATE ||
+       compression == COMPRESSION_PACKBITS))
+    {
+      gint n_threads = gimp_get_num_processors ();
+
+      if (n_threads > 1)
+        {
+          pool = g_thread_pool_new ((GFunc) encode_tile, NULL,
+                                    n_threads, FALSE, NULL);
+          pending = g_queue_new ();
+        }
+    }
+
+  if (is_bw)
+    rowbytes = (cols + 7) / 8;
+  else
+    rowbytes = bytesperrow;
+
+  buffer = gimp_drawable_get_buffer (layer);
+
+  /* arrays to rearrange data, one row of tiles at a time */
+  src  = g_new (guchar, bytesperrow * TILE_SIZE);
+  data = g_new (guchar, rowbytes * TILE_SIZE);
 
   /* Now write the TIFF data. */
-  for (y = 0; y < rows; y = yend)
+  for (y = 0; success && y < rows; y = yend)
     {
-      yend = y + tile_height;
+      yend = y + TILE_SIZE;
       yend = MIN (yend, rows);
 
-      gimp_pixel_rgn_get_rect (&pixel_rgn, src, 0, y, cols, yend - y);
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (0, y, cols, yend - y),
+                       1.0,
+                       file_format,
+                       src,
+                       GEGL_AUTO_ROWSTRIDE,
+                       GEGL_ABYSS_NONE);
 
       for (row = y; row < yend; row++)
+        convert_row (drawable_type,
+                     src  + bytesperrow * (row - y),
+                     data + rowbytes    * (row - y),
+                     cols, bytesperrow, is_bw, invert);
+
+      if (tiled)
+        {
+          success = write_tiles (tif, pool, pending, &format,
+                                 data, rowbytes, y, yend - y);
+        }
+      else
         {
-          t = src + bytesperrow * (row - y);
+          success = (TIFFWriteEncodedStrip (tif, TIFFComputeStrip (tif, y, 0),
+                                            data,
+                                            rowbytes * (yend - y)) >= 0);
+        }
 
-          switch (drawable_type)
-            {
-            case GIMP_INDEXED_IMAGE:
-              if (is_bw)
-                {
-                  byte2bit (t, bytesperrow, data, invert);
-                  success = (TIFFWriteScanline (tif, data, row, 0) >= 0);
-                }
-              else
-                {
-                  success = (TIFFWriteScanline (tif, t, row, 0) >= 0);
-                }
-              break;
+      if (! success)
+        g_message ("Failed a tile write on row %d", y);
 
-            case GIMP_GRAY_IMAGE:
-              success = (TIFFWriteScanline (tif, t, row, 0) >= 0);
-              break;
+      gimp_progress_update ((gdouble) yend / (gdouble) rows);
+    }
 
-            case GIMP_GRAYA_IMAGE:
-              for (col = 0; col < cols*samplesperpixel; col+=samplesperpixel)
-                {
-                  if (tsvals.save_transp_pixels)
-                    {
-                      data[col + 0] = t[col + 0];
-                    }
-                  else
-                    {
-                      /* pre-multiply gray by alpha */
-                      data[col + 0] = (t[col + 0] * t[col + 1]) / 255;
-                    }
-
-                  data[col + 1] = t[col + 1];  /* alpha channel */
-                }
+  if (pool)
+    {
+      while (success && ! g_queue_is_empty (pending))
+        {
+          success = write_pending_tile (tif, pending);
 
-              success = (TIFFWriteScanline (tif, data, row, 0) >= 0);
-              break;
+          if (! success)
+            g_message ("Failed a tile write");
+        }
 
-            case GIMP_RGB_IMAGE:
-              success = (TIFFWriteScanline (tif, t, row, 0) >= 0);
-              break;
+      g_thread_pool_free (pool, FALSE, TRUE);
 
-            case GIMP_RGBA_IMAGE:
-              for (col = 0; col < cols*samplesperpixel; col+=samplesperpixel)
-                {
-                  if (tsvals.save_transp_pixels)
-                    {
-                      data[col+0] = t[col + 0];
-                      data[col+1] = t[col + 1];
-                      data[col+2] = t[col + 2];
-                    }
-                  else
-                    {
-                      /* pre-multiply rgb by alpha */
-                      data[col+0] = t[col + 0] * t[col + 3] / 255;
-                      data[col+1] = t[col + 1] * t[col + 3] / 255;
-                      data[col+2] = t[col + 2] * t[col + 3] / 255;
-                    }
-
-                  data[col+3] = t[col + 3];  /* alpha channel */
-                }
+      g_queue_foreach (pending, (GFunc) tile_job_report, NULL);
+      g_queue_free_full (pending, (GDestroyNotify) tile_job_free);
+    }
 
-              success = (TIFFWriteScanline (tif, data, row, 0) >= 0);
-              break;
+  TIFFFlushData (tif);
+  TIFFClose (tif);
 
-            default:
-              success = FALSE;
-              break;
+  gimp_progress_update (1.0);
+
+  g_object_unref (buffer);
+  g_free (src);
+  g_free (data);
+
+  return success;
+}
+
+static void
+convert_row (GimpImageType  drawable_type,
+             const guchar  *src,
+             guchar        *dest,
+             gint           cols,
+             gint           bytesperrow,
+             gboolean       is_bw,
+             gboolean       invert)
+{
+  gint col;
+
+  switch (drawable_type)
+    {
+    case GIMP_INDEXED_IMAGE:
+      if (is_bw)
+        byte2bit (src, cols, dest, invert);
+      else
+        memcpy (dest, src, bytesperrow);
+      break;
+
+    case GIMP_GRAYA_IMAGE:
+      for (col = 0; col < bytesperrow; col += 2)
+        {
+          if (tsvals.save_transp_pixels)
+            {
+              dest[col + 0] = src[col + 0];
             }
+          else
+            {
+              /* pre-multiply gray by alpha */
+              dest[col + 0] = (src[col + 0] * src[col + 1]) / 255;
+            }
+
+          dest[col + 1] = src[col + 1];  /* alpha channel */
+        }
+      break;
 
-          if (!success)
+    case GIMP_RGBA_IMAGE:
+      for (col = 0; col < bytesperrow; col += 4)
+        {
+          if (tsvals.save_transp_pixels)
             {
-              g_message ("Failed a scanline write on row %d", row);
-              return FALSE;
+              dest[col + 0] = src[col + 0];
+              dest[col + 1] = src[col + 1];
+              dest[col + 2] = src[col + 2];
             }
+          else
+            {
+              /* pre-multiply rgb by alpha */
+              dest[col + 0] = src[col + 0] * src[col + 3] / 255;
+              dest[col + 1] = src[col + 1] * src[col + 3] / 255;
+              dest[col + 2] = src[col + 2] * src[col + 3] / 255;
+            }
+
+          dest[col + 3] = src[col + 3];  /* alpha channel */
         }
+      break;
 
-      if ((row % 32) == 0)
-        gimp_progress_update ((gdouble) row / (gdouble) rows);
+    default:
+      memcpy (dest, src, bytesperrow);
+      break;
     }
+}
 
-  TIFFFlushData (tif);
-  TIFFClose (tif);
+/* Cuts one row of tiles out of @n_rows rows of @data starting at row @y
+ * and writes them, compressing them on @pool if there is one. When
+ * compressing in parallel, the previous row of tiles is written while
+ * this one is being compressed.
+ */
+static gboolean
+write_tiles (TIFF             *tif,
+             GThreadPool      *pool,
+             GQueue           *pending,
+             const TileFormat *format,
+             const guchar     *data,
+             gint              rowbytes,
+             gint              y,
+             gint              n_rows)
+{
+  tsize_t tile_size     = TIFFTileSize (tif);
+  gint    tilebytes     = TIFFTileRowSize (tif);
+  gint    tiles_per_row = 0;
+  gint    x;
 
-  gimp_progress_update (1.0);
+  for (x = 0; x < rowbytes; x += tilebytes)
+    {
+      TileJob *job    = g_slice_new0 (TileJob);
+      gint     n_copy = MIN (tilebytes, rowbytes - x);
+      gint     row;
 
-  gimp_drawable_detach (drawable);
-  g_free (data);
+      job->format = format;
+      job->tile   = TIFFComputeTile (tif, x / tilebytes * TILE_SIZE, y, 0, 0);
+      job->size   = tile_size;
+      job->pixels = g_malloc0 (tile_size);
+
+      /*  the last tiles of a row or column are padded with zeros  */
+      for (row = 0; row < n_rows; row++)
+        memcpy (job->pixels + row * tilebytes,
+                data + row * rowbytes + x, n_copy);
+
+      tiles_per_row++;
+
+      if (pool)
+        {
+          g_queue_push_tail (pending, job);
+          g_thread_pool_push (pool, job, NULL);
+        }
+      else
+        {
+          gboolean success;
+
+          success = (TIFFWriteEncodedTile (tif, job->tile,
+                                           job->pixels, tile_size) >= 0);
+          tile_job_free (job);
+
+          if (! success)
+            return FALSE;
+        }
+    }
+
+  if (pool)
+    {
+      while (g_queue_get_length (pending) > tiles_per_row)
+        {
+          if (! write_pending_tile (tif, pending))
+            return FALSE;
+        }
+    }
 
   return TRUE;
 }
 
+/* Waits for the oldest tile in @pending to be compressed and writes it */
+static gboolean
+write_pending_tile (TIFF   *tif,
+                    GQueue *pending)
+{
+  TileJob  *job = g_queue_pop_head (pending);
+  gboolean  success;
+
+  g_mutex_lock (&tile_mutex);
+
+  while (! job->done)
+    g_cond_wait (&tile_cond, &tile_mutex);
+
+  g_mutex_unlock (&tile_mutex);
+
+  tile_job_report (job);
+
+  success = (job->success &&
+             TIFFWriteRawTile (tif, job->tile,
+                               job->encoded, job->encoded_size) >= 0);
+
+  tile_job_free (job);
+
+  return success;
+}
+
+static tsize_t
+memory_file_read (thandle_t handle,
+                  tdata_t   buffer,
+                  tsize_t   size)
+{
+  return 0;
+}
+
+static tsize_t
+memory_file_write (thandle_t handle,
+                   tdata_t   buffer,
+                   tsize_t   size)
+{
+  MemoryFile *file = (MemoryFile *) handle;
+
+  if (file->offset + size > file->data->len)
+    g_byte_array_set_size (file->data, file->offset + size);
+
+  memcpy (file->data->data + file->offset, buffer, size);
+  file->offset += size;
+
+  return size;
+}
+
+static toff_t
+memory_file_seek (thandle_t handle,
+                  toff_t    offset,
+                  gint      whence)
+{
+  MemoryFile *file = (MemoryFile *) handle;
+
+  switch (whence)
+    {
+    case SEEK_SET:
+      file->offset = offset;
+      break;
+
+    case SEEK_CUR:
+      file->offset += offset;
+      break;
+
+    case SEEK_END:
+      file->offset = file->data->len + offset;
+      break;
+    }
+
+  return file->offset;
+}
+
+static gint
+memory_file_close (thandle_t handle)
+{
+  return 0;
+}
+
+static toff_t
+memory_file_size (thandle_t handle)
+{
+  MemoryFile *file = (MemoryFile *) handle;
+
+  return file->data->len;
+}
+
+static gint
+memory_file_map (thandle_t  handle,
+                 tdata_t   *base,
+                 toff_t    *size)
+{
+  return 0;
+}
+
+static void
+memory_file_unmap (thandle_t handle,
+                   tdata_t   base,
+                   toff_t    size)
+{
+}
+
+/* Runs on the thread pool. Compresses a tile by writing it as the only
+ * tile of a TIFF in memory, and keeps the compressed data so it can be
+ * copied to the real file with TIFFWriteRawTile().
+ */
+static void
+encode_tile (TileJob  *job,
+             gpointer  user_data)
+{
+  const TileFormat *format  = job->format;
+  MemoryFile        file    = { g_byte_array_new (), 0 };
+  gboolean          success = FALSE;
+  TIFF             *tif;
+
+  g_private_set (&tile_job_private, job);
+
+  tif = TIFFClientOpen ("tile", "w", (thandle_t) &file,
+                        memory_file_read, memory_file_write,
+                        memory_file_seek, memory_file_close,
+                        memory_file_size,
+                        memory_file_map, memory_file_unmap);
+
+  if (tif)
+    {
+      guint start;
+
+      TIFFSetField (tif, TIFFTAG_IMAGEWIDTH, TILE_SIZE);
+      TIFFSetField (tif, TIFFTAG_IMAGELENGTH, TILE_SIZE);
+      TIFFSetField (tif, TIFFTAG_TILEWIDTH, TILE_SIZE);
+      TIFFSetField (tif, TIFFTAG_TILELENGTH, TILE_SIZE);
+      TIFFSetField (tif, TIFFTAG_BITSPERSAMPLE, format->bitspersample);
+      TIFFSetField (tif, TIFFTAG_SAMPLESPERPIXEL, format->samplesperpixel);
+      TIFFSetField (tif, TIFFTAG_PHOTOMETRIC, format->photometric);
+      TIFFSetField (tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+      TIFFSetField (tif, TIFFTAG_COMPRESSION, format->compression);
+
+      if (format->predictor != 0)
+        TIFFSetField (tif, TIFFTAG_PREDICTOR, format->predictor);
+
+      /*  everything written from here on is the tile's data  */
+      start = file.data->len;
+
+      if (TIFFWriteEncodedTile (tif, 0, job->pixels, job->size) >= 0)
+        {
+          job->encoded_size = file.data->len - start;
+          job->encoded      = g_memdup (file.data->data + start,
+                                        job->encoded_size);
+          success = TRUE;
+        }
+
+      TIFFClose (tif);
+    }
+
+  g_byte_array_free (file.data, TRUE);
+
+  g_free (job->pixels);
+  job->pixels = NULL;
+
+  g_private_set (&tile_job_private, NULL);
+
+  g_mutex_lock (&tile_mutex);
+
+  job->success = success;
+  job->done    = TRUE;
+
+  g_cond_broadcast (&tile_cond);
+  g_mutex_unlock (&tile_mutex);
+}
+
+/* Sends the messages libtiff gave while compressing a tile, must
+ * only be called from the main thread.
+ */
+static void
+tile_job_report (TileJob *job)
+{
+  GSList *list;
+
+  for (list = job->messages; list; list = g_slist_next (list))
+    g_message ("%s", (const gchar *) list->data);
+
+  g_slist_free_full (job->messages, g_free);
+  job->messages = NULL;
+}
+
+static void
+tile_job_free (TileJob *job)
+{
+  g_free (job->pixels);
+  g_free (job->encoded);
+  g_slist_free_full (job->messages, g_free);
+
+  g_slice_free (TileJob, job);
+}
+
 static gboolean
 save_dialog (gboolean has_alpha,
              gboolean is_monochrome)
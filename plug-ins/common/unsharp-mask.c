@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
@@ -34,6 +35,8 @@
 #define SCALE_WIDTH   120
 #define ENTRY_WIDTH     5
 
+#define UNSHARP_GROUP  16  /* columns transposed together */
+
 /* Uncomment this line to get a rough estimate of how long the plug-in
  * takes to run.
  */
@@ -53,6 +56,33 @@ typedef struct
   gboolean  run;
 } UnsharpMaskInterface;
 
+typedef struct
+{
+  gboolean       box_blur;
+  gint           box_width;
+  const gdouble *cmatrix;
+  gint           cmatrix_length;
+  gint           bpp;
+  gdouble        amount;
+  gint           threshold;
+} UnsharpBlur;
+
+typedef struct
+{
+  const UnsharpBlur *blur;
+  gboolean           vertical;    /* the lines are the columns of the block */
+  const guchar      *src;
+  gint               src_stride;  /* in pixels */
+  guchar            *dest;
+  const guchar      *orig;        /* unblurred pixels, for the vertical pass */
+  gint               dest_stride; /* in pixels, also for orig */
+  gint               length;      /* length of a line, in pixels */
+  gint               offset;      /* first pixel of each line to keep */
+  gint               n_pixels;    /* number of pixels of each line to keep */
+  gint               first;
+  gint               n_lines;
+} UnsharpJob;
+
 /* local function prototypes */
 static void      query (void);
 static void      run   (const gchar      *name,
@@ -84,7 +114,22 @@ static void      unsharp_region      (GimpPixelRgn   *srcPTR,
                                       gint            x2,
                                       gint            y1,
                                       gint            y2,
+                                      gint            dest_x,
+                                      gint            dest_y,
+                                      gint            dest_width,
+                                      gint            dest_height,
                                       gboolean        show_progress);
+static void      blur_line           (const UnsharpBlur *blur,
+                                      guchar         *src,
+                                      guchar         *dest,
+                                      gint            len);
+static void      unsharp_pass        (GThreadPool    *pool,
+                                      GAsyncQueue    *done,
+                                      UnsharpJob     *jobs,
+                                      gint            n_jobs,
+                                      const UnsharpJob *job);
+static void      unsharp_lines       (UnsharpJob     *job,
+                                      gpointer        user_data);
 
 static void      unsharp_mask        (GimpDrawable   *drawable,
                                       gdouble         radius,
@@ -542,6 +587,7 @@ unsharp_mask (GimpDrawable *drawable,
   unsharp_region (&srcPR, &destPR, drawable->bpp,
                   radius, amount,
                   x1, x2, y1, y2,
+                  x1, y1, x2 - x1, y2 - y1,
                   TRUE);
 
   gimp_drawable_flush (drawable);
@@ -549,9 +595,190 @@ unsharp_mask (GimpDrawable *drawable,
   gimp_drawable_update (drawable->drawable_id, x1, y1, x2 - x1, y2 - y1);
 }
 
+/* Blurs one line of pixels, as a three pass box blur or a gaussian
+ * blur.  The result is in dest, src is modified.
+ */
+static void
+blur_line (const UnsharpBlur *blur,
+           guchar            *src,
+           guchar            *dest,
+           gint               len)
+{
+  gint bpp = blur->bpp;
+
+  if (blur->box_blur)
+    {
+      gint box_width = blur->box_width;
+
+      /* Odd-width box blur: repeat 3 times, centered on output pixel.
+       * Swap back and forth between the buffers. */
+      if (box_width % 2)
+        {
+          box_blur_line (box_width, 0, src, dest, len, bpp);
+          box_blur_line (box_width, 0, dest, src, len, bpp);
+          box_blur_line (box_width, 0, src, dest, len, bpp);
+        }
+      /* Even-width box blur:
+       * This method is suggested by the specification for SVG.
+       * One pass with width n, centered between output and right pixel
+       * One pass with width n, centered between output and left pixel
+       * One pass with width n+1, centered on output pixel
+       * Swap back and forth between buffers.
+       */
+      else
+        {
+          box_blur_line (box_width,  -1, src, dest, len, bpp);
+          box_blur_line (box_width,   1, dest, src, len, bpp);
+          box_blur_line (box_width+1, 0, src, dest, len, bpp);
+        }
+    }
+  else
+    {
+      /* Gaussian blur */
+      gaussian_blur_line (blur->cmatrix, blur->cmatrix_length,
+                          src, dest, len, bpp);
+    }
+}
+
+/* Blurs the lines of a job.  The lines are copied to contiguous
+ * buffers first, columns are transposed UNSHARP_GROUP at a time so
+ * the reads stay within the same rows of the block.  The columns
+ * of the vertical pass are merged with the unblurred pixels as they
+ * are written back.  On the thread pool, user_data is the queue the
+ * finished job is pushed to.
+ */
+static void
+unsharp_lines (UnsharpJob *job,
+               gpointer    user_data)
+{
+  const UnsharpBlur *blur      = job->blur;
+  gint               bpp       = blur->bpp;
+  gint               length    = job->length;
+  gsize              line_size = (gsize) length * bpp;
+  guchar            *lines_src;
+  guchar            *lines_dest;
+  gint               line;
+  gint               g, i, v;
+
+  lines_src  = g_new (guchar, UNSHARP_GROUP * line_size);
+  lines_dest = g_new (guchar, UNSHARP_GROUP * line_size);
+
+  for (line = job->first;
+       line < job->first + job->n_lines;
+       line += UNSHARP_GROUP)
+    {
+      gint n_group = MIN (UNSHARP_GROUP, job->first + job->n_lines - line);
+
+      if (job->vertical)
+        {
+          for (i = 0; i < length; i++)
+            {
+              const guchar *s = job->src + ((gsize) i * job->src_stride + line) * bpp;
+
+              for (g = 0; g < n_group; g++)
+                memcpy (lines_src + g * line_size + i * bpp,
+                        s + g * bpp, bpp);
+            }
+        }
+      else
+        {
+          for (g = 0; g < n_group; g++)
+            memcpy (lines_src + g * line_size,
+                    job->src + (gsize) (line + g) * job->src_stride * bpp,
+                    line_size);
+        }
+
+      for (g = 0; g < n_group; g++)
+        blur_line (blur,
+                   lines_src + g * line_size, lines_dest + g * line_size,
+                   length);
+
+      if (job->vertical)
+        {
+          /* merge the source and the blurred version */
+          for (i = 0; i < job->n_pixels; i++)
+            {
+              gsize         index = ((gsize) i * job->dest_stride + line) * bpp;
+              const guchar *s     = job->orig + index;
+              guchar       *d     = job->dest + index;
+
+              for (g = 0; g < n_group; g++)
+                {
+                  const guchar *b = (lines_dest + g * line_size +
+                                     (job->offset + i) * bpp);
+
+                  for (v = 0; v < bpp; v++)
+                    {
+                      gint value;
+                      gint diff = *s - *b++;
+
+                      /* do tresholding */
+                      if (abs (2 * diff) < blur->threshold)
+                        diff = 0;
+
+                      value = *s++ + blur->amount * diff;
+                      *d++ = CLAMP (value, 0, 255);
+                    }
+                }
+            }
+        }
+      else
+        {
+          for (g = 0; g < n_group; g++)
+            memcpy (job->dest + (gsize) (line + g) * job->dest_stride * bpp,
+                    lines_dest + g * line_size + job->offset * bpp,
+                    (gsize) job->n_pixels * bpp);
+        }
+    }
+
+  g_free (lines_src);
+  g_free (lines_dest);
+
+  if (user_data)
+    g_async_queue_push (user_data, job);
+}
+
+/* Splits the lines of a band or block among n_jobs jobs.  The other
+ * jobs run on pool while this thread blurs the first one, then the
+ * finished jobs are waited for on done.
+ */
+static void
+unsharp_pass (GThreadPool      *pool,
+              GAsyncQueue      *done,
+              UnsharpJob       *jobs,
+              gint              n_jobs,
+              const UnsharpJob *job)
+{
+  gint i;
+
+  n_jobs = MIN (n_jobs, job->n_lines);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i]         = *job;
+      jobs[i].first   = job->n_lines * i / n_jobs;
+      jobs[i].n_lines = job->n_lines * (i + 1) / n_jobs - jobs[i].first;
+    }
+
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (pool, &jobs[i], NULL);
+
+  unsharp_lines (&jobs[0], NULL);
+
+  for (i = 1; i < n_jobs; i++)
+    g_async_queue_pop (done);
+}
+
 /* Perform an unsharp mask on the region, given a source region, dest.
  * region, width and height of the regions, and corner coordinates of
- * a subregion to act upon.  Everything outside the subregion is unaffected.
+ * a subregion to act upon.  Only the dest_x, dest_y, dest_width,
+ * dest_height part of the subregion is written, which must lie
+ * within it.  Everything outside that part is unaffected.
+ *
+ * The rows are blurred in bands of tiles into the shadow, then the
+ * columns are blurred in blocks of tiles and merged with the source.
+ * The lines of each band or block are blurred in parallel, on a
+ * thread pool shared by both passes.
  */
 static void
 unsharp_region (GimpPixelRgn *srcPR,
@@ -563,19 +790,27 @@ unsharp_region (GimpPixelRgn *srcPR,
                 gint          x2,
                 gint          y1,
                 gint          y2,
+                gint          dest_x,
+                gint          dest_y,
+                gint          dest_width,
+                gint          dest_height,
                 gboolean      show_progress)
 {
-  guchar     *src;                /* Temporary copy of source row/col      */
-  guchar     *dest;               /* Temporary copy of destination row/col */
-  const gint  width   = x2 - x1;
-  const gint  height  = y2 - y1;
-  gdouble    *cmatrix = NULL;     /* Convolution matrix (for gaussian)     */
-  gint        cmatrix_length = 0;
-  gint        row, col;           /* Row, column counters                  */
-  const gint  threshold = unsharp_params.threshold;
-  gboolean    box_blur;           /* If we want to use a three pass box
-                                     blur instead of a gaussian blur       */
-  gint        box_width = 0;
+  const gint   width   = x2 - x1;
+  const gint   height  = y2 - y1;
+  gdouble     *cmatrix = NULL;     /* Convolution matrix (for gaussian)     */
+  UnsharpBlur  blur    = { 0, };
+  UnsharpJob   job     = { 0, };
+  UnsharpJob  *jobs;
+  GThreadPool *pool    = NULL;
+  GAsyncQueue *done    = NULL;
+  guchar      *src;
+  guchar      *dest;
+  guchar      *orig;
+  gint         n_threads;
+  gint         band_height;
+  gint         block_width;
+  gint         row, col;           /* Row, column counters                  */
 
   if (show_progress)
     gimp_progress_init (_("Blurring"));
@@ -588,140 +823,113 @@ unsharp_region (GimpPixelRgn *srcPR,
    */
   if (radius < 10)
     {
-      box_blur = FALSE;
+      blur.box_blur = FALSE;
       /* If true gaussian, generate convolution matrix
          and make sure it's smaller than each dimension */
-      cmatrix_length = gen_convolve_matrix (radius, &cmatrix);
+      blur.cmatrix_length = gen_convolve_matrix (radius, &cmatrix);
+      blur.cmatrix        = cmatrix;
     }
   else
     {
-      box_blur = TRUE;
+      blur.box_blur = TRUE;
       /* Three box blurs of this width approximate a gaussian */
-      box_width = ROUND (radius * 3 * sqrt (2 * G_PI) / 4);
+      blur.box_width = ROUND (radius * 3 * sqrt (2 * G_PI) / 4);
     }
 
-  /* Allocate buffers temporary copies of a row/column */
-  src  = g_new (guchar, MAX (width, height) * bpp);
-  dest = g_new (guchar, MAX (width, height) * bpp);
+  blur.bpp       = bpp;
+  blur.amount    = amount;
+  blur.threshold = unsharp_params.threshold;
+
+  n_threads   = gimp_get_num_processors ();
+  band_height = MAX (1, MIN (gimp_tile_height () * n_threads, height));
+  block_width = MAX (1, MIN (gimp_tile_width () * n_threads, dest_width));
+
+  jobs = g_new (UnsharpJob, n_threads);
 
-  /* Blur the rows */
-  for (row = 0; row < height; row++)
+  if (n_threads > 1)
     {
-      gimp_pixel_rgn_get_row (srcPR, src, x1, y1 + row, width);
+      done = g_async_queue_new ();
+      pool = g_thread_pool_new ((GFunc) unsharp_lines, done,
+                                n_threads - 1, FALSE, NULL);
+    }
 
-      if (box_blur)
-        {
-          /* Odd-width box blur: repeat 3 times, centered on output pixel.
-           * Swap back and forth between the buffers. */
-          if (box_width % 2)
-            {
-              box_blur_line (box_width, 0, src, dest, width, bpp);
-              box_blur_line (box_width, 0, dest, src, width, bpp);
-              box_blur_line (box_width, 0, src, dest, width, bpp);
-            }
-          /* Even-width box blur:
-           * This method is suggested by the specification for SVG.
-           * One pass with width n, centered between output and right pixel
-           * One pass with width n, centered between output and left pixel
-           * One pass with width n+1, centered on output pixel
-           * Swap back and forth between buffers.
-           */
-          else
-            {
-              box_blur_line (box_width,  -1, src, dest, width, bpp);
-              box_blur_line (box_width,   1, dest, src, width, bpp);
-              box_blur_line (box_width+1, 0, src, dest, width, bpp);
-            }
-        }
-      else
-        {
-          /* Gaussian blur */
-          gaussian_blur_line (cmatrix, cmatrix_length, src, dest, width, bpp);
-        }
+  job.blur = &blur;
 
-      gimp_pixel_rgn_set_row (destPR, dest, x1, y1 + row, width);
+  /* Blur the rows, keeping only the columns of the dest area */
+  src  = g_new (guchar, (gsize) width * band_height * bpp);
+  dest = g_new (guchar, (gsize) dest_width * band_height * bpp);
 
-      if (show_progress && row % 64 == 0)
-        gimp_progress_update ((gdouble) row / (3 * height));
-    }
+  job.vertical    = FALSE;
+  job.src         = src;
+  job.src_stride  = width;
+  job.dest        = dest;
+  job.dest_stride = dest_width;
+  job.length      = width;
+  job.offset      = dest_x - x1;
+  job.n_pixels    = dest_width;
 
-  /* Blur the cols. Essentially same as above. */
-  for (col = 0; col < width; col++)
+  for (row = 0; row < height; row += band_height)
     {
-      gimp_pixel_rgn_get_col (destPR, src, x1 + col, y1, height);
+      gint h = MIN (band_height, height - row);
 
-      if (box_blur)
-        {
-          /* Odd-width box blur */
-          if (box_width % 2)
-            {
-              box_blur_line (box_width, 0, src, dest, height, bpp);
-              box_blur_line (box_width, 0, dest, src, height, bpp);
-              box_blur_line (box_width, 0, src, dest, height, bpp);
-            }
-          /* Even-width box blur */
-          else
-            {
-              box_blur_line (box_width,  -1, src, dest, height, bpp);
-              box_blur_line (box_width,   1, dest, src, height, bpp);
-              box_blur_line (box_width+1, 0, src, dest, height, bpp);
-            }
-        }
-      else
-        {
-          /* Gaussian blur */
-          gaussian_blur_line (cmatrix, cmatrix_length, src, dest,height, bpp);
-        }
+      gimp_pixel_rgn_get_rect (srcPR, src, x1, y1 + row, width, h);
 
-      gimp_pixel_rgn_set_col (destPR, dest, x1 + col, y1, height);
+      job.n_lines = h;
+      unsharp_pass (pool, done, jobs, n_threads, &job);
 
-      if (show_progress && col % 64 == 0)
-        gimp_progress_update ((gdouble) col / (3 * width) + 0.33);
-    }
+      gimp_pixel_rgn_set_rect (destPR, dest, dest_x, y1 + row, dest_width, h);
 
-  if (show_progress)
-    gimp_progress_set_text (_("Merging"));
+      if (show_progress)
+        gimp_progress_update ((gdouble) (row + h) / (2 * height));
+    }
 
-  /* merge the source and destination (which currently contains
-     the blurred version) images */
-  for (row = 0; row < height; row++)
-    {
-      const guchar *s = src;
-      guchar       *d = dest;
-      gint          u, v;
+  g_free (dest);
+  g_free (src);
 
-      /* get source row */
-      gimp_pixel_rgn_get_row (srcPR, src, x1, y1 + row, width);
+  /* Blur the cols of the dest area, and merge them with the source */
+  src  = g_new (guchar, (gsize) block_width * height * bpp);
+  dest = g_new (guchar, (gsize) block_width * dest_height * bpp);
+  orig = g_new (guchar, (gsize) block_width * dest_height * bpp);
 
-      /* get dest row */
-      gimp_pixel_rgn_get_row (destPR, dest, x1, y1 + row, width);
+  job.vertical    = TRUE;
+  job.src         = src;
+  job.dest        = dest;
+  job.orig        = orig;
+  job.length      = height;
+  job.offset      = dest_y - y1;
+  job.n_pixels    = dest_height;
 
-      /* combine the two */
-      for (u = 0; u < width; u++)
-        {
-          for (v = 0; v < bpp; v++)
-            {
-              gint value;
-              gint diff = *s - *d;
+  for (col = 0; col < dest_width; col += block_width)
+    {
+      gint w = MIN (block_width, dest_width - col);
 
-              /* do tresholding */
-              if (abs (2 * diff) < threshold)
-                diff = 0;
+      gimp_pixel_rgn_get_rect (destPR, src, dest_x + col, y1, w, height);
+      gimp_pixel_rgn_get_rect (srcPR, orig, dest_x + col, dest_y,
+                               w, dest_height);
 
-              value = *s++ + amount * diff;
-              *d++ = CLAMP (value, 0, 255);
-            }
-        }
+      job.src_stride  = w;
+      job.dest_stride = w;
+      job.n_lines     = w;
+      unsharp_pass (pool, done, jobs, n_threads, &job);
 
-      if (show_progress && row % 64 == 0)
-        gimp_progress_update ((gdouble) row / (3 * height) + 0.67);
+      gimp_pixel_rgn_set_rect (destPR, dest, dest_x + col, dest_y,
+                               w, dest_height);
 
-      gimp_pixel_rgn_set_row (destPR, dest, x1, y1 + row, width);
+      if (show_progress)
+        gimp_progress_update ((gdouble) (col + w) / (2 * dest_width) + 0.5);
     }
 
   if (show_progress)
     gimp_progress_update (1.0);
 
+  if (pool)
+    {
+      g_thread_pool_free (pool, FALSE, TRUE);
+      g_async_queue_unref (done);
+    }
+
+  g_free (jobs);
+  g_free (orig);
   g_free (dest);
   g_free (src);
   g_free (cmatrix);
@@ -939,9 +1147,11 @@ preview_update (GimpPreview *preview)
   x2 = MIN (x + width  + border, drawable->width);
   y2 = MIN (y + height + border, drawable->height);
 
+  /* only the visible part of the enlarged region is computed */
   unsharp_region (&srcPR, &destPR, drawable->bpp,
                   unsharp_params.radius, unsharp_params.amount,
                   x1, x2, y1, y2,
+                  x, y, width, height,
                   FALSE);
 
   gimp_pixel_rgn_init (&destPR, drawable, x, y, width, height, FALSE, TRUE);
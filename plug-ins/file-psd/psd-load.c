@@ -38,6 +38,20 @@
 #define COMP_MODE_SIZE sizeof(guint16)
 
 
+/*  A band of rows of a layer, decoded from all its channels  */
+typedef struct
+{
+  PSDchannel  **channels;               /* Channels in pixel order */
+  gint          n_channels;
+  guint16       bps;
+  gint32        y;
+  gint32        rows;
+  gint32        columns;
+  guchar       *pixels;
+  gboolean      done;
+} PSDband;
+
+
 /*  Local function prototypes  */
 static gint             read_header_block          (PSDimage     *img_a,
                                                     FILE         *f,
@@ -74,6 +88,7 @@ static gint             add_layers                 (const gint32  image_id,
                                                     PSDimage     *img_a,
                                                     PSDlayer    **lyr_a,
                                                     FILE         *f,
+                                                    GMappedFile  *mapped_file,
                                                     GError      **error);
 
 static gint             add_merged_image           (const gint32  image_id,
@@ -96,6 +111,29 @@ static gint             read_channel_data          (PSDchannel     *channel,
                                                     FILE           *f,
                                                     GError        **error);
 
+static gint             setup_channel_rows         (PSDchannel     *channel,
+                                                    const guint16   bps,
+                                                    const guchar   *data,
+                                                    guint32         data_len,
+                                                    GError        **error);
+
+static void             decode_channel_rows        (const PSDchannel *channel,
+                                                    const guint16     bps,
+                                                    gint32            first_row,
+                                                    gint32            n_rows,
+                                                    guchar           *dest,
+                                                    gint              dest_bpp);
+
+static void             decode_band                (PSDband        *band,
+                                                    gpointer        user_data);
+
+static void             write_layer_bands          (GimpDrawable   *drawable,
+                                                    PSDchannel    **channels,
+                                                    gint            n_channels,
+                                                    const guint16   bps,
+                                                    GThreadPool    *pool);
+
+
 static void             convert_16_bit             (const gchar *src,
                                                     gchar       *dst,
                                                     guint32      len);
@@ -106,12 +144,18 @@ static void             convert_1_bit              (const gchar *src,
                                                     guint32      columns);
 
 
+/*  protects the done field of all PSDbands  */
+static GMutex band_mutex;
+static GCond  band_cond;
+
+
 /* Main file load function */
 gint32
 load_image (const gchar  *filename,
             GError      **load_error)
 {
   FILE                 *f;
+  GMappedFile          *mapped_file = NULL;
   struct stat           st;
   PSDimage              img_a;
   PSDlayer            **lyr_a;
@@ -187,7 +231,20 @@ load_image (const gchar  *filename,
 
   /* ----- Add layers -----*/
   IFDBG(2) g_debug ("Add layers");
-  if (add_layers (image_id, &img_a, lyr_a, f, &error) < 0)
+  if (img_a.num_layers > 0)
+    {
+      /* Layer pixel data is decoded straight from the mapped file.
+       * If the file can't be mapped, for example because it is larger
+       * than the address space, the channels are read from the stream.
+       */
+      mapped_file = g_mapped_file_new (filename, FALSE, &error);
+      if (! mapped_file)
+        {
+          IFDBG(1) g_debug ("Could not map file: %s", error->message);
+          g_clear_error (&error);
+        }
+    }
+  if (add_layers (image_id, &img_a, lyr_a, f, mapped_file, &error) < 0)
     goto load_error;
   gimp_progress_update (0.9);
 
@@ -203,6 +260,8 @@ load_image (const gchar  *filename,
 
   gimp_image_clean_all (image_id);
   gimp_image_undo_enable (image_id);
+  if (mapped_file)
+    g_mapped_file_unref (mapped_file);
   fclose (f);
   return image_id;
 
@@ -219,6 +278,9 @@ load_image (const gchar  *filename,
   if (image_id > 0)
     gimp_image_delete (image_id);
 
+  if (mapped_file)
+    g_mapped_file_unref (mapped_file);
+
   /* Close file if Open */
   if (! (f == NULL))
     fclose (f);
@@ -1010,9 +1072,11 @@ add_layers (const gint32  image_id,
             PSDimage     *img_a,
             PSDlayer    **lyr_a,
             FILE         *f,
+            GMappedFile  *mapped_file,
             GError      **error)
 {
   PSDchannel          **lyr_chn;
+  PSDchannel           *layer_chn[MAX_CHANNELS];
   GArray               *parent_group_stack;
   gint32                parent_group_id = -1;
   guchar               *pixels;
@@ -1020,7 +1084,11 @@ add_layers (const gint32  image_id,
   guint16               user_mask_chn;
   guint16               layer_channels;
   guint16               channel_idx[MAX_CHANNELS];
-  guint16              *rle_pack_len;
+  const guchar         *file_data = NULL;
+  gsize                 file_len = 0;
+  gsize                 offset;
+  GThreadPool          *pool = NULL;
+  gint                  n_threads;
   gint32                l_x;                   /* Layer x */
   gint32                l_y;                   /* Layer y */
   gint32                l_w;                   /* Layer width */
@@ -1056,11 +1124,19 @@ add_layers (const gint32  image_id,
     }
 
   /* Layered image - Photoshop 3 style */
-  if (fseek (f, img_a->layer_data_start, SEEK_SET) < 0)
+  if (mapped_file)
     {
-      psd_set_error (feof (f), errno, error);
-      return -1;
+      file_data = (const guchar *) g_mapped_file_get_contents (mapped_file);
+      file_len = g_mapped_file_get_length (mapped_file);
     }
+  offset = img_a->layer_data_start;
+
+  /* Layer bands are decoded on worker threads while the main thread
+     sends the previous bands to the core */
+  n_threads = gimp_get_num_processors ();
+  if (n_threads > 1)
+    pool = g_thread_pool_new ((GFunc) decode_band, NULL,
+                              n_threads, FALSE, NULL);
 
   /* set the root of the group hierarchy */
   parent_group_stack = g_array_new (FALSE, FALSE, sizeof(gint32));
@@ -1076,13 +1152,7 @@ add_layers (const gint32  image_id,
 
           /* Step past layer data */
           for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
-            {
-              if (fseek (f, lyr_a[lidx]->chn_info[cidx].data_len, SEEK_CUR) < 0)
-                {
-                  psd_set_error (feof (f), errno, error);
-                  return -1;
-                }
-            }
+            offset += lyr_a[lidx]->chn_info[cidx].data_len;
           g_free (lyr_a[lidx]->chn_info);
           g_free (lyr_a[lidx]->name);
         }
@@ -1129,13 +1199,11 @@ add_layers (const gint32  image_id,
           /* Load layer channel data */
           IFDBG(2) g_debug ("Number of channels: %d", lyr_a[lidx]->num_channels);
           /* Create pointer array for the channel records */
-          lyr_chn = g_new (PSDchannel *, lyr_a[lidx]->num_channels);
+          lyr_chn = g_new0 (PSDchannel *, lyr_a[lidx]->num_channels);
           for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
             {
-              guint16 comp_mode = PSD_COMP_RAW;
-
               /* Allocate channel record */
-              lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
+              lyr_chn[cidx] = g_new0 (PSDchannel, 1);
 
               lyr_chn[cidx]->id = lyr_a[lidx]->chn_info[cidx].channel_id;
               lyr_chn[cidx]->rows = lyr_a[lidx]->bottom - lyr_a[lidx]->top;
@@ -1171,68 +1239,46 @@ add_layers (const gint32  image_id,
                                 lyr_chn[cidx]->columns,
                                 lyr_chn[cidx]->rows);
 
-              /* Only read channel data if there is any channel
-               * data. Note that the channel data can contain a
-               * compression method but no actual data.
+              /* Only locate the channel rows in the mapped file here,
+               * they are decoded band by band when the layer is drawn.
+               * Without a mapped file, the still compressed channel is
+               * read into memory first.
+               * Note that the channel data can contain a compression
+               * method but no actual data.
                */
-              if (lyr_a[lidx]->chn_info[cidx].data_len >= COMP_MODE_SIZE)
+              if (mapped_file)
                 {
-                  if (fread (&comp_mode, COMP_MODE_SIZE, 1, f) < 1)
+                  if (offset + lyr_a[lidx]->chn_info[cidx].data_len > file_len)
                     {
-                      psd_set_error (feof (f), errno, error);
-                      return -1;
+                      psd_set_error (TRUE, 0, error);
+                      goto layer_error;
                     }
-                  comp_mode = GUINT16_FROM_BE (comp_mode);
-                  IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
+                  if (setup_channel_rows (lyr_chn[cidx], img_a->bps,
+                                          file_data + offset,
+                                          lyr_a[lidx]->chn_info[cidx].data_len,
+                                          error) < 0)
+                    goto layer_error;
                 }
-              if (lyr_a[lidx]->chn_info[cidx].data_len > COMP_MODE_SIZE)
+              else
                 {
-                  switch (comp_mode)
+                  guint32 data_len = lyr_a[lidx]->chn_info[cidx].data_len;
+
+                  lyr_chn[cidx]->read_data = g_malloc (data_len);
+                  if (fseek (f, offset, SEEK_SET) < 0
+                      || (data_len > 0
+                          && fread (lyr_chn[cidx]->read_data,
+                                    data_len, 1, f) < 1))
                     {
-                      case PSD_COMP_RAW:        /* Planar raw data */
-                        IFDBG(3) g_debug ("Raw data length: %d",
-                                          lyr_a[lidx]->chn_info[cidx].data_len - 2);
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                            PSD_COMP_RAW, NULL, f, error) < 1)
-                          return -1;
-                        break;
-
-                      case PSD_COMP_RLE:        /* Packbits */
-                        IFDBG(3) g_debug ("RLE channel length %d, RLE length data: %d, "
-                                          "RLE data block: %d",
-                                          lyr_a[lidx]->chn_info[cidx].data_len - 2,
-                                          lyr_chn[cidx]->rows * 2,
-                                          (lyr_a[lidx]->chn_info[cidx].data_len - 2 -
-                                           lyr_chn[cidx]->rows * 2));
-                        rle_pack_len = g_malloc (lyr_chn[cidx]->rows * 2);
-                        for (rowi = 0; rowi < lyr_chn[cidx]->rows; ++rowi)
-                          {
-                            if (fread (&rle_pack_len[rowi], 2, 1, f) < 1)
-                              {
-                                psd_set_error (feof (f), errno, error);
-                                g_free (rle_pack_len);
-                                return -1;
-                              }
-                            rle_pack_len[rowi] = GUINT16_FROM_BE (rle_pack_len[rowi]);
-                          }
-
-                        IFDBG(3) g_debug ("RLE decode - data");
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                            PSD_COMP_RLE, rle_pack_len, f, error) < 1)
-                          return -1;
-
-                        g_free (rle_pack_len);
-                        break;
-
-                      case PSD_COMP_ZIP:                 /* ? */
-                      case PSD_COMP_ZIP_PRED:
-                      default:
-                        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                    _("Unsupported compression mode: %d"), comp_mode);
-                        return -1;
-                        break;
+                      psd_set_error (feof (f), errno, error);
+                      goto layer_error;
                     }
+                  if (setup_channel_rows (lyr_chn[cidx], img_a->bps,
+                                          lyr_chn[cidx]->read_data,
+                                          data_len, error) < 0)
+                    goto layer_error;
                 }
+
+              offset += lyr_a[lidx]->chn_info[cidx].data_len;
             }
           g_free (lyr_a[lidx]->chn_info);
 
@@ -1333,15 +1379,8 @@ add_layers (const gint32  image_id,
               IFDBG(3) g_debug ("Draw layer");
               image_type = get_gimp_image_type (img_a->base_type, alpha);
               IFDBG(3) g_debug ("Layer type %d", image_type);
-              layer_size = l_w * l_h;
-              pixels = g_malloc (layer_size * layer_channels);
               for (cidx = 0; cidx < layer_channels; ++cidx)
-                {
-                  IFDBG(3) g_debug ("Start channel %d", channel_idx[cidx]);
-                  for (i = 0; i < layer_size; ++i)
-                    pixels[(i * layer_channels) + cidx] = lyr_chn[channel_idx[cidx]]->data[i];
-                  g_free (lyr_chn[channel_idx[cidx]]->data);
-                }
+                layer_chn[cidx] = lyr_chn[channel_idx[cidx]];
 
               layer_mode = psd_to_gimp_blend_mode (lyr_a[lidx]->blend_mode);
               layer_id = gimp_layer_new (image_id, lyr_a[lidx]->name, l_w, l_h,
@@ -1353,16 +1392,13 @@ add_layers (const gint32  image_id,
               gimp_layer_set_offsets (layer_id, l_x, l_y);
               gimp_layer_set_lock_alpha  (layer_id, lyr_a[lidx]->layer_flags.trans_prot);
               drawable = gimp_drawable_get (layer_id);
-              gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0,
-                                   drawable->width, drawable->height, TRUE, FALSE);
-              gimp_pixel_rgn_set_rect (&pixel_rgn, pixels,
-                                       0, 0, drawable->width, drawable->height);
+              write_layer_bands (drawable, layer_chn, layer_channels,
+                                 img_a->bps, pool);
               gimp_item_set_visible (drawable->drawable_id, lyr_a[lidx]->layer_flags.visible);
               if (lyr_a[lidx]->id)
                 gimp_item_set_tattoo (drawable->drawable_id, lyr_a[lidx]->id);
               gimp_drawable_flush (drawable);
               gimp_drawable_detach (drawable);
-              g_free (pixels);
             }
 
           /* Layer mask */
@@ -1399,6 +1435,12 @@ add_layers (const gint32  image_id,
                   IFDBG(3) g_debug ("Mask channel index %d", user_mask_chn);
                   IFDBG(3) g_debug ("Relative pos %d",
                                     lyr_a[lidx]->layer_mask.mask_flags.relative_pos);
+                  lyr_chn[user_mask_chn]->data =
+                    g_malloc ((gsize) lyr_chn[user_mask_chn]->rows *
+                              lyr_chn[user_mask_chn]->columns);
+                  decode_channel_rows (lyr_chn[user_mask_chn], img_a->bps,
+                                       0, lyr_chn[user_mask_chn]->rows,
+                                       (guchar *) lyr_chn[user_mask_chn]->data, 1);
                   layer_size = lm_w * lm_h;
                   pixels = g_malloc (layer_size);
                   IFDBG(3) g_debug ("Allocate Pixels %d", layer_size);
@@ -1472,7 +1514,11 @@ add_layers (const gint32  image_id,
             }
           for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
             if (lyr_chn[cidx])
-              g_free (lyr_chn[cidx]);
+              {
+                g_free (lyr_chn[cidx]->row_offsets);
+                g_free (lyr_chn[cidx]->read_data);
+                g_free (lyr_chn[cidx]);
+              }
           g_free (lyr_chn);
         }
       g_free (lyr_a[lidx]);
@@ -1480,7 +1526,27 @@ add_layers (const gint32  image_id,
   g_free (lyr_a);
   g_array_free (parent_group_stack, FALSE);
 
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+
   return 0;
+
+  /* ----- Process layer errors ----- */
+ layer_error:
+  for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+    if (lyr_chn[cidx])
+      {
+        g_free (lyr_chn[cidx]->row_offsets);
+        g_free (lyr_chn[cidx]->read_data);
+        g_free (lyr_chn[cidx]);
+      }
+  g_free (lyr_chn);
+  g_array_free (parent_group_stack, TRUE);
+
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+  return -1;
 }
 
 static gint
@@ -1945,6 +2011,253 @@ read_channel_data (PSDchannel     *channel,
   return 1;
 }
 
+static gint
+setup_channel_rows (PSDchannel     *channel,
+                    const guint16   bps,
+                    const guchar   *data,
+                    guint32         data_len,
+                    GError        **error)
+{
+  guint32   readline_len;
+  guint64   row_offset;
+  gint      i;
+
+  channel->comp_mode = PSD_COMP_RAW;
+  channel->raw_data = NULL;
+  channel->row_offsets = NULL;
+
+  if (data_len >= COMP_MODE_SIZE)
+    {
+      channel->comp_mode = (data[0] << 8) | data[1];
+      IFDBG(3) g_debug ("Compression mode: %d", channel->comp_mode);
+    }
+
+  if (data_len <= COMP_MODE_SIZE)
+    return 0;
+
+  data += COMP_MODE_SIZE;
+  data_len -= COMP_MODE_SIZE;
+
+  if (bps == 1)
+    readline_len = ((channel->columns + 7) >> 3);
+  else
+    readline_len = (channel->columns * bps >> 3);
+
+  /* sanity check, int overflow check (avoid divisions by zero) */
+  if ((channel->rows == 0) || (channel->columns == 0) ||
+      (channel->rows > G_MAXINT32 / channel->columns / MAX (bps >> 3, 1)))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Unsupported or invalid channel size"));
+      return -1;
+    }
+
+  switch (channel->comp_mode)
+    {
+      case PSD_COMP_RAW:        /* Planar raw data */
+        IFDBG(3) g_debug ("Raw data length: %d", data_len);
+        if ((guint64) readline_len * channel->rows > data_len)
+          {
+            psd_set_error (TRUE, 0, error);
+            return -1;
+          }
+        break;
+
+      case PSD_COMP_RLE:        /* Packbits */
+        IFDBG(3) g_debug ("RLE channel length %d, RLE length data: %d",
+                          data_len, channel->rows * 2);
+        if ((guint64) channel->rows * 2 > data_len)
+          {
+            psd_set_error (TRUE, 0, error);
+            return -1;
+          }
+
+        /* Turn the packed row lengths into row offsets, and check each
+         * of them before it is stored
+         */
+        channel->row_offsets = g_new (guint32, channel->rows + 1);
+        row_offset = channel->rows * 2;
+        for (i = 0; i < channel->rows; ++i)
+          {
+            channel->row_offsets[i] = row_offset;
+            row_offset += (data[i * 2] << 8) | data[i * 2 + 1];
+
+            if (row_offset > data_len)
+              {
+                psd_set_error (TRUE, 0, error);
+                return -1;
+              }
+          }
+        channel->row_offsets[channel->rows] = row_offset;
+        break;
+
+      case PSD_COMP_ZIP:                 /* ? */
+      case PSD_COMP_ZIP_PRED:
+      default:
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                    _("Unsupported compression mode: %d"), channel->comp_mode);
+        return -1;
+        break;
+    }
+
+  channel->raw_data = data;
+
+  return 0;
+}
+
+static void
+decode_channel_rows (const PSDchannel *channel,
+                     const guint16     bps,
+                     gint32            first_row,
+                     gint32            n_rows,
+                     guchar           *dest,
+                     gint              dest_bpp)
+{
+/* Decode rows of a channel into every dest_bpp'th byte of dest,
+   converting them to 8 bit like read_channel_data()
+*/
+  gchar    *line;
+  guint32   readline_len;
+  gint32    rowi;
+  guint32   coli;
+
+  if (bps == 1)
+    readline_len = ((channel->columns + 7) >> 3);
+  else
+    readline_len = (channel->columns * bps >> 3);
+
+  line = g_malloc0 (readline_len);
+
+  for (rowi = first_row; rowi < first_row + n_rows; ++rowi)
+    {
+      const gchar *src = line;
+
+      if (! channel->raw_data)
+        {
+          /* Channel without data */
+        }
+      else if (channel->comp_mode == PSD_COMP_RLE)
+        {
+          /* FIXME check for errors returned from decode packbits */
+          decode_packbits ((const gchar *) channel->raw_data +
+                           channel->row_offsets[rowi],
+                           line,
+                           channel->row_offsets[rowi + 1] -
+                           channel->row_offsets[rowi],
+                           readline_len);
+        }
+      else
+        {
+          src = (const gchar *) channel->raw_data + (gsize) rowi * readline_len;
+        }
+
+      switch (bps)
+        {
+          case 16:
+            for (coli = 0; coli < channel->columns; ++coli)
+              dest[coli * dest_bpp] = src[coli * 2];
+            break;
+
+          case 8:
+            for (coli = 0; coli < channel->columns; ++coli)
+              dest[coli * dest_bpp] = src[coli];
+            break;
+
+          case 1:
+            for (coli = 0; coli < channel->columns; ++coli)
+              dest[coli * dest_bpp] = (src[coli >> 3] & (0x80 >> (coli & 7))) ? 0 : 1;
+            break;
+        }
+
+      dest += channel->columns * dest_bpp;
+    }
+
+  g_free (line);
+}
+
+static void
+decode_band (PSDband  *band,
+             gpointer  user_data)
+{
+  gint      cidx;
+
+  for (cidx = 0; cidx < band->n_channels; ++cidx)
+    decode_channel_rows (band->channels[cidx], band->bps,
+                         band->y, band->rows,
+                         band->pixels + cidx, band->n_channels);
+
+  g_mutex_lock (&band_mutex);
+  band->done = TRUE;
+  g_cond_broadcast (&band_cond);
+  g_mutex_unlock (&band_mutex);
+}
+
+static void
+write_layer_bands (GimpDrawable   *drawable,
+                   PSDchannel    **channels,
+                   gint            n_channels,
+                   const guint16   bps,
+                   GThreadPool    *pool)
+{
+/* Decode the layer in bands of tile rows, straight into the drawable's
+   tiles. With a thread pool, the following bands are decoded while
+   the current one is sent to the core, so at most one band per thread
+   plus one is in memory.
+*/
+  GimpPixelRgn  pixel_rgn;
+  GQueue       *bands = g_queue_new ();
+  gint          max_bands = 1;
+  gint32        y = 0;
+
+  if (pool)
+    max_bands = g_thread_pool_get_max_threads (pool) + 1;
+
+  gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0,
+                       drawable->width, drawable->height, TRUE, FALSE);
+
+  while (y < drawable->height || ! g_queue_is_empty (bands))
+    {
+      PSDband *band;
+
+      while (y < drawable->height && g_queue_get_length (bands) < max_bands)
+        {
+          band = g_slice_new0 (PSDband);
+          band->channels = channels;
+          band->n_channels = n_channels;
+          band->bps = bps;
+          band->y = y;
+          band->rows = MIN (gimp_tile_height (), drawable->height - y);
+          band->columns = drawable->width;
+          band->pixels = g_malloc ((gsize) band->columns * band->rows *
+                                   n_channels);
+
+          g_queue_push_tail (bands, band);
+
+          if (pool)
+            g_thread_pool_push (pool, band, NULL);
+          else
+            decode_band (band, NULL);
+
+          y += band->rows;
+        }
+
+      band = g_queue_pop_head (bands);
+
+      g_mutex_lock (&band_mutex);
+      while (! band->done)
+        g_cond_wait (&band_cond, &band_mutex);
+      g_mutex_unlock (&band_mutex);
+
+      gimp_pixel_rgn_set_rect (&pixel_rgn, band->pixels,
+                               0, band->y, band->columns, band->rows);
+
+      g_free (band->pixels);
+      g_slice_free (PSDband, band);
+    }
+
+  g_queue_free (bands);
+}
+
 static void
 convert_16_bit (const gchar *src,
                 gchar       *dst,
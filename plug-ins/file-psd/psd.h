@@ -501,6 +501,11 @@ typedef struct
   gchar        *data;                   /* Channel image data */
   guint32       rows;                   /* Channel rows */
   guint32       columns;                /* Channel columns */
+  guint16       comp_mode;              /* Compression mode */
+  const guchar *raw_data;               /* Channel rows in the mapped file */
+  guint32      *row_offsets;            /* RLE row offsets in raw_data */
+  guchar       *read_data;              /* Channel data read from the file
+                                           when it could not be mapped */
 } PSDchannel;
 
 /* PSD Channel data structure */